@@ -319,10 +319,16 @@ Calc::windowPreEventFilter(const DFBWindowEvent& event)
 
 } /* namespace ilixi */
 
-int
-main(int argc, char* argv[])
+extern "C" int
+ilixi_main(int argc, char* argv[])
 {
     ilixi::Calc app(argc, argv);
     app.exec();
     return 0;
 }
+
+int
+main(int argc, char* argv[])
+{
+    return ilixi_main(argc, argv);
+}
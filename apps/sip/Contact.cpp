@@ -125,7 +125,8 @@ Contact::pointerButtonUpEvent(const PointerEvent& event)
 {
     if (_pressed)
     {
-        PlatformManager::instance().playSoundEffect("Click");
+        static const int __clickEffect = PlatformManager::instance().soundEffectID("Click");
+        PlatformManager::instance().playSoundEffect(__clickEffect);
         _pressed = false;
         update();
         sigClicked();
@@ -328,11 +328,17 @@ WidgetsDemo::print(const std::string& text)
     printf("%s\n", text.c_str());
 }
 
-int
-main(int argc, char* argv[])
+extern "C" int
+ilixi_main(int argc, char* argv[])
 {
     WidgetsDemo app(argc, argv);
     app.exec();
     return 0;
 }
 
+int
+main(int argc, char* argv[])
+{
+    return ilixi_main(argc, argv);
+}
+
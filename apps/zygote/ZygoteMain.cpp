@@ -0,0 +1,248 @@
+/*
+ Copyright 2010-2015 Tarik Sekmen.
+
+ All Rights Reserved.
+
+ Written by Tarik Sekmen <tarik@ilixi.org>.
+
+ This file is part of ilixi.
+
+ ilixi is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ ilixi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <compositor/Zygote.h>
+#include <lib/FileSystem.h>
+#include <lib/XMLReader.h>
+#include <ilixiConfig.h>
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fontconfig/fontconfig.h>
+#include <libgen.h>
+#include <libxml/parser.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+using namespace ilixi;
+
+typedef int (*MainFunc)(int argc, char* argv[]);
+
+//! Reads file into page cache.
+static void
+preloadFile(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    close(fd);
+}
+
+//! Returns content of first child element with given name.
+static std::string
+childContent(xmlNodePtr node, const char* name)
+{
+    std::string content;
+    for (xmlNodePtr child = node->children; child; child = child->next)
+    {
+        if (xmlStrcmp(child->name, (xmlChar*) name) == 0)
+        {
+            xmlChar* data = xmlNodeGetContent(child);
+            content = (char*) data;
+            xmlFree(data);
+            break;
+        }
+    }
+    return content;
+}
+
+//! Matches fonts of a font pack using fontconfig, so applications find them in inherited cache.
+static void
+preloadFonts(const std::string& file)
+{
+    XMLReader xml;
+    if (!xml.loadFile(file))
+        return;
+
+    for (xmlNodePtr node = xml.currentNode(); node; node = node->next)
+    {
+        std::string name = childContent(node, "Name");
+        if (name.empty())
+            continue;
+        std::string style = childContent(node, "FontStyle");
+
+        FcPattern* pat = FcPatternCreate();
+        FcPatternAddString(pat, FC_FAMILY, (const FcChar8*) name.c_str());
+        if (!style.empty())
+            FcPatternAddString(pat, FC_STYLE, (const FcChar8*) style.c_str());
+        FcConfigSubstitute(NULL, pat, FcMatchPattern);
+        FcDefaultSubstitute(pat);
+
+        FcResult result;
+        FcPattern* match = FcFontMatch(NULL, pat, &result);
+        FcChar8* fontFile;
+        if (match && FcPatternGetString(match, FC_FILE, 0, &fontFile) == FcResultMatch)
+            preloadFile((char*) fontFile);
+        if (match)
+            FcPatternDestroy(match);
+        FcPatternDestroy(pat);
+    }
+}
+
+//! Parses theme files listed in platform configuration and preloads its fonts and images.
+/*!
+ * Applications parse these files again, but DTDs, catalog and fontconfig are already loaded and
+ * files are in page cache.
+ */
+static void
+preloadTheme()
+{
+    XMLReader config;
+    if (!config.loadFile(ILIXI_DATADIR"ilixi_config.xml"))
+        return;
+
+    for (xmlNodePtr group = config.currentNode(); group; group = group->next)
+    {
+        if (xmlStrcmp(group->name, (xmlChar*) "Theme") != 0)
+            continue;
+
+        xmlChar* directory = xmlGetProp(group, (xmlChar*) "directory");
+        if (!directory)
+            continue;
+        std::string themedir = (char*) directory;
+        xmlFree(directory);
+        size_t found = themedir.find("@ILX_THEMEDIR:");
+        if (found != std::string::npos)
+        {
+            char* var = getenv("ILX_THEMEDIR");
+            themedir = (var ? var : ILIXI_DATADIR"themes/") + themedir.substr(found + 14);
+        }
+
+        for (xmlNodePtr node = group->children; node; node = node->next)
+        {
+            xmlChar* data = xmlNodeGetContent(node);
+            std::string file = themedir + (char*) data;
+            xmlFree(data);
+
+            if (xmlStrcmp(node->name, (xmlChar*) "FontPack") == 0)
+                preloadFonts(file);
+            else if (xmlStrcmp(node->name, (xmlChar*) "Style") == 0 || xmlStrcmp(node->name, (xmlChar*) "Palette") == 0 || xmlStrcmp(node->name, (xmlChar*) "IconPack") == 0)
+            {
+                // Loads DTDs and catalog entries used by applications.
+                XMLReader xml(file);
+            }
+        }
+
+        // Images of theme, e.g. ui-pack.dfiff.
+        std::vector<std::string> entries = FileSystem::listDirectory(themedir);
+        for (std::vector<std::string>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+            if ((*it)[0] != '.')
+                preloadFile(themedir + *it);
+    }
+}
+
+//! Runs inside forked process; loads application module and calls its entry point or executes application.
+/*!
+ * Module of an application is ILIXI_ZYGOTEDIR/<executable name>.so, which exports ILIXI_ZYGOTE_MAIN.
+ */
+static void
+runApplication(int fd, char* request, ssize_t length)
+{
+    close(fd);
+    setsid();
+    signal(SIGCHLD, SIG_DFL);
+
+    std::vector<char*> args;
+    for (char* p = request; p < request + length; p += strlen(p) + 1)
+        args.push_back(p);
+    int argc = args.size();
+    args.push_back(NULL);
+
+    std::string path = args[0];
+    std::string module = std::string(ILIXI_ZYGOTEDIR) + basename(&path[0]) + ".so";
+    void* handle = dlopen(module.c_str(), RTLD_NOW | RTLD_GLOBAL);
+    if (handle)
+    {
+        MainFunc func = (MainFunc) dlsym(handle, ILIXI_ZYGOTE_MAIN);
+        if (func)
+            exit(func(argc, &args[0]));
+        dlclose(handle);
+    } else
+        fprintf(stderr, "ilixi_zygote: %s\n", dlerror());
+
+    execvp(args[0], &args[0]);
+    perror("execvp");
+    _exit(1);
+}
+
+int
+main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <socket>\n", argv[0]);
+        return 1;
+    }
+    int fd = atoi(argv[1]);
+
+    // Intermediate processes exit right away, let kernel reap them.
+    signal(SIGCHLD, SIG_IGN);
+
+    // Warm up libraries so forked applications do not pay for it.
+    setenv("XML_CATALOG_FILES", ILIXI_DATADIR"ilixi_catalog.xml", 0);
+    xmlInitParser();
+    FcInit();
+    preloadTheme();
+
+    char request[ILIXI_ZYGOTE_REQUEST_SIZE + 1];
+    while (true)
+    {
+        ssize_t length = recv(fd, request, ILIXI_ZYGOTE_REQUEST_SIZE, 0);
+        if (length == 0)
+            break;
+        else if (length < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            perror("recv");
+            break;
+        }
+        request[length] = 0;
+
+        // Fork twice so application is reparented to compositor (child subreaper) and not to launcher.
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            pid_t app = fork();
+            if (app == 0)
+                runApplication(fd, request, length);
+            send(fd, &app, sizeof(app), MSG_NOSIGNAL);
+            _exit(0);
+        } else if (pid == -1)
+        {
+            send(fd, &pid, sizeof(pid), MSG_NOSIGNAL);
+        }
+    }
+
+    FcFini();
+    xmlCleanupParser();
+    return 0;
+}
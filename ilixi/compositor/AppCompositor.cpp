@@ -133,6 +133,27 @@ AppCompositor::setWindowFocus()
     }
 }
 
+bool
+AppCompositor::covers(const Rectangle& rect) const
+{
+    return opaqueView(rect) != NULL;
+}
+
+SurfaceView*
+AppCompositor::opaqueView(const Rectangle& rect) const
+{
+    if (!visible() || _cState != APPCOMP_READY || opacity() != 255)
+        return NULL;
+
+    for (WidgetListConstIterator it = _children.begin(); it != _children.end(); ++it)
+    {
+        SurfaceView* view = dynamic_cast<SurfaceView*>(*it);
+        if (view && view->visible() && view->opacity() == 255 && !view->isBlendingEnabled() && view->frameGeometry().contains(rect, true))
+            return view;
+    }
+    return NULL;
+}
+
 void
 AppCompositor::compose(const PaintEvent& event)
 {
@@ -59,6 +59,18 @@ public:
     void
     setWindowFocus();
 
+    /*!
+     * Returns true if an opaque window of this application fully covers given rectangle.
+     */
+    bool
+    covers(const Rectangle& rect) const;
+
+    /*!
+     * Returns the opaque window view which fully covers given rectangle, otherwise returns NULL.
+     */
+    SurfaceView*
+    opaqueView(const Rectangle& rect) const;
+
 protected:
     enum AppCompState
     {
@@ -45,7 +45,8 @@ AppInfo::AppInfo()
           _category("default"),
           _version(0),
           _appFlags(APP_NONE),
-          _depFlags(DEP_NONE)
+          _depFlags(DEP_NONE),
+          _priority(0)
 {
 }
 
@@ -89,6 +90,18 @@ AppInfo::depFlags() const
     return _depFlags;
 }
 
+const std::list<std::string>&
+AppInfo::startAfter() const
+{
+    return _startAfter;
+}
+
+int
+AppInfo::priority() const
+{
+    return _priority;
+}
+
 std::string
 AppInfo::icon() const
 {
@@ -155,6 +168,8 @@ AppInfo::setAppFlags(const std::string& appFlags)
             _appFlags = (AppFlags) (_appFlags | APP_USE_BACK);
         else if (strcmp(pch, "APP_VIS_NOTIFY") == 0)
             _appFlags = (AppFlags) (_appFlags | APP_VIS_NOTIFY);
+        else if (strcmp(pch, "APP_ZYGOTE") == 0)
+            _appFlags = (AppFlags) (_appFlags | APP_ZYGOTE);
         else if (strcmp(pch, "APP_STATUSBAR") == 0)
             _appFlags = (AppFlags) (_appFlags | APP_STATUSBAR | APP_SYSTEM);
         else if (strcmp(pch, "APP_OSK") == 0)
@@ -212,6 +227,35 @@ AppInfo::setDepFlags(const std::string& depFlags)
     ILOG_DEBUG(ILX_APPINFO, " _depFlags: %x\n", _depFlags);
 }
 
+void
+AppInfo::setStartAfter(const std::string& startAfter)
+{
+    ILOG_DEBUG(ILX_APPINFO, "setStartAfter( %s )\n", startAfter.c_str());
+    _startAfter.clear();
+    char* pch = strtok(const_cast<char*>(startAfter.c_str()), " ,");
+    while (pch != NULL)
+    {
+        _startAfter.push_back(pch);
+        pch = strtok(NULL, " ,");
+    }
+}
+
+void
+AppInfo::setPriority(int priority)
+{
+    _priority = priority;
+}
+
+void
+AppInfo::setPriority(const std::string& priority)
+{
+    if (priority.empty())
+        return;
+
+    ILOG_DEBUG(ILX_APPINFO, "setPriority( %s )\n", priority.c_str());
+    _priority = atoi(priority.c_str());
+}
+
 void
 AppInfo::setIcon(const std::string& icon)
 {
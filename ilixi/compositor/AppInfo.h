@@ -24,6 +24,7 @@
 #ifndef ILIXI_APPINFO_H_
 #define ILIXI_APPINFO_H_
 
+#include <list>
 #include <string>
 #include <sys/time.h>
 
@@ -48,6 +49,7 @@ enum AppFlags
     APP_AUTO_START = 0x000800,          //!< Starts application when compositor is initialised.
     APP_USE_BACK = 0x001000,            //!< Application can use a Back button.
     APP_VIS_NOTIFY = 0x002000,          //!< Application requires a visibility feedback from compositor.
+    APP_ZYGOTE = 0x004000,              //!< Application is forked from a pre-initialised launcher process (Zygote).
     APP_STATUSBAR = 0x010000,           //!< Statusbar application.
     APP_OSK = 0x020000,                 //!< OSK application.
     APP_HOME = 0x040000,                //!< Home application.
@@ -117,6 +119,18 @@ public:
     DependencyFlags
     depFlags() const;
 
+    /*!
+     * Returns names of applications which must be ready before this application is started at boot.
+     */
+    const std::list<std::string>&
+    startAfter() const;
+
+    /*!
+     * Returns boot priority, applications with higher priority are started first.
+     */
+    int
+    priority() const;
+
     /*!
      * Returns path to application icon.
      */
@@ -183,6 +197,24 @@ public:
     void
     setDepFlags(const std::string& depFlags);
 
+    /*!
+     * Set boot dependencies using a comma separated list of application names.
+     */
+    void
+    setStartAfter(const std::string& startAfter);
+
+    /*!
+     * Set boot priority.
+     */
+    void
+    setPriority(int priority);
+
+    /*!
+     * Set boot priority.
+     */
+    void
+    setPriority(const std::string& priority);
+
     /*!
      * Set path to application icon.
      */
@@ -248,6 +280,10 @@ private:
     AppFlags _appFlags;
     //! This property stores dependency flags.
     DependencyFlags _depFlags;
+    //! This property stores names of applications to wait for at boot.
+    std::list<std::string> _startAfter;
+    //! This property stores boot priority.
+    int _priority;
 
     //! Counter is incremented for each AppInfo.
     static unsigned int __appCounter;
@@ -32,6 +32,7 @@ AppInstance::AppInstance()
         : _instanceID(_instanceCounter++),
           _appInfo(NULL),
           _started(0),
+          _ready(0),
           _pid(0),
           _process(NULL),
           _view(NULL),
@@ -115,6 +116,12 @@ AppInstance::started() const
     return _started;
 }
 
+long long
+AppInstance::ready() const
+{
+    return _ready;
+}
+
 AppThumbnail*
 AppInstance::thumb() const
 {
@@ -157,6 +164,12 @@ AppInstance::setStarted(long long started)
     _started = started;
 }
 
+void
+AppInstance::setReady(long long ready)
+{
+    _ready = ready;
+}
+
 void
 AppInstance::setThumb(AppThumbnail* thumb)
 {
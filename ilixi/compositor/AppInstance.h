@@ -107,6 +107,12 @@ public:
     long long
     started() const;
 
+    /*!
+     * Returns milliseconds from application start until its first window is added, or 0 if not ready yet.
+     */
+    long long
+    ready() const;
+
     /*!
      * Returns pointer to thumbnail if any.
      */
@@ -149,6 +155,12 @@ public:
     void
     setStarted(long long started);
 
+    /*!
+     * Set milliseconds elapsed until first window is added.
+     */
+    void
+    setReady(long long ready);
+
     /*!
      * Set an application thumbnail widget for this instance.
      */
@@ -170,6 +182,8 @@ private:
     AppInfo* _appInfo;
     //! This properts stores milliseconds since application has started.
     long long _started;
+    //! This property stores milliseconds elapsed from start until first window.
+    long long _ready;
     //! This property stores process ID.
     pid_t _pid;
     //! This property stores SaWMan process handle.
@@ -275,6 +275,19 @@ AppView::slideTo(int tx, int ty)
     }
 }
 
+void
+AppView::paint(const PaintEvent& event)
+{
+#ifndef ILIXI_STEREO_OUTPUT
+    if (_compositor->occluded(this, event.rect))
+    {
+        ILOG_DEBUG(ILX_APPVIEW, " -> %s is occluded\n", _instance->appInfo()->name().c_str());
+        return;
+    }
+#endif
+    AppCompositor::paint(event);
+}
+
 void
 AppView::tweenSlot()
 {
@@ -305,6 +318,7 @@ AppView::tweenEndSlot()
         setVisible(false);
     clearAnimatedProperty(AnimShowing);
     clearAnimatedProperty(AnimHiding);
+    _compositor->updateScanout();
 }
 
 void
@@ -88,6 +88,12 @@ public:
     void
     slideTo(int x, int y);
 
+    /*!
+     * Skips painting if view is hidden by opaque views above it.
+     */
+    virtual void
+    paint(const PaintEvent& event);
+
 protected:
     //! Sets given flag.
     void
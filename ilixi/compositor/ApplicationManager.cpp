@@ -23,11 +23,17 @@
 
 #include <compositor/ApplicationManager.h>
 #include <compositor/Compositor.h>
+#include <compositor/Zygote.h>
+#include <core/Engine.h>
 #include <core/Logger.h>
 #include <lib/FileSystem.h>
 #include <lib/Notify.h>
+#include <lib/Timer.h>
 #include <lib/XMLReader.h>
 
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <string.h>
 #include <signal.h>
 #include <stdexcept>
@@ -59,38 +65,44 @@ app_sort(AppInfo* app1, AppInfo* app2)
         return false;
 }
 
-//*********************************************************************
-static ApplicationManager* __appMan = NULL;
+bool
+boot_sort(AppInfo* app1, AppInfo* app2)
+{
+    return app1->priority() > app2->priority();
+}
 
-void
-sigchild_handler(int sig, siginfo_t *siginfo, void *context)
+template<typename Map>
+static AppInstance*
+findIndex(const Map& map, const typename Map::key_type& key)
 {
-    ILOG_TRACE_F(ILX_APPLICATIONMANAGER);
-    ILOG_DEBUG(ILX_APPLICATIONMANAGER, " -> si_code: %d\n", siginfo->si_code);
-    if (__appMan != NULL)
-    {
-        if (siginfo->si_code == CLD_DUMPED || siginfo->si_code == CLD_KILLED)
-        {
-            AppInstance* instance = __appMan->instanceByPID(siginfo->si_pid);
-            ILOG_DEBUG(ILX_APPLICATIONMANAGER, " -> pid: %d instance: %p (CLD_KILLED || CLD_DUMPED)\n", siginfo->si_pid, instance);
-            if (!instance)
-                return;
+    typename Map::const_iterator it = map.find(key);
+    if (it != map.end())
+        return it->second;
+    return NULL;
+}
 
-            if (instance->view())
-                return;
+//! Milliseconds to wait for a startup application before its dependants are started.
+static const unsigned int __bootTimeout = 3000;
 
-            __appMan->processTerminated(instance);
-        } else if (siginfo->si_code == CLD_EXITED)
-        {
-            AppInstance* instance = __appMan->instanceByPID(siginfo->si_pid);
-            ILOG_DEBUG(ILX_APPLICATIONMANAGER, " -> pid: %d instance: %p (CLD_EXITED)\n", siginfo->si_pid, instance);
+//*********************************************************************
+//! Child status changes are passed from signal handler to ChildThread using this pipe.
+static int __childPipe[2] = { -1, -1 };
 
-            if (!instance)
-                return;
+void
+sigchild_handler(int sig, siginfo_t *siginfo, void *context)
+{
+    // Only async-signal-safe calls are allowed here, events are handled on main loop.
+    if (sig != SIGCHLD || __childPipe[1] < 0)
+        return;
 
-            __appMan->processRemoved(instance);
-        }
-    }
+    int err = errno;
+    ApplicationManager::ChildEvent event;
+    event.pid = siginfo->si_pid;
+    event.code = siginfo->si_code;
+    // Event is lost only if pipe is full.
+    ssize_t ret = write(__childPipe[1], &event, sizeof(event));
+    (void) ret;
+    errno = err;
 }
 
 DirectResult
@@ -152,14 +164,75 @@ window_restack(void *context, SaWManWindowHandle handle, SaWManWindowHandle rela
 
 //*********************************************************************
 
+ApplicationManager::ChildThread::ChildThread(ApplicationManager* manager)
+        : Thread(),
+          _manager(manager)
+{
+}
+
+ApplicationManager::ChildThread::~ChildThread()
+{
+    cancel();
+}
+
+int
+ApplicationManager::ChildThread::run()
+{
+    struct pollfd pfd;
+    pfd.fd = __childPipe[0];
+    pfd.events = POLLIN;
+
+    while (true)
+    {
+        if (poll(&pfd, 1, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            ILOG_ERROR(ILX_APPLICATIONMANAGER, "poll() failed: %s\n", strerror(errno));
+            return 1;
+        }
+
+        // Read outside lock, read() is a cancellation point.
+        ChildEvent events[16];
+        ssize_t len = read(__childPipe[0], events, sizeof(events));
+        if (len < (ssize_t) sizeof(ChildEvent))
+            continue;
+
+        pthread_mutex_lock(&_manager->_mutex);
+        bool wake = _manager->_childEvents.empty();
+        _manager->_childEvents.insert(_manager->_childEvents.end(), events, events + len / sizeof(ChildEvent));
+        pthread_mutex_unlock(&_manager->_mutex);
+
+        // Compositor handles events in main thread, see ApplicationManager::handleChildEvents().
+        if (wake)
+            Engine::instance().postUserEvent(ILXCompositor::CET_Child);
+    }
+    return 0;
+}
+
+//*********************************************************************
+
 ApplicationManager::ApplicationManager(ILXCompositor* compositor)
         : _compositor(compositor),
-          _monitor(NULL)
+          _monitor(NULL),
+          _zygote(NULL),
+          _childThread(NULL),
+          _bootStarted(0),
+          _bootTimer(NULL)
 {
     ILOG_TRACE_F(ILX_APPLICATIONMANAGER);
     pthread_mutex_init(&_mutex, NULL);
 
-    __appMan = this;
+    if (pipe(__childPipe) == -1)
+        ILOG_THROW(ILX_APPLICATIONMANAGER, "Unable to create pipe for signal handler!\n");
+    for (int i = 0; i < 2; ++i)
+    {
+        fcntl(__childPipe[i], F_SETFD, FD_CLOEXEC);
+        fcntl(__childPipe[i], F_SETFL, O_NONBLOCK);
+    }
+    _childThread = new ChildThread(this);
+    if (!_childThread->start())
+        ILOG_THROW(ILX_APPLICATIONMANAGER, "Unable to start thread for signal handler!\n");
 
     memset(&_act, 0, sizeof(_act));
     _act.sa_sigaction = &sigchild_handler;
@@ -227,9 +300,16 @@ ApplicationManager::~ApplicationManager()
 {
     ILOG_TRACE_F(ILX_APPLICATIONMANAGER);
     delete _monitor;
-    __appMan = NULL;
+    delete _zygote;
+    delete _bootTimer;
     stopAll();
 
+    delete _childThread;
+    int fds[2] = { __childPipe[0], __childPipe[1] };
+    __childPipe[0] = __childPipe[1] = -1;
+    close(fds[0]);
+    close(fds[1]);
+
     if (_manager)
         _manager->Release(_manager);
 
@@ -289,45 +369,91 @@ ApplicationManager::infoByPID(const pid_t pid)
 AppInstance*
 ApplicationManager::instanceByAppID(unsigned long appID)
 {
-    for (AppInstanceList::iterator it = _instances.begin(); it != _instances.end(); ++it)
-    {
-        if (((AppInstance*) (*it))->appID() == appID)
-            return ((AppInstance*) (*it));
-    }
-    return NULL;
+    pthread_mutex_lock(&_mutex);
+    AppInstance* instance = findIndex(_appIndex, appID);
+    pthread_mutex_unlock(&_mutex);
+    return instance;
 }
 
 AppInstance*
 ApplicationManager::instanceByInstanceID(unsigned int instanceID)
 {
-    for (AppInstanceList::iterator it = _instances.begin(); it != _instances.end(); ++it)
-    {
-        if (((AppInstance*) (*it))->instanceID() == instanceID)
-            return ((AppInstance*) (*it));
-    }
-    return NULL;
+    pthread_mutex_lock(&_mutex);
+    AppInstance* instance = findIndex(_instanceIndex, instanceID);
+    pthread_mutex_unlock(&_mutex);
+    return instance;
 }
 
 AppInstance*
 ApplicationManager::instanceByPID(const pid_t pid)
 {
-    pid_t p = pid;
-    do
+    pthread_mutex_lock(&_mutex);
+    AppInstance* instance = findIndex(_pidIndex, pid);
+    if (!instance)
+        instance = findIndex(_pidCache, pid);
+    pthread_mutex_unlock(&_mutex);
+    if (instance)
+        return instance;
+
+    // Walk process tree once, result is cached until owning instance is removed.
+    pid_t p = getParentPID(pid);
+    while (p > 0)
     {
-        for (AppInstanceList::iterator it = _instances.begin(); it != _instances.end(); ++it)
+        pthread_mutex_lock(&_mutex);
+        instance = findIndex(_pidIndex, p);
+        if (!instance)
+            instance = findIndex(_pidCache, p);
+        if (instance)
         {
-            if (((AppInstance*) (*it))->pid() == p)
-                return ((AppInstance*) (*it));
+            _pidCache[pid] = instance;
+            ILOG_DEBUG(ILX_APPLICATIONMANAGER, " -> pid %d belongs to %s[%d]\n", pid, instance->appInfo()->name().c_str(), instance->pid());
         }
+        pthread_mutex_unlock(&_mutex);
+
+        if (instance)
+            return instance;
 
         p = getParentPID(p);
+    }
 
-        if (p == -1)
-            return NULL;
+    return NULL;
+}
 
-    } while (p != 0);
+void
+ApplicationManager::handleChildEvents()
+{
+    ChildEventList events;
+    pthread_mutex_lock(&_mutex);
+    events.swap(_childEvents);
+    pthread_mutex_unlock(&_mutex);
 
-    return NULL;
+    for (ChildEventList::const_iterator it = events.begin(); it != events.end(); ++it)
+    {
+        const ChildEvent& event = *it;
+        ILOG_DEBUG(ILX_APPLICATIONMANAGER, " -> si_code: %d\n", event.code);
+        if (event.code == CLD_DUMPED || event.code == CLD_KILLED)
+        {
+            AppInstance* instance = instanceByPID(event.pid);
+            ILOG_DEBUG(ILX_APPLICATIONMANAGER, " -> pid: %d instance: %p (CLD_KILLED || CLD_DUMPED)\n", event.pid, instance);
+            if (instance && !instance->view())
+                processTerminated(instance);
+        } else if (event.code == CLD_EXITED)
+        {
+            AppInstance* instance = instanceByPID(event.pid);
+            ILOG_DEBUG(ILX_APPLICATIONMANAGER, " -> pid: %d instance: %p (CLD_EXITED)\n", event.pid, instance);
+            if (instance)
+                processRemoved(instance);
+        }
+    }
+}
+
+AppInstance*
+ApplicationManager::instanceByWindow(SaWManWindowHandle handle)
+{
+    pthread_mutex_lock(&_mutex);
+    AppInstance* instance = findIndex(_windowIndex, handle);
+    pthread_mutex_unlock(&_mutex);
+    return instance;
 }
 
 pid_t
@@ -345,9 +471,9 @@ ApplicationManager::getParentPID(const pid_t pid)
 
     if (!f)
     {
-        ILOG_ERROR(ILX_APPLICATIONMANAGER, "Failed to open '%s' (%s)!\n", stat.c_str(), strerror(errno));
-        ILOG_THROW(ILX_APPLICATIONMANAGER, "Unable to read parent PID!\n");
-        return 0;
+        // Process may exit before its stat is read.
+        ILOG_DEBUG(ILX_APPLICATIONMANAGER, "Failed to open '%s' (%s)!\n", stat.c_str(), strerror(errno));
+        return -1;
     }
 
     pid_t p;
@@ -363,7 +489,7 @@ ApplicationManager::getParentPID(const pid_t pid)
         {
             ILOG_ERROR(ILX_APPLICATIONMANAGER, "Failed to parse PID from '%s'!\n", stat.c_str());
             fclose(f);
-            ILOG_THROW(ILX_APPLICATIONMANAGER, "Unable to read parent PID!\n");
+            return -1;
         }
     }
 
@@ -375,7 +501,7 @@ ApplicationManager::getParentPID(const pid_t pid)
     {
         ILOG_ERROR(ILX_APPLICATIONMANAGER, "Failed to parse PID from '%s'!\n", stat.c_str());
         fclose(f);
-        ILOG_THROW(ILX_APPLICATIONMANAGER, "Unable to read parent PID!\n");
+        return -1;
     }
 
     fclose(f);
@@ -404,8 +530,6 @@ ApplicationManager::startApplication(const std::string& name, bool showInstance)
     if (!appInfo)
         return DR_ITEMNOTFOUND;
 
-    pid_t pid;
-
     AppInstance* instance = instanceByAppID(appInfo->appID());
 
     if (instance && !(appInfo->appFlags() & APP_ALLOW_MULTIPLE) && !waitpid(instance->pid(), NULL, WNOHANG))
@@ -416,17 +540,37 @@ ApplicationManager::startApplication(const std::string& name, bool showInstance)
         return DR_BUSY;
     }
 
+    if ((appInfo->appFlags() & APP_ZYGOTE) && _zygote)
+    {
+        // Instance is added when launcher replies, see zygoteLaunched().
+        if (_zygote->pending(appInfo) && !(appInfo->appFlags() & APP_ALLOW_MULTIPLE))
+            return DR_BUSY;
+        if (_zygote->launch(appInfo))
+            return DR_OK;
+        ILOG_WARNING(ILX_APPLICATIONMANAGER, "Zygote could not launch %s, using vfork.\n", name.c_str());
+    }
+
+    pid_t pid = forkApplication(appInfo);
+    if (pid == -1)
+        return DR_FAILURE;
+    addInstance(appInfo, pid);
+    return DR_OK;
+}
+
+pid_t
+ApplicationManager::forkApplication(AppInfo* appInfo)
+{
     char str[256];
     int arC = 1;
     char *p;
     int i = 0;
-    pid = vfork();
+    pid_t pid = vfork();
     switch (pid)
     {
     case -1:
         ILOG_ERROR(ILX_APPLICATIONMANAGER, " -> Error vfork!");
         perror("vfork");
-        return DR_FAILURE;
+        return -1;
 
     case 0:
         setsid();
@@ -471,17 +615,22 @@ ApplicationManager::startApplication(const std::string& name, bool showInstance)
         break;
 
     default:
-        pthread_mutex_lock(&_mutex);
-        instance = new AppInstance();
-        instance->setAppInfo(appInfo);
-        instance->setStarted(direct_clock_get_millis());
-        instance->setPid(pid);
-        _instances.push_back(instance);
-        pthread_mutex_unlock(&_mutex);
-        _compositor->_compComp->signalAppStart(instance);
         break;
     }
-    return DR_OK;
+    return pid;
+}
+
+void
+ApplicationManager::zygoteLaunched(AppInfo* appInfo, pid_t pid)
+{
+    if (pid <= 0)
+    {
+        ILOG_WARNING(ILX_APPLICATIONMANAGER, "Zygote could not launch %s, using vfork.\n", appInfo->name().c_str());
+        pid = forkApplication(appInfo);
+        if (pid == -1)
+            return;
+    }
+    addInstance(appInfo, pid);
 }
 
 DirectResult
@@ -494,15 +643,7 @@ ApplicationManager::stopApplication(pid_t pid)
     {
         pthread_mutex_lock(&_mutex);
         kill(instance->pid(), SIGKILL);
-        for (AppInstanceList::iterator it = _instances.begin(); it != _instances.end(); ++it)
-        {
-            if (((AppInstance*) *it)->pid() == pid)
-            {
-                _instances.erase(it);
-                break;
-            }
-        }
-
+        removeInstance(instance);
         delete instance;
         ILOG_DEBUG(ILX_APPLICATIONMANAGER, " -> Application is killed and instance is removed.\n");
         pthread_mutex_unlock(&_mutex);
@@ -529,6 +670,11 @@ ApplicationManager::stopAll()
         delete instance;
         _instances.pop_front();
     }
+    _pidIndex.clear();
+    _pidCache.clear();
+    _appIndex.clear();
+    _instanceIndex.clear();
+    _windowIndex.clear();
     pthread_mutex_unlock(&_mutex);
 }
 
@@ -537,18 +683,75 @@ ApplicationManager::initStartup()
 {
     ILOG_TRACE_F(ILX_APPLICATIONMANAGER);
     parseFolder(ILIXI_DATADIR"apps");
-    usleep(10000);
-    startApplication("StatusBar");
     for (AppInfoList::iterator it = _infos.begin(); it != _infos.end(); ++it)
     {
-        if (((AppInfo*) (*it))->appFlags() & APP_AUTO_START)
+        if (((AppInfo*) (*it))->appFlags() & APP_ZYGOTE)
         {
-            usleep(10000);
-            startApplication(((AppInfo*) (*it))->name(), false);
+            _zygote = new Zygote();
+            _zygote->sigLaunched.connect(sigc::mem_fun(this, &ApplicationManager::zygoteLaunched));
+            if (!_zygote->start())
+            {
+                delete _zygote;
+                _zygote = NULL;
+            }
+            break;
         }
     }
-    usleep(500000);
-    startApplication("Home");
+
+    AppInfoList boot;
+    AppInfo* home = infoByName("Home");
+    AppInfo* statusBar = infoByName("StatusBar");
+    if (statusBar)
+        boot.push_back(statusBar);
+    for (AppInfoList::iterator it = _infos.begin(); it != _infos.end(); ++it)
+    {
+        if ((((AppInfo*) (*it))->appFlags() & APP_AUTO_START) && *it != statusBar && *it != home)
+            boot.push_back(*it);
+    }
+    boot.sort(boot_sort);
+    if (home)
+        boot.push_back(home);
+
+    for (AppInfoList::iterator it = boot.begin(); it != boot.end(); ++it)
+    {
+        BootItem item;
+        item.info = *it;
+        item.state = BootWaiting;
+        item.launched = 0;
+        _boot.push_back(item);
+    }
+
+    _bootStarted = direct_clock_get_millis();
+    _bootTimer = new Timer();
+    _bootTimer->sigExec.connect(sigc::mem_fun(this, &ApplicationManager::bootTimeout));
+    _bootTimer->start(__bootTimeout / 4);
+    runBoot();
+}
+
+void
+ApplicationManager::instanceReady(AppInstance* instance)
+{
+    if (instance->ready())
+        return;
+
+    instance->setReady(direct_clock_get_millis() - instance->started());
+    ILOG_INFO(ILX_APPLICATIONMANAGER, "%s is ready in %lld ms.\n", instance->appInfo()->name().c_str(), instance->ready());
+
+    for (BootList::iterator it = _boot.begin(); it != _boot.end(); ++it)
+    {
+        if (it->info == instance->appInfo() && it->state == BootLaunched)
+        {
+            it->state = BootReady;
+            runBoot();
+            break;
+        }
+    }
+}
+
+MemoryMonitor*
+ApplicationManager::memoryMonitor() const
+{
+    return _monitor;
 }
 
 void
@@ -588,17 +791,8 @@ ApplicationManager::processRemoved(AppInstance* instance)
 {
     ILOG_TRACE_F(ILX_APPLICATIONMANAGER);
     _compositor->processRemoved(instance);
-    AppInstance* ins;
     pthread_mutex_lock(&_mutex);
-    for (AppInstanceList::iterator it = _instances.begin(); it != _instances.end(); ++it)
-    {
-        ins = ((AppInstance*) *it);
-        if (instance == ins)
-        {
-            it = _instances.erase(it);
-            break;
-        }
-    }
+    removeInstance(instance);
     pthread_mutex_unlock(&_mutex);
     return DR_OK;
 }
@@ -608,17 +802,8 @@ ApplicationManager::processTerminated(AppInstance* instance)
 {
     ILOG_TRACE_F(ILX_APPLICATIONMANAGER);
     _compositor->processTerminated(instance);
-    AppInstance* ins;
     pthread_mutex_lock(&_mutex);
-    for (AppInstanceList::iterator it = _instances.begin(); it != _instances.end(); ++it)
-    {
-        ins = ((AppInstance*) *it);
-        if (instance == ins)
-        {
-            it = _instances.erase(it);
-            break;
-        }
-    }
+    removeInstance(instance);
     pthread_mutex_unlock(&_mutex);
     return DR_OK;
 }
@@ -646,6 +831,10 @@ ApplicationManager::windowAdded(SaWManWindowInfo *info)
     if (!instance)
         return DR_FAILURE;
 
+    pthread_mutex_lock(&_mutex);
+    _windowIndex[info->handle] = instance;
+    pthread_mutex_unlock(&_mutex);
+
     AppInfo* appInfo = instance->appInfo();
 
     ILOG_DEBUG(ILX_APPLICATIONMANAGER, " -> App: %s Window: %u\n", appInfo->name().c_str(), instance->windowCount());
@@ -688,17 +877,14 @@ ApplicationManager::windowRemoved(SaWManWindowInfo *info)
 {
     ILOG_DEBUG( ILX_APPLICATIONMANAGER, "%s( info %p )\n", __FUNCTION__, info);
 
-    SaWManProcess process;
-    _manager->GetProcessInfo(_manager, info->handle, &process);
-
-    ILOG_DEBUG(ILX_APPLICATIONMANAGER, " -> Process [%d] Window [%lu]\n", process.pid, info->handle);
-
-    if (process.pid == getpid())
-        return DR_OK;
+    pthread_mutex_lock(&_mutex);
+    AppInstance* instance = findIndex(_windowIndex, info->handle);
+    _windowIndex.erase(info->handle);
+    pthread_mutex_unlock(&_mutex);
 
-    AppInstance* instance = instanceByPID(process.pid);
     if (instance)
     {
+        ILOG_DEBUG(ILX_APPLICATIONMANAGER, " -> Process [%d] Window [%lu]\n", instance->pid(), info->handle);
         _manager->Lock(_manager);
         instance->removeWindow(info->handle);
         _compositor->removeWindow(instance, info);
@@ -713,18 +899,12 @@ ApplicationManager::windowReconfig(SaWManWindowReconfig *reconfig)
     ILOG_DEBUG( ILX_APPLICATIONMANAGER, "%s( reconfig %p )\n", __FUNCTION__, reconfig);
     ILOG_DEBUG( ILX_APPLICATIONMANAGER, "  -> Window [%lu] Flags [0x%04x]\n", reconfig->handle, reconfig->flags);
 
-    SaWManProcess process;
-    _manager->GetProcessInfo(_manager, reconfig->handle, &process);
-
-    if (process.pid == getpid())
-        return DR_OK;
-
-    SaWManWindowInfo winInfo;
-    _manager->GetWindowInfo(_manager, reconfig->handle, &winInfo);
-
-    AppInstance* instance = instanceByPID(process.pid);
+    AppInstance* instance = instanceByWindow(reconfig->handle);
     if (instance)
     {
+        SaWManWindowInfo winInfo;
+        _manager->GetWindowInfo(_manager, reconfig->handle, &winInfo);
+
         AppInfo* info = instance->appInfo();
 
         if (!(info->appFlags() & APP_ALLOW_WINDOW_CONFIG) && (reconfig->flags & SWMCF_POSITION))
@@ -743,27 +923,21 @@ ApplicationManager::windowReconfig(SaWManWindowReconfig *reconfig)
 DirectResult
 ApplicationManager::windowRestack(SaWManWindowHandle handle, SaWManWindowHandle relative, SaWManWindowRelation relation)
 {
-    SaWManProcess process;
-    _manager->GetProcessInfo(_manager, handle, &process);
-
-    if (process.pid == getpid())
-        return DR_OK;
+    AppInstance* instance = instanceByWindow(handle);
 
-    SaWManWindowInfo winInfo;
-    _manager->GetWindowInfo(_manager, handle, &winInfo);
-
-    DFBWindowID related = 0;
-    if (relative)
+    if (instance)
     {
-        SaWManWindowInfo relativeInfo;
-        _manager->GetWindowInfo(_manager, relative, &relativeInfo);
-        related = relativeInfo.win_id;
-    }
+        SaWManWindowInfo winInfo;
+        _manager->GetWindowInfo(_manager, handle, &winInfo);
 
-    AppInstance* instance = instanceByPID(process.pid);
+        DFBWindowID related = 0;
+        if (relative)
+        {
+            SaWManWindowInfo relativeInfo;
+            _manager->GetWindowInfo(_manager, relative, &relativeInfo);
+            related = relativeInfo.win_id;
+        }
 
-    if (instance)
-    {
         _manager->Lock(_manager);
         _compositor->restackWindow(instance, &winInfo, relation, related);
         _manager->Unlock(_manager);
@@ -772,6 +946,180 @@ ApplicationManager::windowRestack(SaWManWindowHandle handle, SaWManWindowHandle
     return DR_OK;
 }
 
+bool
+ApplicationManager::bootDependenciesReady(const BootItem& item)
+{
+    const std::list<std::string>& after = item.info->startAfter();
+    for (BootList::iterator it = _boot.begin(); it != _boot.end(); ++it)
+    {
+        if (it->state == BootReady || it->info == item.info)
+            continue;
+
+        // Home waits for all startup applications if it has no explicit dependencies.
+        if (after.empty() && (item.info->appFlags() & APP_HOME))
+            return false;
+
+        for (std::list<std::string>::const_iterator dep = after.begin(); dep != after.end(); ++dep)
+        {
+            if (it->info->name() == *dep)
+                return false;
+        }
+    }
+    return true;
+}
+
+void
+ApplicationManager::startBootItem(BootItem& item)
+{
+    item.state = BootLaunched;
+    item.launched = direct_clock_get_millis();
+    DirectResult ret = startApplication(item.info->name(), item.info->appFlags() & APP_HOME);
+    if (ret == DR_BUSY)
+    {
+        AppInstance* instance = instanceByAppID(item.info->appID());
+        if (instance && instance->ready())
+            item.state = BootReady;
+    } else if (ret != DR_OK || (item.info->appFlags() & APP_NO_MAINWINDOW))
+        item.state = BootReady;
+}
+
+void
+ApplicationManager::runBoot()
+{
+    ILOG_TRACE_F(ILX_APPLICATIONMANAGER);
+    bool progress = true;
+    while (progress)
+    {
+        progress = false;
+        for (BootList::iterator it = _boot.begin(); it != _boot.end(); ++it)
+        {
+            if (it->state != BootWaiting || !bootDependenciesReady(*it))
+                continue;
+
+            startBootItem(*it);
+            if (it->state == BootReady)
+                progress = true;
+        }
+    }
+
+    for (BootList::iterator it = _boot.begin(); it != _boot.end(); ++it)
+    {
+        if (it->state != BootReady)
+            return;
+    }
+
+    if (!_boot.empty())
+    {
+        ILOG_INFO(ILX_APPLICATIONMANAGER, "Startup applications are ready in %lld ms.\n", direct_clock_get_millis() - _bootStarted);
+        _boot.clear();
+    }
+    if (_bootTimer)
+        _bootTimer->stop();
+}
+
+void
+ApplicationManager::bootTimeout()
+{
+    long long now = direct_clock_get_millis();
+    bool changed = false;
+    BootList::iterator waiting = _boot.end();
+    bool launched = false;
+    for (BootList::iterator it = _boot.begin(); it != _boot.end(); ++it)
+    {
+        if (it->state == BootWaiting && waiting == _boot.end())
+            waiting = it;
+
+        if (it->state != BootLaunched)
+            continue;
+
+        launched = true;
+
+        if (!instanceByAppID(it->info->appID()))
+        {
+            ILOG_WARNING(ILX_APPLICATIONMANAGER, "%s exited during startup.\n", it->info->name().c_str());
+            it->state = BootReady;
+            changed = true;
+        } else if (now - it->launched > __bootTimeout)
+        {
+            ILOG_WARNING(ILX_APPLICATIONMANAGER, "%s is not ready after %u ms, starting dependants.\n", it->info->name().c_str(), __bootTimeout);
+            it->state = BootReady;
+            changed = true;
+        }
+    }
+
+    // Nothing is pending but applications are still waiting, so dependencies are circular.
+    if (!launched && waiting != _boot.end())
+    {
+        ILOG_WARNING(ILX_APPLICATIONMANAGER, "Circular startup dependency, starting %s.\n", waiting->info->name().c_str());
+        startBootItem(*waiting);
+        changed = true;
+    }
+
+    if (changed)
+        runBoot();
+}
+
+AppInstance*
+ApplicationManager::addInstance(AppInfo* appInfo, pid_t pid)
+{
+    pthread_mutex_lock(&_mutex);
+    AppInstance* instance = new AppInstance();
+    instance->setAppInfo(appInfo);
+    instance->setStarted(direct_clock_get_millis());
+    instance->setPid(pid);
+    _instances.push_back(instance);
+    _pidIndex[pid] = instance;
+    _pidCache.erase(pid);
+    _instanceIndex[instance->instanceID()] = instance;
+    if (_appIndex.find(appInfo->appID()) == _appIndex.end())
+        _appIndex[appInfo->appID()] = instance;
+    pthread_mutex_unlock(&_mutex);
+    _compositor->_compComp->signalAppStart(instance);
+    return instance;
+}
+
+void
+ApplicationManager::removeInstance(AppInstance* instance)
+{
+    _instances.remove(instance);
+
+    PIDMap::iterator pit = _pidIndex.find(instance->pid());
+    if (pit != _pidIndex.end() && pit->second == instance)
+        _pidIndex.erase(pit);
+
+    for (PIDMap::iterator it = _pidCache.begin(); it != _pidCache.end();)
+    {
+        if (it->second == instance)
+            _pidCache.erase(it++);
+        else
+            ++it;
+    }
+
+    for (WindowMap::iterator it = _windowIndex.begin(); it != _windowIndex.end();)
+    {
+        if (it->second == instance)
+            _windowIndex.erase(it++);
+        else
+            ++it;
+    }
+
+    _instanceIndex.erase(instance->instanceID());
+
+    AppIDMap::iterator ait = _appIndex.find(instance->appID());
+    if (ait != _appIndex.end() && ait->second == instance)
+    {
+        _appIndex.erase(ait);
+        for (AppInstanceList::iterator it = _instances.begin(); it != _instances.end(); ++it)
+        {
+            if ((*it)->appID() == instance->appID())
+            {
+                _appIndex[instance->appID()] = *it;
+                break;
+            }
+        }
+    }
+}
+
 bool
 ApplicationManager::parseAppDef(const std::string& folder, const std::string& file)
 {
@@ -799,6 +1147,8 @@ ApplicationManager::parseAppDef(const std::string& folder, const std::string& fi
     xmlChar* args = NULL;
     xmlChar* appFlags = NULL;
     xmlChar* depFlags = NULL;
+    xmlChar* startAfter = NULL;
+    xmlChar* priority = NULL;
 
     while (group != NULL)
     {
@@ -835,12 +1185,18 @@ ApplicationManager::parseAppDef(const std::string& folder, const std::string& fi
         else if (xmlStrcmp(group->name, (xmlChar*) "deps") == 0)
             depFlags = xmlNodeGetContent(group->children);
 
+        else if (xmlStrcmp(group->name, (xmlChar*) "after") == 0)
+            startAfter = xmlNodeGetContent(group->children);
+
+        else if (xmlStrcmp(group->name, (xmlChar*) "priority") == 0)
+            priority = xmlNodeGetContent(group->children);
+
         group = group->next;
     }
 
     ILOG_DEBUG(ILX_APPLICATIONMANAGER, " -> done.\n", file.c_str());
 
-    addApplication((const char*) name, (const char*) author, (const char*) licence, (const char*) category, (const char*) version, (const char*) icon, (const char*) exec, (const char*) args, (const char*) appFlags, (const char*) depFlags);
+    addApplication((const char*) name, (const char*) author, (const char*) licence, (const char*) category, (const char*) version, (const char*) icon, (const char*) exec, (const char*) args, (const char*) appFlags, (const char*) depFlags, (const char*) startAfter, (const char*) priority);
 
     xmlFree(name);
     xmlFree(author);
@@ -855,12 +1211,16 @@ ApplicationManager::parseAppDef(const std::string& folder, const std::string& fi
         xmlFree(appFlags);
     if (depFlags)
         xmlFree(depFlags);
+    if (startAfter)
+        xmlFree(startAfter);
+    if (priority)
+        xmlFree(priority);
 
     return true;
 }
 
 void
-ApplicationManager::addApplication(const char* name, const char* author, const char* licence, const char* category, const char* version, const char* icon, const char* exec, const char* args, const char* appFlags, const char* depFlags)
+ApplicationManager::addApplication(const char* name, const char* author, const char* licence, const char* category, const char* version, const char* icon, const char* exec, const char* args, const char* appFlags, const char* depFlags, const char* startAfter, const char* priority)
 {
     if (infoByName(name))
         return;
@@ -886,6 +1246,10 @@ ApplicationManager::addApplication(const char* name, const char* author, const c
         app->setAppFlags(appFlags);
     if (depFlags)
         app->setDepFlags(depFlags);
+    if (startAfter)
+        app->setStartAfter(startAfter);
+    if (priority)
+        app->setPriority(priority);
     _infos.push_back(app);
 }
 
@@ -965,6 +1329,33 @@ ApplicationManager::searchExec(const char* exec, std::string& execPath)
     return false;
 }
 
+AppInstance*
+ApplicationManager::largestInstance(bool hiddenOnly)
+{
+    AppInstance* match = NULL;
+    unsigned long matchPSS = 0;
+    pthread_mutex_lock(&_mutex);
+    for (AppInstanceList::iterator it = _instances.begin(); it != _instances.end(); ++it)
+    {
+        AppInstance* instance = (AppInstance*) *it;
+        if (instance->appInfo()->appFlags() & APP_SYSTEM)
+            continue;
+
+        if (hiddenOnly && !(instance->view() && !instance->view()->visible()))
+            continue;
+
+        unsigned long pss = _monitor->pss(instance->pid());
+        ILOG_DEBUG(ILX_APPLICATIONMANAGER, " -> %s [%d] PSS: %lu kB\n", instance->appInfo()->name().c_str(), instance->pid(), pss);
+        if (!match || pss > matchPSS)
+        {
+            match = instance;
+            matchPSS = pss;
+        }
+    }
+    pthread_mutex_unlock(&_mutex);
+    return match;
+}
+
 void
 ApplicationManager::handleMemoryState(MemoryMonitor::MemoryState state)
 {
@@ -972,24 +1363,12 @@ ApplicationManager::handleMemoryState(MemoryMonitor::MemoryState state)
     {
     case MemoryMonitor::Critical:
         {
-            // kill a non-system app.
+            // kill largest non-system app.
             ILOG_WARNING(ILX_APPLICATIONMANAGER, "MemoryMonitor reports Critical.\n");
-            AppInstance* instance = NULL;
-            AppInstance* match = NULL;
-            AppInfo* info;
-            for (AppInstanceList::iterator it = _instances.begin(); it != _instances.end(); ++it)
-            {
-                instance = (AppInstance*) *it;
-                info = instance->appInfo();
-                if (!(info->appFlags() & APP_SYSTEM))
-                {
-                    match = instance;
-                    info = match->appInfo();
-                    break;
-                }
-            }
+            AppInstance* match = largestInstance(false);
             if (!match)
                 break;
+            AppInfo* info = match->appInfo();
             ILOG_WARNING(ILX_APPLICATIONMANAGER, " -> Stopping %s\n", info->name().c_str());
             std::stringstream ss;
             ss << info->name() << " is terminated automatically.";
@@ -1003,23 +1382,11 @@ ApplicationManager::handleMemoryState(MemoryMonitor::MemoryState state)
     case MemoryMonitor::Low:
         {
             ILOG_WARNING(ILX_APPLICATIONMANAGER, "MemoryMonitor reports Low.\n");
-            // kill an invisible and non-system app.
-            AppInstance* instance = NULL;
-            AppInstance* match = NULL;
-            AppInfo* info;
-            for (AppInstanceList::iterator it = _instances.begin(); it != _instances.end(); ++it)
-            {
-                instance = (AppInstance*) *it;
-                info = instance->appInfo();
-                if (!(info->appFlags() & APP_SYSTEM) && instance->view() && !instance->view()->visible())
-                {
-                    match = instance;
-                    info = match->appInfo();
-                    break;
-                }
-            }
+            // kill largest invisible and non-system app.
+            AppInstance* match = largestInstance(true);
             if (!match)
                 break;
+            AppInfo* info = match->appInfo();
             ILOG_WARNING(ILX_APPLICATIONMANAGER, " -> Stopping %s\n", info->name().c_str());
             std::stringstream ss;
             ss << info->name() << " is terminated automatically.";
@@ -27,11 +27,16 @@
 #include <compositor/AppInfo.h>
 #include <compositor/AppInstance.h>
 #include <compositor/MemoryMonitor.h>
+#include <lib/Thread.h>
 #include <sys/types.h>
+#include <map>
+#include <vector>
 
 namespace ilixi
 {
 class ILXCompositor;
+class Timer;
+class Zygote;
 
 typedef std::list<AppInfo*> AppInfoList;
 typedef std::list<AppInstance*> AppInstanceList;
@@ -120,11 +125,20 @@ public:
     AppInstance*
     instanceByPID(const pid_t pid);
 
+    /*!
+     * Returns an AppInstance given a SaWMan window handle.
+     *
+     * @param handle SaWMan window handle.
+     * @return NULL if window is not owned by an application instance.
+     */
+    AppInstance*
+    instanceByWindow(SaWManWindowHandle handle);
+
     /*!
      * Returns a process' parent PID.
      *
      * @param pid Process ID.
-     * @return Process ID of parent.
+     * @return Process ID of parent, or -1 if it can not be read.
      */
     pid_t
     getParentPID(const pid_t pid);
@@ -171,11 +185,31 @@ public:
 
     /*!
      * Starts home, statusbar and all startup applications.
+     *
+     * Applications are started in priority order as soon as applications listed in their
+     * <after> element are ready. Home waits for all other startup applications unless
+     * its appdef specifies otherwise.
+     *
      * @see APP_AUTO_START
      */
     void
     initStartup();
 
+    /*!
+     * Marks an instance ready once its first window is added and starts
+     * startup applications waiting for it.
+     *
+     * This method should be called from main thread.
+     */
+    void
+    instanceReady(AppInstance* instance);
+
+    /*!
+     * Returns memory monitor or NULL if it is disabled.
+     */
+    MemoryMonitor*
+    memoryMonitor() const;
+
     /*!
      * Parses given folder and adds all application definitions (*.appdef).
      *
@@ -184,6 +218,14 @@ public:
     void
     parseFolder(const std::string& folder);
 
+    /*!
+     * Handles child status changes queued by signal handler.
+     *
+     * This method should be called from main thread, see ILXCompositor::CET_Child.
+     */
+    void
+    handleChildEvents();
+
 protected:
     /*!
      * Called when a DirectFB process starts.
@@ -234,6 +276,31 @@ protected:
     windowRestack(SaWManWindowHandle handle, SaWManWindowHandle relative, SaWManWindowRelation relation);
 
 private:
+    //! Reads child status changes written by signal handler and wakes up main loop.
+    class ChildThread : public Thread
+    {
+    public:
+        ChildThread(ApplicationManager* manager);
+
+        virtual
+        ~ChildThread();
+
+        virtual int
+        run();
+
+    private:
+        ApplicationManager* _manager;
+    };
+
+    //! A child status change, see handleChildEvents().
+    struct ChildEvent
+    {
+        pid_t pid;
+        int code;
+    };
+
+    typedef std::vector<ChildEvent> ChildEventList;
+
     //! Owner.
     ILXCompositor* _compositor;
     //! List of registered applications.
@@ -241,6 +308,22 @@ private:
     //! List of running application instances.
     AppInstanceList _instances;
 
+    typedef std::map<pid_t, AppInstance*> PIDMap;
+    typedef std::map<AppID, AppInstance*> AppIDMap;
+    typedef std::map<InstanceID, AppInstance*> InstanceIDMap;
+    typedef std::map<SaWManWindowHandle, AppInstance*> WindowMap;
+
+    //! Instances by process ID.
+    PIDMap _pidIndex;
+    //! Owning instance of child processes, filled once per new pid.
+    PIDMap _pidCache;
+    //! First instance of each application.
+    AppIDMap _appIndex;
+    //! Instances by instance ID.
+    InstanceIDMap _instanceIndex;
+    //! Instances by window handle.
+    WindowMap _windowIndex;
+
     //! SaWMan interface.
     ISaWMan *_saw;
     //! SaWMan manager interface.
@@ -250,11 +333,40 @@ private:
 
     //! Memory Monitor.
     MemoryMonitor* _monitor;
-
-    //! This locks application instance list.
+    //! Pre-initialised launcher for APP_ZYGOTE applications.
+    Zygote* _zygote;
+
+    enum BootState
+    {
+        BootWaiting,    //!< Waiting for dependencies.
+        BootLaunched,   //!< Started, waiting for first window.
+        BootReady       //!< Ready, failed or timed out.
+    };
+
+    struct BootItem
+    {
+        AppInfo* info;
+        BootState state;
+        //! Time when application is started.
+        long long launched;
+    };
+
+    typedef std::list<BootItem> BootList;
+    //! List of startup applications sorted by priority.
+    BootList _boot;
+    //! Time when boot sequence is started.
+    long long _bootStarted;
+    //! Releases applications which do not become ready in time.
+    Timer* _bootTimer;
+
+    //! This locks application instance list, indexes and queued child events.
     pthread_mutex_t _mutex;
     //! Registers signal handler.
     struct sigaction _act;
+    //! Waits for child status changes.
+    ChildThread* _childThread;
+    //! Child status changes waiting for main thread, locked using _mutex.
+    ChildEventList _childEvents;
 
     //! Parses an appdef file.
     bool
@@ -262,12 +374,48 @@ private:
 
     //! Add application to list.
     void
-    addApplication(const char* name, const char* author, const char* licence, const char* category, const char* version, const char* icon, const char* exec, const char* args, const char* appFlags, const char* depFlags);
+    addApplication(const char* name, const char* author, const char* licence, const char* category, const char* version, const char* icon, const char* exec, const char* args, const char* appFlags, const char* depFlags, const char* startAfter, const char* priority);
 
     //! Searches for executable. Returns true if found.
     bool
     searchExec(const char* exec, std::string& path);
 
+    //! Starts application using vfork and returns its process ID, or -1 on failure.
+    pid_t
+    forkApplication(AppInfo* appInfo);
+
+    //! Slot, adds instance for an application launched by zygote, called from zygote reply thread.
+    void
+    zygoteLaunched(AppInfo* appInfo, pid_t pid);
+
+    //! Creates and registers an instance for a started application.
+    AppInstance*
+    addInstance(AppInfo* appInfo, pid_t pid);
+
+    //! Returns true if all boot dependencies of item are ready.
+    bool
+    bootDependenciesReady(const BootItem& item);
+
+    //! Starts a boot application and marks it ready if it will not add a window.
+    void
+    startBootItem(BootItem& item);
+
+    //! Starts boot applications whose dependencies are ready.
+    void
+    runBoot();
+
+    //! Slot, marks stalled boot applications ready.
+    void
+    bootTimeout();
+
+    //! Removes instance from list and indexes, _mutex must be locked.
+    void
+    removeInstance(AppInstance* instance);
+
+    //! Returns non-system instance with largest memory usage, optionally only hidden ones.
+    AppInstance*
+    largestInstance(bool hiddenOnly);
+
     //! Slot, handles a memory state change.
     void
     handleMemoryState(MemoryMonitor::MemoryState state);
@@ -32,7 +32,9 @@
 #include <ui/Label.h>
 
 #include <sigc++/bind.h>
+#include <algorithm>
 #include <sstream>
+#include <string.h>
 
 using namespace std;
 
@@ -53,6 +55,10 @@ ILXCompositor::ILXCompositor(int argc, char* argv[])
           _home(NULL),
           _statusBar(NULL),
           _osk(NULL),
+          _scanoutLayer(NULL),
+          _scanoutSurface(NULL),
+          _scanoutApp(NULL),
+          _scanoutView(NULL),
           _oskTargetPID(0)
 {
     setenv("WEBKIT_IGNORE_SSL_ERRORS", "1", 0);
@@ -73,12 +79,30 @@ ILXCompositor::ILXCompositor(int argc, char* argv[])
 
     _fps = new FPSCalculator();
 
+#if ILIXI_HAS_LAYERSURFACE
+    _scanoutLayer = PlatformManager::instance().getScanoutLayer();
+    if (_scanoutLayer)
+    {
+        DFBResult ret = _scanoutLayer->GetSurface(_scanoutLayer, &_scanoutSurface);
+        if (ret)
+        {
+            ILOG_ERROR(ILX_COMPOSITOR, "Error! GetSurface: %s\n", DirectFBErrorString(ret));
+            ILOG_WARNING(ILX_COMPOSITOR, "Direct scanout is disabled.\n");
+            _scanoutLayer = NULL;
+        } else
+            ILOG_INFO(ILX_COMPOSITOR, "Using direct scanout for full-screen applications.\n");
+    }
+#endif
+
     sigVisible.connect(sigc::mem_fun(this, &ILXCompositor::onVisible));
 }
 
 ILXCompositor::~ILXCompositor()
 {
     ILOG_TRACE_F(ILX_COMPOSITOR);
+    setScanout(NULL);
+    if (_scanoutSurface)
+        _scanoutSurface->Release(_scanoutSurface);
     delete _appMan;
     delete _fps;
     delete _compComp;
@@ -140,6 +164,7 @@ ILXCompositor::showInstance(AppInstance* instance)
     else
         _compComp->signalBack(false);
     _currentApp->view()->setWindowFocus();
+    updateScanout();
 }
 
 void
@@ -174,6 +199,7 @@ ILXCompositor::toggleSwitcher(bool show)
         if (_currentApp)
             _currentApp->view()->setWindowFocus();
     }
+    updateScanout();
 }
 
 void
@@ -257,6 +283,7 @@ ILXCompositor::toggleOSK(bool show)
                 _oskTargetPID = 0;
             }
         }
+        updateScanout();
     }
 }
 
@@ -323,6 +350,110 @@ ILXCompositor::setSwitcherGeometry(const Rectangle& rect)
     _switcherGeometry = rect;
 }
 
+bool
+ILXCompositor::occluded(const AppView* view, const Rectangle& rect) const
+{
+    if (!view->_parent)
+        return false;
+
+    Rectangle target = view->frameGeometry().intersected(rect);
+    if (!target.isValid())
+        return false;
+
+    const Widget::WidgetList& siblings = view->_parent->_children;
+    Widget::WidgetListConstIterator it = std::find(siblings.begin(), siblings.end(), view);
+    if (it == siblings.end())
+        return false;
+
+    // Siblings are painted back to front, so views above come later in list.
+    for (++it; it != siblings.end(); ++it)
+    {
+        const AppCompositor* above = dynamic_cast<const AppCompositor*>(*it);
+        if (above && above->covers(target))
+            return true;
+    }
+    return false;
+}
+
+void
+ILXCompositor::updateScanout()
+{
+    if (!_scanoutLayer)
+        return;
+
+    AppInstance* candidate = NULL;
+    AppView* view = _currentApp ? _currentApp->view() : NULL;
+    if (view && view->_parent && !(_switcher && _switcher->visible()) && !(view->_animProps & (AppView::AnimShowing | AppView::AnimHiding)) && view->zoomFactor() == 1 && view->opaqueView(_appGeometry))
+    {
+        candidate = _currentApp;
+
+        // Any visible compositor UI above application area reverts to composition.
+        const Widget::WidgetList& siblings = view->_parent->_children;
+        Widget::WidgetListConstIterator it = std::find(siblings.begin(), siblings.end(), view);
+        if (it == siblings.end())
+            candidate = NULL;
+        else
+        {
+            for (++it; it != siblings.end(); ++it)
+            {
+                if ((*it)->visible() && (*it)->frameGeometry().intersects(_appGeometry))
+                {
+                    candidate = NULL;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (candidate != _scanoutApp)
+        setScanout(candidate);
+}
+
+void
+ILXCompositor::setScanout(AppInstance* instance)
+{
+    ILOG_TRACE_F(ILX_COMPOSITOR);
+    if (_scanoutView)
+    {
+        ILOG_DEBUG(ILX_COMPOSITOR, " -> composing %s\n", _scanoutApp->appInfo()->name().c_str());
+        _scanoutLayer->SetOpacity(_scanoutLayer, 0);
+#if ILIXI_HAS_LAYERSURFACE
+        // Detach client surface, so layer does not keep it after application exits.
+        _scanoutLayer->SetSurface(_scanoutLayer, _scanoutSurface);
+#endif
+        _scanoutView->setExternalOutput(false);
+    }
+    _scanoutApp = NULL;
+    _scanoutView = NULL;
+
+    if (!instance || !_scanoutLayer)
+        return;
+
+#if ILIXI_HAS_LAYERSURFACE
+    SurfaceView* view = instance->view()->opaqueView(_appGeometry);
+    if (!view || !view->sourceSurface())
+        return;
+
+    DFBResult ret = _scanoutLayer->SetSurface(_scanoutLayer, view->sourceSurface());
+    if (ret)
+    {
+        ILOG_ERROR(ILX_COMPOSITOR, "Error! SetSurface: %s\n", DirectFBErrorString(ret));
+        ILOG_WARNING(ILX_COMPOSITOR, "Direct scanout is disabled.\n");
+        _scanoutLayer = NULL;
+        return;
+    }
+
+    Rectangle r = view->frameGeometry();
+    _scanoutLayer->SetScreenRectangle(_scanoutLayer, r.x(), r.y(), r.width(), r.height());
+    _scanoutLayer->SetOpacity(_scanoutLayer, 255);
+    view->setExternalOutput(true);
+
+    _scanoutApp = instance;
+    _scanoutView = view;
+    ILOG_DEBUG(ILX_COMPOSITOR, " -> scanout %s\n", instance->appInfo()->name().c_str());
+#endif
+}
+
 void
 ILXCompositor::onVisible()
 {
@@ -367,11 +498,13 @@ ILXCompositor::addWindow(AppInstance* instance, const SaWManWindowInfo* info)
     ILOG_TRACE_F(ILX_COMPOSITOR);
     ILOG_DEBUG(ILX_COMPOSITOR, " -> ID %u\n", info->win_id);
 
-    CompositorEventData* data = new CompositorEventData;
-    data->instance = instance;
-    data->windowID = info->win_id;
+    WindowEvent event;
+    event.type = WindowEvent::Add;
+    event.instance = instance;
+    event.windowID = info->win_id;
 
-    Engine::instance().postUserEvent(CET_Add, data);
+    if (_windowEvents.push(event))
+        Engine::instance().postUserEvent(CET_Window);
 }
 
 void
@@ -380,11 +513,13 @@ ILXCompositor::removeWindow(AppInstance* instance, const SaWManWindowInfo* info)
     ILOG_TRACE_F(ILX_COMPOSITOR);
     ILOG_DEBUG(ILX_COMPOSITOR, " -> ID %u\n", info->win_id);
 
-    CompositorEventData* data = new CompositorEventData;
-    data->instance = instance;
-    data->windowID = info->win_id;
+    WindowEvent event;
+    event.type = WindowEvent::Remove;
+    event.instance = instance;
+    event.windowID = info->win_id;
 
-    Engine::instance().postUserEvent(CET_Remove, data);
+    if (_windowEvents.push(event))
+        Engine::instance().postUserEvent(CET_Window);
 }
 
 void
@@ -393,17 +528,14 @@ ILXCompositor::configWindow(AppInstance* instance, SaWManWindowReconfig *reconfi
     ILOG_TRACE_F(ILX_COMPOSITOR);
     ILOG_DEBUG(ILX_COMPOSITOR, " -> ID %u\n", info->win_id);
 
-    CompositorEventData* data = new CompositorEventData;
-    data->instance = instance;
-    data->reconfig = new SaWManWindowReconfig;
-    data->reconfig->caps = reconfig->caps;
-    data->reconfig->current = reconfig->current;
-    data->reconfig->flags = reconfig->flags;
-    data->reconfig->handle = reconfig->handle;
-    data->reconfig->request = reconfig->request;
-    data->windowID = info->win_id;
-    usleep(10000);
-    Engine::instance().postUserEvent(CET_Config, data);
+    WindowEvent event;
+    event.type = WindowEvent::Config;
+    event.instance = instance;
+    event.windowID = info->win_id;
+    event.reconfig = *reconfig;
+
+    if (_windowEvents.push(event))
+        Engine::instance().postUserEvent(CET_Window);
 }
 
 void
@@ -412,18 +544,18 @@ ILXCompositor::restackWindow(AppInstance* instance, const SaWManWindowInfo* info
     ILOG_TRACE_F(ILX_COMPOSITOR);
     ILOG_DEBUG(ILX_COMPOSITOR, " -> ID %u\n", info->win_id);
 
-    CompositorEventData* data = new CompositorEventData;
-    data->instance = instance;
-    data->reconfig = new SaWManWindowReconfig;
-    data->reconfig->caps = DWCAPS_NONE;
-    data->reconfig->flags = SWMCF_STACKING;
-    SaWManWindowConfig reconfig;
-    reconfig.association = other;
-    reconfig.opacity = order;
-    data->reconfig->request = reconfig;
-    data->windowID = info->win_id;
-
-    Engine::instance().postUserEvent(CET_Restack, data);
+    WindowEvent event;
+    event.type = WindowEvent::Restack;
+    event.instance = instance;
+    event.windowID = info->win_id;
+    memset(&event.reconfig, 0, sizeof(event.reconfig));
+    event.reconfig.caps = DWCAPS_NONE;
+    event.reconfig.flags = SWMCF_STACKING;
+    event.reconfig.request.association = other;
+    event.reconfig.request.opacity = order;
+
+    if (_windowEvents.push(event))
+        Engine::instance().postUserEvent(CET_Window);
 }
 
 void
@@ -469,137 +601,22 @@ ILXCompositor::handleUserEvent(const DFBUserEvent& event)
 {
     if (event.clazz == DFEC_USER)
     {
+        // Window events queued before this event must be handled first, e.g. before an instance is deleted.
+        processWindowEvents();
+        if (event.type == CET_Window)
+            return;
+
         CompositorEventData* data = (CompositorEventData*) event.data;
-        AppInfo* appInfo = data->instance->appInfo();
+
+        // Instance may be deleted below.
+        if (data && data->instance && data->instance == _scanoutApp)
+            setScanout(NULL);
 
         switch (event.type)
         {
-        case CET_Add:
-            {
-                ILOG_DEBUG(ILX_COMPOSITOR, "CET_Add (%d)\n", data->windowID);
-                IDirectFBWindow* dfbWindow = getWindow(data->windowID);
-                if (!dfbWindow)
-                    break;
-                if (appInfo->appFlags() & APP_STATUSBAR)
-                {
-                    ILOG_DEBUG(ILX_COMPOSITOR, " -> APP_STATUSBAR\n");
-                    _statusBar = data->instance;
-                    _statusBar->setView(new AppView(this, data->instance));
-                    _statusBar->view()->setGeometry(_barGeometry);
-                    addWidget(_statusBar->view());
-                    _statusBar->view()->setZ(0);
-                    _statusBar->view()->bringToFront();
-                    _statusBar->view()->addWindow(dfbWindow);
-                } else if (appInfo->appFlags() & APP_OSK)
-                {
-                    ILOG_DEBUG(ILX_COMPOSITOR, " -> APP_OSK\n");
-
-                    _osk = data->instance;
-                    if (!_osk->view())
-                    {
-                        _osk->setView(new AppView(this, data->instance));
-                        _osk->view()->setGeometry(_oskGeometry);
-                        addWidget(_osk->view());
-                        if (_statusBar)
-                            _statusBar->view()->bringToFront();
-                        _osk->view()->setZ(0);
-                    }
-                    _osk->view()->addWindow(dfbWindow, true, false);
-                } else if (appInfo->appFlags() & APP_HOME)
-                {
-                    ILOG_DEBUG(ILX_COMPOSITOR, " -> APP_HOME\n");
-
-                    if (data->instance->view() == NULL)
-                    {
-                        _home = data->instance;
-                        _home->setView(new AppView(this, _home));
-                        data->instance->view()->setGeometry(_appGeometry);
-                        addWidget(_home->view());
-                        _home->view()->setZ(0);
-                        _home->view()->sendToBack();
-                    }
-                    _home->view()->addWindow(dfbWindow);
-                } else if (appInfo->appFlags() & APP_SYSTEM)
-                {
-                    ILOG_DEBUG(ILX_COMPOSITOR, " -> APP_SYSTEM\n");
-
-                    if (data->instance->view() == NULL)
-                    {
-                        data->instance->setView(new AppView(this, data->instance));
-                        data->instance->view()->setGeometry(_appGeometry);
-                        addWidget(data->instance->view());
-                        data->instance->view()->setZ(0);
-                        data->instance->view()->sendToBack();
-                    }
-                    data->instance->view()->addWindow(dfbWindow, true, !(appInfo->appFlags() & APP_SURFACE_DONTBLOCK));
-                } else
-                {
-                    ILOG_DEBUG(ILX_COMPOSITOR, " -> APP_DEFAULT\n");
-
-                    if (data->instance->thumb() == NULL)
-                    {
-                        data->instance->setView(new AppView(this, data->instance));
-                        data->instance->view()->setGeometry(_appGeometry);
-                        data->instance->view()->setZ(-5);
-                        addWidget(data->instance->view());
-                        data->instance->view()->sendToBack();
-                        if (_switcher)
-                        {
-                            data->instance->setThumb(new AppThumbnail(this, data->instance));
-                            _switcher->addThumb(data->instance->thumb());
-                            data->instance->view()->setNeighbour(Down, _switcher);
-                        }
-                    }
-
-                    data->instance->view()->addWindow(dfbWindow, true, !(appInfo->appFlags() & APP_SURFACE_DONTBLOCK));
-                    data->instance->thumb()->addWindow(dfbWindow, false);
-                }
-                if (dfbWindow)
-                    dfbWindow->Release(dfbWindow);
-            }
-            break;
-
-        case CET_Remove:
-            {
-                ILOG_DEBUG(ILX_COMPOSITOR, "CET_Remove (%d)\n", data->windowID);
-
-                if (data->instance->view())
-                    data->instance->view()->removeWindow(data->windowID);
-
-                if (data->instance->thumb())
-                    data->instance->thumb()->removeWindow(data->windowID);
-            }
-            break;
-
-        case CET_Config:
-            {
-                ILOG_DEBUG(ILX_COMPOSITOR, "CET_CONFIG (%d)\n", data->windowID);
-
-                if (data->instance->view())
-                    data->instance->view()->onWindowConfig(data->windowID, data->reconfig);
-                if (data->instance->thumb())
-                    data->instance->thumb()->onWindowConfig(data->windowID, data->reconfig);
-
-                delete data->reconfig;
-            }
-            break;
-
         case CET_Focus:
             break;
 
-        case CET_Restack:
-            {
-                ILOG_DEBUG(ILX_COMPOSITOR, "CET_Restack (%d)\n", data->windowID);
-
-                if (data->instance->view())
-                    data->instance->view()->onWindowConfig(data->windowID, data->reconfig);
-                if (data->instance->thumb())
-                    data->instance->thumb()->onWindowConfig(data->windowID, data->reconfig);
-
-                delete data->reconfig;
-            }
-            break;
-
         case CET_State:
             break;
 
@@ -667,11 +684,157 @@ ILXCompositor::handleUserEvent(const DFBUserEvent& event)
             }
             break;
 
+        case CET_Memory:
+            if (_appMan->memoryMonitor())
+                _appMan->memoryMonitor()->refresh();
+            break;
+
+        case CET_Child:
+            _appMan->handleChildEvents();
+            break;
+
+        case CET_Scanout:
+            // updateScanout() is called below.
+            break;
+
         default:
             break;
         }
 
         delete data;
+        updateScanout();
+    }
+}
+
+void
+ILXCompositor::processWindowEvents()
+{
+    _windowEvents.acknowledge();
+    WindowEvent event;
+    while (_windowEvents.pop(&event))
+        handleWindowEvent(event);
+    updateScanout();
+}
+
+void
+ILXCompositor::handleWindowEvent(const WindowEvent& event)
+{
+    AppInfo* appInfo = event.instance->appInfo();
+
+    // Window surfaces of scanout application may change, revert to composition until events are handled.
+    if (event.instance == _scanoutApp)
+        setScanout(NULL);
+
+    switch (event.type)
+    {
+    case WindowEvent::Add:
+        {
+            ILOG_DEBUG(ILX_COMPOSITOR, "Add (%d)\n", event.windowID);
+            IDirectFBWindow* dfbWindow = getWindow(event.windowID);
+            if (!dfbWindow)
+                return;
+            if (appInfo->appFlags() & APP_STATUSBAR)
+            {
+                ILOG_DEBUG(ILX_COMPOSITOR, " -> APP_STATUSBAR\n");
+                _statusBar = event.instance;
+                _statusBar->setView(new AppView(this, event.instance));
+                _statusBar->view()->setGeometry(_barGeometry);
+                addWidget(_statusBar->view());
+                _statusBar->view()->setZ(0);
+                _statusBar->view()->bringToFront();
+                _statusBar->view()->addWindow(dfbWindow);
+            } else if (appInfo->appFlags() & APP_OSK)
+            {
+                ILOG_DEBUG(ILX_COMPOSITOR, " -> APP_OSK\n");
+
+                _osk = event.instance;
+                if (!_osk->view())
+                {
+                    _osk->setView(new AppView(this, event.instance));
+                    _osk->view()->setGeometry(_oskGeometry);
+                    addWidget(_osk->view());
+                    if (_statusBar)
+                        _statusBar->view()->bringToFront();
+                    _osk->view()->setZ(0);
+                }
+                _osk->view()->addWindow(dfbWindow, true, false);
+            } else if (appInfo->appFlags() & APP_HOME)
+            {
+                ILOG_DEBUG(ILX_COMPOSITOR, " -> APP_HOME\n");
+
+                if (event.instance->view() == NULL)
+                {
+                    _home = event.instance;
+                    _home->setView(new AppView(this, _home));
+                    event.instance->view()->setGeometry(_appGeometry);
+                    addWidget(_home->view());
+                    _home->view()->setZ(0);
+                    _home->view()->sendToBack();
+                }
+                _home->view()->addWindow(dfbWindow);
+            } else if (appInfo->appFlags() & APP_SYSTEM)
+            {
+                ILOG_DEBUG(ILX_COMPOSITOR, " -> APP_SYSTEM\n");
+
+                if (event.instance->view() == NULL)
+                {
+                    event.instance->setView(new AppView(this, event.instance));
+                    event.instance->view()->setGeometry(_appGeometry);
+                    addWidget(event.instance->view());
+                    event.instance->view()->setZ(0);
+                    event.instance->view()->sendToBack();
+                }
+                event.instance->view()->addWindow(dfbWindow, true, !(appInfo->appFlags() & APP_SURFACE_DONTBLOCK));
+            } else
+            {
+                ILOG_DEBUG(ILX_COMPOSITOR, " -> APP_DEFAULT\n");
+
+                if (event.instance->thumb() == NULL)
+                {
+                    event.instance->setView(new AppView(this, event.instance));
+                    event.instance->view()->setGeometry(_appGeometry);
+                    event.instance->view()->setZ(-5);
+                    addWidget(event.instance->view());
+                    event.instance->view()->sendToBack();
+                    if (_switcher)
+                    {
+                        event.instance->setThumb(new AppThumbnail(this, event.instance));
+                        _switcher->addThumb(event.instance->thumb());
+                        event.instance->view()->setNeighbour(Down, _switcher);
+                    }
+                }
+
+                event.instance->view()->addWindow(dfbWindow, true, !(appInfo->appFlags() & APP_SURFACE_DONTBLOCK));
+                event.instance->thumb()->addWindow(dfbWindow, false);
+            }
+            if (dfbWindow)
+                dfbWindow->Release(dfbWindow);
+            _appMan->instanceReady(event.instance);
+        }
+        break;
+
+    case WindowEvent::Remove:
+        ILOG_DEBUG(ILX_COMPOSITOR, "Remove (%d)\n", event.windowID);
+
+        if (event.instance->view())
+            event.instance->view()->removeWindow(event.windowID);
+
+        if (event.instance->thumb())
+            event.instance->thumb()->removeWindow(event.windowID);
+        break;
+
+    case WindowEvent::Config:
+    case WindowEvent::Restack:
+        ILOG_DEBUG(ILX_COMPOSITOR, "%s (%d)\n", event.type == WindowEvent::Config ? "Config" : "Restack", event.windowID);
+
+        if (event.instance->view())
+            event.instance->view()->onWindowConfig(event.windowID, &event.reconfig);
+        if (event.instance->thumb())
+            event.instance->thumb()->onWindowConfig(event.windowID, &event.reconfig);
+        break;
+
+    default:
+        break;
     }
 }
 
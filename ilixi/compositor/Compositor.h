@@ -30,6 +30,7 @@
 #include <compositor/OSKComponent.h>
 #include <compositor/SoundComponent.h>
 #include <compositor/Switcher.h>
+#include <compositor/WindowEventQueue.h>
 #include <lib/FPSCalculator.h>
 #include <core/Application.h>
 
@@ -45,6 +46,7 @@ class Label;
 class ILXCompositor : public Application
 {
     friend class ApplicationManager;
+    friend class MemoryMonitor;
     friend class CompositorComponent;
     friend class NotificationManager;
     friend class OSKComponent;
@@ -201,6 +203,15 @@ private:
     //! OSK instance.
     AppInstance* _osk;
 
+    //! Spare hardware layer used for showing a full-screen application directly, if any.
+    IDirectFBDisplayLayer* _scanoutLayer;
+    //! Own surface of scanout layer, restored when scanout ends.
+    IDirectFBSurface* _scanoutSurface;
+    //! Application instance shown on scanout layer.
+    AppInstance* _scanoutApp;
+    //! Window view whose source surface is shown on scanout layer.
+    SurfaceView* _scanoutView;
+
     //! PID of application which requested OSK input.
     pid_t _oskTargetPID;
     //! Bounding rectangle around current OSK input target.
@@ -209,15 +220,15 @@ private:
     //! This enum specifies a few window compositing related events.
     enum CompositorEventType
     {
-        CET_Add,        //!< Window added
-        CET_Remove,     //!< Window removed
-        CET_Config,     //!< Window configured
+        CET_Window,     //!< Window events are queued
         CET_Focus,      //!< Window focused
-        CET_Restack,    //!< Window restack
         CET_State,      //!< Window state
         CET_Quit,       //!< Application terminated
         CET_Term,       //!< Terminate application.
-        CET_Crash       //!< Application crashed.
+        CET_Crash,      //!< Application crashed.
+        CET_Memory,     //!< Memory pressure is reported by kernel.
+        CET_Child,      //!< Child process status changed.
+        CET_Scanout     //!< Scanout layer should be updated.
     };
 
     //! This struct specifies a CompositorEvent.
@@ -234,15 +245,11 @@ private:
     struct CompositorEventData
     {
         CompositorEventData()
-                : instance(NULL),
-                  windowID(0),
-                  reconfig(0)
+                : instance(NULL)
         {
         }
 
         AppInstance* instance;
-        DFBWindowID windowID;
-        SaWManWindowReconfig* reconfig;
     };
 
     //! This struct is used to store settings for compositor and its components.
@@ -276,8 +283,8 @@ private:
         DFBConvolutionFilter filter;                //!< Convolution filter.
         unsigned int notificationTimeout;           //!< Notification will hide itself after timeout(ms).
         bool memMonitor;
-        double memCritical;
-        double memLow;
+        double memCritical;                         //!< Memory is critical if available memory ratio is below this.
+        double memLow;                              //!< Memory is low if available memory ratio is below this.
         int pgCritical;
         int pgLow;
     };
@@ -285,6 +292,9 @@ private:
     //! This property is used by compositor components.
     CompositorSettings settings;
 
+    //! Window events posted by SaWMan callbacks.
+    WindowEventQueue _windowEvents;
+
     Rectangle _oskGeometry;
     Rectangle _appGeometry;
     Rectangle _barGeometry;
@@ -294,6 +304,27 @@ private:
     void
     onVisible();
 
+    /*!
+     * Returns true if given rectangle of view is completely covered by opaque views stacked above it.
+     */
+    bool
+    occluded(const AppView* view, const Rectangle& rect) const;
+
+    /*!
+     * Shows current application on scanout layer if its window covers application area,
+     * is opaque and no other compositor UI is visible above it. Otherwise reverts to composition.
+     *
+     * Scanout layer should be stacked above ui layer.
+     */
+    void
+    updateScanout();
+
+    /*!
+     * Shows given instance on scanout layer or reverts to composition if instance is NULL.
+     */
+    void
+    setScanout(AppInstance* instance);
+
     //! Returns a window on ui layer given a DFBWindowID if found, else return NULL.
     IDirectFBWindow*
     getWindow(DFBWindowID id);
@@ -325,6 +356,15 @@ private:
     virtual void
     handleUserEvent(const DFBUserEvent& event);
 
+    /*!
+     * Handles queued window events.
+     */
+    void
+    processWindowEvents();
+
+    void
+    handleWindowEvent(const WindowEvent& event);
+
     virtual bool
     windowPreEventFilter(const DFBWindowEvent& event);
 
@@ -26,6 +26,7 @@
 #include <compositor/NotificationManager.h>
 #include <compositor/ApplicationManager.h>
 #include <core/Logger.h>
+#include <types/Image.h>
 
 namespace ilixi
 {
@@ -57,6 +58,9 @@ CompositorComponent::CompositorComponent(ILXCompositor* compositor)
 CompositorComponent::~CompositorComponent()
 {
     delete _notificationMan;
+    for (SharedImageMap::iterator it = _sharedImages.begin(); it != _sharedImages.end(); ++it)
+        delete it->second;
+    _sharedImages.clear();
 }
 
 void
@@ -187,6 +191,16 @@ CompositorComponent::comaMethod(ComaMethodID method, void *arg)
         }
         break;
 
+    case Compositor::GetSharedImage:
+        {
+            Compositor::SharedImageData* data = (Compositor::SharedImageData*) arg;
+            data->path[255] = '\0';
+            data->surfaceID = sharedImage(data->path);
+            if (!data->surfaceID)
+                ret = DR_FAILURE;
+        }
+        break;
+
     case Compositor::GetAppList:
         ILOG_TRACE_F(ILX_COMPCOMP);
         sendAppList();
@@ -224,7 +238,8 @@ CompositorComponent::comaMethod(ComaMethodID method, void *arg)
 void
 CompositorComponent::notifyVisibility(AppInstance* instance, bool visible)
 {
-    if (instance->view() && !instance->view()->visible())
+    // Hidden notifications are sent after view is hidden, only filter visible ones.
+    if (visible && instance->view() && !instance->view()->visible())
         return;
 
     Compositor::VisibilityData vNo;
@@ -253,6 +268,38 @@ CompositorComponent::signalNotificationAck(int method, char* uuid, pid_t client)
     ILOG_DEBUG(ILX_COMPCOMP, "Sent NotificationAck[%d] to %d for UUID: %s\n", method, client, uuid);
 }
 
+DFBSurfaceID
+CompositorComponent::sharedImage(const char* path)
+{
+    ILOG_TRACE_F(ILX_COMPCOMP);
+    Image* image = NULL;
+    SharedImageMap::iterator it = _sharedImages.find(path);
+    if (it != _sharedImages.end())
+        image = it->second;
+    else
+    {
+        image = new Image(path);
+        if (!image->preferredSize().isValid())
+        {
+            ILOG_ERROR(ILX_COMPCOMP, "Cannot load shared image: %s\n", path);
+            delete image;
+            return 0;
+        }
+        _sharedImages.insert(std::make_pair(path, image));
+        ILOG_DEBUG(ILX_COMPCOMP, " -> Loaded shared image: %s\n", path);
+    }
+
+    IDirectFBSurface* surface = image->getDFBSurface();
+    DFBSurfaceID id = 0;
+    if (surface->GetID(surface, &id) != DFB_OK)
+    {
+        ILOG_ERROR(ILX_COMPCOMP, "Cannot get surface ID for shared image: %s\n", path);
+        return 0;
+    }
+    ILOG_DEBUG(ILX_COMPCOMP, " -> %s (DFBSurfaceID: %u)\n", path, id);
+    return id;
+}
+
 void
 CompositorComponent::parseOptions(xmlDocPtr doc)
 {
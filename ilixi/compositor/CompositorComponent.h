@@ -28,11 +28,13 @@
 #include <compositor/AppInstance.h>
 
 #include <libxml/tree.h>
+#include <map>
 
 namespace ilixi
 {
 
 class ILXCompositor;
+class Image;
 class NotificationManager;
 
 //! Compositor's ComaComponent.
@@ -118,6 +120,17 @@ public:
     void
     signalNotificationAck(int method, char* uuid, pid_t client);
 
+    /*!
+     * Returns the surface ID of an image which is shared with client applications.
+     *
+     * Image is loaded on first request and kept until compositor terminates.
+     * Returns 0 if image could not be loaded.
+     *
+     * @param path image file.
+     */
+    DFBSurfaceID
+    sharedImage(const char* path);
+
 protected:
     /*!
      * This method handles incoming IPC requests.
@@ -134,6 +147,10 @@ private:
     //! Used for managing and displaying incoming notifications.
     NotificationManager* _notificationMan;
 
+    typedef std::map<std::string, Image*> SharedImageMap;
+    //! Images loaded on behalf of client applications, e.g. theme packs.
+    SharedImageMap _sharedImages;
+
     //! Parses compositor options.
     void
     parseOptions(xmlDocPtr doc);
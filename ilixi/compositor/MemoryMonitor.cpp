@@ -23,15 +23,83 @@
 
 #include <compositor/MemoryMonitor.h>
 #include <compositor/ApplicationManager.h>
-#include <lib/Util.h>
+#include <compositor/Compositor.h>
+#include <core/Engine.h>
 #include <core/Logger.h>
-#include <fstream>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 namespace ilixi
 {
 
 D_DEBUG_DOMAIN( ILX_MEMORYMONITOR, "ilixi/compositor/MemMon", "MemoryMonitor");
 
+//! Low memory trigger, some tasks stalled for 100ms within 1s.
+static const char* __psiLow = "some 100000 1000000";
+//! Critical memory trigger, all tasks stalled for 100ms within 1s.
+static const char* __psiCritical = "full 100000 1000000";
+
+MemoryMonitor::PressureThread::PressureThread(MemoryMonitor* monitor, int lowFD, int criticalFD)
+        : Thread(),
+          _monitor(monitor),
+          _lowFD(lowFD),
+          _criticalFD(criticalFD)
+{
+}
+
+MemoryMonitor::PressureThread::~PressureThread()
+{
+    cancel();
+    close(_lowFD);
+    close(_criticalFD);
+}
+
+int
+MemoryMonitor::PressureThread::run()
+{
+    struct pollfd fds[2];
+    fds[0].fd = _lowFD;
+    fds[0].events = POLLPRI;
+    fds[1].fd = _criticalFD;
+    fds[1].events = POLLPRI;
+
+    while (true)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            ILOG_ERROR(ILX_MEMORYMONITOR, "poll() failed: %s\n", strerror(errno));
+            return 1;
+        }
+
+        if ((fds[0].revents | fds[1].revents) & POLLERR)
+        {
+            ILOG_ERROR(ILX_MEMORYMONITOR, "Pressure trigger is removed!\n");
+            return 1;
+        }
+
+        int state = (fds[1].revents & POLLPRI) ? Critical : Low;
+        int old;
+        do
+        {
+            old = _monitor->_pressure;
+            if (old <= state)
+                break;
+        } while (!__sync_bool_compare_and_swap(&_monitor->_pressure, old, state));
+
+        // Compositor samples memory state in main thread.
+        if (old == Normal)
+            Engine::instance().postUserEvent(ILXCompositor::CET_Memory);
+    }
+    return 0;
+}
+
 MemoryMonitor::MemoryMonitor(ApplicationManager* manager, float memCritical, float memLow, long unsigned int pgCritical, long unsigned int pgLow)
         : _manager(manager),
           _memCritical(memCritical),
@@ -39,16 +107,29 @@ MemoryMonitor::MemoryMonitor(ApplicationManager* manager, float memCritical, flo
           _pgCritical(pgCritical),
           _pgLow(pgLow),
           _pgPre(0),
-          _state(Normal)
+          _state(Normal),
+          _pressure(Normal),
+          _pressureThread(NULL)
 {
     ILOG_TRACE_F(ILX_MEMORYMONITOR);
-    _timer.start(4000);
+    _meminfoFD = open("/proc/meminfo", O_RDONLY | O_CLOEXEC);
+    if (_meminfoFD < 0)
+        ILOG_ERROR(ILX_MEMORYMONITOR, "Could not open /proc/meminfo: %s\n", strerror(errno));
+
     _timer.sigExec.connect(sigc::mem_fun(this, &MemoryMonitor::refresh));
+    if (!initPressure())
+        _timer.start(4000);
 }
 
 MemoryMonitor::~MemoryMonitor()
 {
     ILOG_TRACE_F(ILX_MEMORYMONITOR);
+    delete _pressureThread;
+    if (_meminfoFD >= 0)
+        close(_meminfoFD);
+    for (StatMap::iterator it = _statFDs.begin(); it != _statFDs.end(); ++it)
+        if (it->second >= 0)
+            close(it->second);
 }
 
 float
@@ -105,12 +186,50 @@ MemoryMonitor::getState() const
     return _state;
 }
 
+unsigned long
+MemoryMonitor::pss(pid_t pid)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/smaps_rollup", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0)
+    {
+        ssize_t len = readFile(fd);
+        close(fd);
+        if (len > 0)
+        {
+            const char* p = strstr(_buffer, "\nPss:");
+            if (p)
+                return strtoul(p + 5, NULL, 10);
+        }
+    }
+
+    // smaps_rollup is provided since Linux 4.14, use resident set size instead.
+    snprintf(path, sizeof(path), "/proc/%d/statm", pid);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return 0;
+    ssize_t len = readFile(fd);
+    close(fd);
+    if (len <= 0)
+        return 0;
+
+    const char* p = strchr(_buffer, ' ');
+    if (!p)
+        return 0;
+    return strtoul(p + 1, NULL, 10) * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
 void
 MemoryMonitor::refresh()
 {
     ILOG_TRACE_F(ILX_MEMORYMONITOR);
+    _state = (MemoryState) __sync_lock_test_and_set(&_pressure, (int) Normal);
     calcMemoryUsed();
-    calcPageFaults();
+    // Page fault rate is only meaningful for periodic samples.
+    if (!_pressureThread)
+        calcPageFaults();
+
     if (_state != Normal)
     {
         if (_state == Critical)
@@ -120,93 +239,170 @@ MemoryMonitor::refresh()
         sigStateChanged(_state);
         _timer.restart();
         _state = Normal;
-    } else
+    } else if (_pressureThread)
+        _timer.stop();
+    else
         _timer.setInterval(4000);
 }
 
-void
-MemoryMonitor::calcMemoryUsed()
+bool
+MemoryMonitor::initPressure()
 {
-    ILOG_TRACE_F(ILX_MEMORYMONITOR);
-    std::string line;
-    std::ifstream infile;
-    infile.open("/proc/meminfo", std::ifstream::in);
-    unsigned int total;
-    unsigned int free;
-    unsigned int cached;
-    unsigned int buffers;
-
-    while (infile.good())
+    int low = open("/proc/pressure/memory", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (low < 0)
     {
-        std::string tagbuffer;
-        std::string item;
-        bool readingItem = false;
-        getline(infile, line);
-        for (unsigned int i = 0; i < line.length(); i++)
-        {
-            if (line[i] != ':' && readingItem == false)
-                tagbuffer.append(1, line[i]);
-            else if (line[i] == ':')
-            {
-                readingItem = true;
-                i++;
-            }
-            if (readingItem)
-                item.append(1, line[i]);
-        }
+        ILOG_DEBUG(ILX_MEMORYMONITOR, " -> PSI is not available, using timer.\n");
+        return false;
+    }
 
-        if (tagbuffer.find("MemTotal", 0) != std::string::npos)
-            sscanf(item.c_str(), "%u %*s", &total);
+    int critical = open("/proc/pressure/memory", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (critical < 0 || write(low, __psiLow, strlen(__psiLow) + 1) < 0 || write(critical, __psiCritical, strlen(__psiCritical) + 1) < 0)
+    {
+        ILOG_WARNING(ILX_MEMORYMONITOR, "Could not set memory pressure triggers (%s), using timer.\n", strerror(errno));
+        close(low);
+        if (critical >= 0)
+            close(critical);
+        return false;
+    }
 
-        else if (tagbuffer.find("MemFree", 0) != std::string::npos)
-            sscanf(item.c_str(), "%u %*s", &free);
+    _pressureThread = new PressureThread(this, low, critical);
+    if (!_pressureThread->start())
+    {
+        delete _pressureThread;
+        _pressureThread = NULL;
+        return false;
+    }
+    ILOG_DEBUG(ILX_MEMORYMONITOR, " -> Using memory pressure triggers.\n");
+    return true;
+}
 
-        else if (tagbuffer.find("Buffers", 0) != std::string::npos)
-            sscanf(item.c_str(), "%u %*s", &buffers);
+ssize_t
+MemoryMonitor::readFile(int fd)
+{
+    if (fd < 0)
+        return -1;
 
-        else if (tagbuffer.find("Cached", 0) != std::string::npos)
+    ssize_t len = pread(fd, _buffer, sizeof(_buffer) - 1, 0);
+    if (len < 0)
+        return -1;
+
+    _buffer[len] = 0;
+    return len;
+}
+
+void
+MemoryMonitor::raiseState(MemoryState state)
+{
+    if (state < _state)
+        _state = state;
+}
+
+void
+MemoryMonitor::calcMemoryUsed()
+{
+    ILOG_TRACE_F(ILX_MEMORYMONITOR);
+    if (readFile(_meminfoFD) <= 0)
+        return;
+
+    unsigned long total = 0;
+    unsigned long available = 0;
+    unsigned long free = 0;
+    unsigned long buffers = 0;
+    unsigned long cached = 0;
+    bool hasAvailable = false;
+
+    const char* line = _buffer;
+    while (line && *line)
+    {
+        if (strncmp(line, "MemTotal:", 9) == 0)
+            total = strtoul(line + 9, NULL, 10);
+        else if (strncmp(line, "MemFree:", 8) == 0)
+            free = strtoul(line + 8, NULL, 10);
+        else if (strncmp(line, "MemAvailable:", 13) == 0)
         {
-            sscanf(item.c_str(), "%u %*s", &cached);
+            available = strtoul(line + 13, NULL, 10);
+            hasAvailable = true;
+        } else if (strncmp(line, "Buffers:", 8) == 0)
+            buffers = strtoul(line + 8, NULL, 10);
+        else if (strncmp(line, "Cached:", 7) == 0)
+        {
+            cached = strtoul(line + 7, NULL, 10);
             break;
         }
 
+        line = strchr(line, '\n');
+        if (line)
+            ++line;
     }
-    infile.close();
 
-    double used = (buffers + cached + .0) / total;
-    ILOG_DEBUG(ILX_MEMORYMONITOR, " -> Used: %f\n", used);
-    if (used > _memCritical)
-        _state = Critical;
-    else if (used > _memLow)
-        _state = Low;
+    if (!total)
+        return;
+
+    // Buffers and page cache are reclaimable, MemAvailable is provided since Linux 3.14.
+    if (!hasAvailable)
+        available = free + buffers + cached;
+
+    double ratio = (available + .0) / total;
+    ILOG_DEBUG(ILX_MEMORYMONITOR, " -> Available: %f\n", ratio);
+    if (ratio < _memCritical)
+        raiseState(Critical);
+    else if (ratio < _memLow)
+        raiseState(Low);
 }
 
 void
 MemoryMonitor::calcPageFaults()
 {
     ILOG_TRACE_F(ILX_MEMORYMONITOR);
-    std::string line;
-    std::ifstream infile;
-    int faults;
     int sum = 0;
 
+    pthread_mutex_lock(&_manager->_mutex);
     for (AppInstanceList::iterator it = _manager->_instances.begin(); it != _manager->_instances.end(); ++it)
     {
-        infile.open(PrintF("/proc/%d/stat", ((AppInstance*) *it)->pid()).c_str(), std::ifstream::in);
-        getline(infile, line);
-        sscanf(line.c_str(), "%*d %*s %*c %*d %*d %*d %*d %*d %*d %*d %*d %d %*s", &faults);
+        pid_t pid = ((AppInstance*) *it)->pid();
+        StatMap::iterator fd = _statFDs.find(pid);
+        if (fd == _statFDs.end())
+        {
+            char path[32];
+            snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+            fd = _statFDs.insert(std::make_pair(pid, open(path, O_RDONLY | O_CLOEXEC))).first;
+        }
+
+        if (readFile(fd->second) <= 0)
+            continue;
+
+        // majflt is the 10th field after command name.
+        const char* p = strrchr(_buffer, ')');
+        for (int field = 0; p && field < 10; ++field)
+            p = strchr(p + 1, ' ');
+        if (!p)
+            continue;
+
+        int faults = strtol(p + 1, NULL, 10);
         sum += faults;
-        infile.close();
-        ILOG_DEBUG(ILX_MEMORYMONITOR, "   -> %s [%d] faults: %d\n", ((AppInstance*) *it)->appInfo()->name().c_str(), ((AppInstance*) *it)->pid(), faults);
+        ILOG_DEBUG(ILX_MEMORYMONITOR, "   -> %s [%d] faults: %d\n", ((AppInstance*) *it)->appInfo()->name().c_str(), pid, faults);
+    }
+
+    // Close files of exited instances.
+    for (StatMap::iterator it = _statFDs.begin(); it != _statFDs.end();)
+    {
+        if (_manager->_pidIndex.find(it->first) == _manager->_pidIndex.end())
+        {
+            if (it->second >= 0)
+                close(it->second);
+            _statFDs.erase(it++);
+        } else
+            ++it;
     }
+    pthread_mutex_unlock(&_manager->_mutex);
 
     ILOG_DEBUG(ILX_MEMORYMONITOR, " -> sum: %d\n", sum);
 
     int dif = sum - _pgPre;
     if (dif > _pgCritical)
-        _state = Critical;
+        raiseState(Critical);
     else if (dif > _pgLow)
-        _state = Low;
+        raiseState(Low);
     ILOG_DEBUG(ILX_MEMORYMONITOR, " -> dif. page_faults: %d\n", dif);
     _pgPre = sum;
 }
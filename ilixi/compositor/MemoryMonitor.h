@@ -24,8 +24,11 @@
 #ifndef ILIXI_MEMORYMONITOR_H_
 #define ILIXI_MEMORYMONITOR_H_
 
+#include <lib/Thread.h>
 #include <lib/Timer.h>
 #include <sigc++/signal.h>
+#include <sys/types.h>
+#include <map>
 
 namespace ilixi
 {
@@ -33,6 +36,11 @@ namespace ilixi
 class ApplicationManager;
 
 //! Tracks changes in memory for OOM.
+/*!
+ * If kernel supports pressure stall information (/proc/pressure/memory), monitor
+ * sleeps until a pressure trigger fires and samples memory until it is Normal again.
+ * Otherwise, memory usage and page faults are sampled periodically.
+ */
 class MemoryMonitor
 {
 public:
@@ -109,12 +117,44 @@ public:
     MemoryState
     getState() const;
 
+    /*!
+     * Returns proportional set size of a process in kB, or 0 if it can not be read.
+     */
+    unsigned long
+    pss(pid_t pid);
+
+    /*!
+     * Samples memory state and emits sigStateChanged if memory is not Normal.
+     */
+    void
+    refresh();
+
     /*!
      * This signal is emitted when a state change from Normal to Low or Critical happens.
      */
     sigc::signal<void, MemoryState> sigStateChanged;
 
 private:
+    //! Waits for memory pressure triggers.
+    class PressureThread : public Thread
+    {
+    public:
+        PressureThread(MemoryMonitor* monitor, int lowFD, int criticalFD);
+
+        virtual
+        ~PressureThread();
+
+        virtual int
+        run();
+
+    private:
+        MemoryMonitor* _monitor;
+        int _lowFD;
+        int _criticalFD;
+    };
+
+    typedef std::map<pid_t, int> StatMap;
+
     //! Owner.
     ApplicationManager* _manager;
     //! This property stores critical memory usage threshold.
@@ -131,10 +171,28 @@ private:
     MemoryState _state;
     //! This timer is executed at various intervals.
     Timer _timer;
-
-    //! Timer slot.
+    //! Memory state reported by pressure triggers, accessed atomically.
+    volatile int _pressure;
+    //! Pressure trigger thread or NULL if PSI is not supported.
+    PressureThread* _pressureThread;
+    //! Open /proc/meminfo.
+    int _meminfoFD;
+    //! Open /proc/<pid>/stat of instances.
+    StatMap _statFDs;
+    //! Buffer for reading proc files.
+    char _buffer[4096];
+
+    //! Sets up pressure triggers, returns false if PSI is not available.
+    bool
+    initPressure();
+
+    //! Reads file at offset 0 into _buffer and returns number of bytes read or -1.
+    ssize_t
+    readFile(int fd);
+
+    //! Sets state if it is more severe than current state.
     void
-    refresh();
+    raiseState(MemoryState state);
 
     //! Tracks memory usage.
     void
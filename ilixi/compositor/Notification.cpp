@@ -136,7 +136,8 @@ Notification::show()
         _tweenZ->setEndValue(1);
         _seq.start();
         _timer.start(_compositor->settings.notificationTimeout, 1);
-        PlatformManager::instance().playSoundEffect("Notification");
+        static const int __notificationEffect = PlatformManager::instance().soundEffectID("Notification");
+        PlatformManager::instance().playSoundEffect(__notificationEffect);
         setVisible(true);
     }
 }
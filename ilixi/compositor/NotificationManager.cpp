@@ -24,6 +24,7 @@
 #include <compositor/NotificationManager.h>
 #include <compositor/Notification.h>
 #include <compositor/Compositor.h>
+#include <core/Engine.h>
 #include <core/Logger.h>
 #include <algorithm>
 
@@ -160,6 +161,7 @@ NotificationManager::updateNotifications()
         if (arrange && _active.size() > 1)
             arrangeNotifications(i * _active.front()->preferredSize().height());
     }
+    _compositor->updateScanout();
 }
 
 bool
@@ -208,6 +210,8 @@ NotificationManager::replaceActive(Notification* notification)
             _compositor->removeWidget(old);
             notification->show();
             pthread_mutex_unlock(&_activeMutex);
+            // Scanout layer is only changed in main thread.
+            Engine::instance().postUserEvent(ILXCompositor::CET_Scanout);
             return true;
         }
         ++it;
@@ -32,17 +32,52 @@ namespace ilixi
 
 D_DEBUG_DOMAIN( ILX_SOUNDCOMP, "ilixi/Coma/SoundMixer", "SoundComponent");
 
+SoundComponent::EffectThread::EffectThread(SoundEffectQueue* queue)
+        : Thread(),
+          _queue(queue)
+{
+}
+
+SoundComponent::EffectThread::~EffectThread()
+{
+    cancel();
+}
+
+int
+SoundComponent::EffectThread::run()
+{
+    unsigned int id;
+    while (true)
+    {
+        if (_queue->pop(&id, 250))
+        {
+            ILOG_DEBUG(ILX_SOUNDCOMP, " -> PlaySoundEffect [%u]\n", id);
+            PlatformManager::instance().playSoundEffect((int) id);
+        }
+        pthread_testcancel();
+    }
+    return 0;
+}
+
 SoundComponent::SoundComponent()
         : ComaComponent("SoundMixer", SoundMixer::SMNumNotifications),
-          _volume(1)
+          _volume(1),
+          _effectThread(NULL)
 {
     init();
     createNotification(SoundMixer::VolumeChanged, NULL);
     SoundDFB::setMasterVolume(1);
+
+    if (_effects.create(PlatformManager::instance().soundEffectSignature()))
+    {
+        _effectThread = new EffectThread(&_effects);
+        _effectThread->start();
+    }
 }
 
 SoundComponent::~SoundComponent()
 {
+    delete _effectThread;
 }
 
 DirectResult
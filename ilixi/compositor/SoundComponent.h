@@ -25,6 +25,8 @@
 #define ILIXI_SOUNDCOMPONENT_H_
 
 #include <core/ComaComponent.h>
+#include <core/SoundEffectQueue.h>
+#include <lib/Thread.h>
 
 namespace ilixi
 {
@@ -60,8 +62,28 @@ protected:
     comaMethod(ComaMethodID method, void *arg);
 
 private:
+    //! Plays sound effects pushed by applications.
+    class EffectThread : public Thread
+    {
+    public:
+        EffectThread(SoundEffectQueue* queue);
+
+        virtual
+        ~EffectThread();
+
+        virtual int
+        run();
+
+    private:
+        SoundEffectQueue* _queue;
+    };
+
     //! This property stores master output volume.
     float _volume;
+    //! Sound effect triggers from applications.
+    SoundEffectQueue _effects;
+    //! Consumer of sound effect queue.
+    EffectThread* _effectThread;
 };
 
 } /* namespace ilixi */
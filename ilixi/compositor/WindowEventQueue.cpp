@@ -0,0 +1,161 @@
+/*
+ Copyright 2010-2015 Tarik Sekmen.
+
+ All Rights Reserved.
+
+ Written by Tarik Sekmen <tarik@ilixi.org>.
+
+ This file is part of ilixi.
+
+ ilixi is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ ilixi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <compositor/WindowEventQueue.h>
+#include <core/Logger.h>
+
+namespace ilixi
+{
+
+D_DEBUG_DOMAIN( ILX_WINDOWEVENTQUEUE, "ilixi/compositor/WindowEventQueue", "WindowEventQueue");
+
+WindowEventQueue::WindowEventQueue(unsigned int capacity)
+        : _events(NULL),
+          _mask(0),
+          _head(0),
+          _tail(0),
+          _signalled(0),
+          _overflowed(false)
+{
+    ILOG_TRACE(ILX_WINDOWEVENTQUEUE);
+    unsigned int size = 1;
+    while (size < capacity)
+        size <<= 1;
+    _events = new WindowEvent[size];
+    _mask = size - 1;
+    pthread_mutex_init(&_overflowMutex, NULL);
+}
+
+WindowEventQueue::~WindowEventQueue()
+{
+    ILOG_TRACE(ILX_WINDOWEVENTQUEUE);
+    delete[] _events;
+    pthread_mutex_destroy(&_overflowMutex);
+}
+
+bool
+WindowEventQueue::push(const WindowEvent& event)
+{
+    // Once overflow is used, events keep going there until consumer empties it, so order is preserved.
+    unsigned int head = _head;
+    if (!_overflowed && head - _tail <= _mask)
+    {
+        _events[head & _mask] = event;
+        __sync_synchronize();
+        _head = head + 1;
+    } else
+    {
+        pthread_mutex_lock(&_overflowMutex);
+        if (!_overflowed)
+            ILOG_WARNING(ILX_WINDOWEVENTQUEUE, "Ring is full, using overflow!\n");
+        _overflow.push_back(event);
+        _overflowed = true;
+        pthread_mutex_unlock(&_overflowMutex);
+    }
+    return __sync_bool_compare_and_swap(&_signalled, 0, 1);
+}
+
+void
+WindowEventQueue::acknowledge()
+{
+    __sync_lock_release(&_signalled);
+    __sync_synchronize();
+}
+
+bool
+WindowEventQueue::pop(WindowEvent* event)
+{
+    unsigned int tail = _tail;
+    if (tail != _head)
+    {
+        __sync_synchronize();
+        *event = _events[tail & _mask];
+        ++tail;
+
+        if (mergeable(*event))
+        {
+            while (tail != _head)
+            {
+                __sync_synchronize();
+                const WindowEvent& next = _events[tail & _mask];
+                if (!mergeable(next) || next.windowID != event->windowID)
+                    break;
+                merge(event, next);
+                ++tail;
+            }
+        }
+
+        __sync_synchronize();
+        _tail = tail;
+        return true;
+    }
+
+    if (!_overflowed)
+        return false;
+
+    bool ret = false;
+    pthread_mutex_lock(&_overflowMutex);
+    if (!_overflow.empty())
+    {
+        *event = _overflow.front();
+        _overflow.pop_front();
+        ret = true;
+    }
+    if (_overflow.empty())
+        _overflowed = false;
+    pthread_mutex_unlock(&_overflowMutex);
+    return ret;
+}
+
+void
+WindowEventQueue::merge(WindowEvent* event, const WindowEvent& newer)
+{
+    SaWManWindowReconfig reconfig = newer.reconfig;
+
+    if ((event->reconfig.flags & SWMCF_POSITION) && !(newer.reconfig.flags & SWMCF_POSITION))
+    {
+        reconfig.request.bounds.x = event->reconfig.request.bounds.x;
+        reconfig.request.bounds.y = event->reconfig.request.bounds.y;
+    }
+
+    if ((event->reconfig.flags & SWMCF_SIZE) && !(newer.reconfig.flags & SWMCF_SIZE))
+    {
+        reconfig.request.bounds.w = event->reconfig.request.bounds.w;
+        reconfig.request.bounds.h = event->reconfig.request.bounds.h;
+    }
+
+    if ((event->reconfig.flags & SWMCF_OPACITY) && !(newer.reconfig.flags & SWMCF_OPACITY))
+        reconfig.request.opacity = event->reconfig.request.opacity;
+
+    reconfig.flags = (SaWManWindowConfigFlags) (event->reconfig.flags | newer.reconfig.flags);
+    event->reconfig = reconfig;
+    ILOG_DEBUG(ILX_WINDOWEVENTQUEUE, " -> Merged configuration of window %u\n", event->windowID);
+}
+
+bool
+WindowEventQueue::mergeable(const WindowEvent& event)
+{
+    return event.type == WindowEvent::Config && !(event.reconfig.flags & SWMCF_STACKING);
+}
+
+} /* namespace ilixi */
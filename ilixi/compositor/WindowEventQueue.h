@@ -0,0 +1,130 @@
+/*
+ Copyright 2010-2015 Tarik Sekmen.
+
+ All Rights Reserved.
+
+ Written by Tarik Sekmen <tarik@ilixi.org>.
+
+ This file is part of ilixi.
+
+ ilixi is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ ilixi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ILIXI_WINDOWEVENTQUEUE_H_
+#define ILIXI_WINDOWEVENTQUEUE_H_
+
+#include <sawman.h>
+#include <pthread.h>
+#include <deque>
+
+namespace ilixi
+{
+
+class AppInstance;
+
+//! This struct carries a SaWMan window event to compositor's main thread.
+struct WindowEvent
+{
+    //! This enum specifies window event types.
+    enum Type
+    {
+        Add,        //!< Window added
+        Remove,     //!< Window removed
+        Config,     //!< Window configured
+        Restack     //!< Window restacked
+    };
+
+    Type type;
+    AppInstance* instance;
+    DFBWindowID windowID;
+    SaWManWindowReconfig reconfig;
+};
+
+//! Passes window events from SaWMan callbacks to compositor's main thread.
+/*!
+ * Events are stored in a preallocated ring which is written by a single producer (SaWMan callback thread)
+ * and read by a single consumer (main thread) without locking. If ring is full, events are stored in an
+ * overflow list until consumer catches up, so producer never blocks.
+ *
+ * Consecutive configuration events of the same window are merged when they are read.
+ */
+class WindowEventQueue
+{
+public:
+    /*!
+     * Constructor.
+     *
+     * @param capacity number of events in ring, rounded up to a power of two.
+     */
+    WindowEventQueue(unsigned int capacity = 256);
+
+    /*!
+     * Destructor.
+     */
+    ~WindowEventQueue();
+
+    /*!
+     * Adds an event to queue, called by producer.
+     *
+     * Returns true if consumer should be woken up, i.e. this is the first event since consumer acknowledged.
+     */
+    bool
+    push(const WindowEvent& event);
+
+    /*!
+     * Marks queue as seen so next push() wakes up consumer again, called by consumer before reading events.
+     */
+    void
+    acknowledge();
+
+    /*!
+     * Removes next event from queue, called by consumer. Returns false if queue is empty.
+     */
+    bool
+    pop(WindowEvent* event);
+
+private:
+    //! This property stores preallocated events.
+    WindowEvent* _events;
+    //! Capacity - 1.
+    unsigned int _mask;
+    //! Next slot to write, modified by producer only.
+    volatile unsigned int _head;
+    //! Next slot to read, modified by consumer only.
+    volatile unsigned int _tail;
+    //! Set once a wake up is requested, cleared by acknowledge().
+    volatile int _signalled;
+
+    //! Events which did not fit into ring.
+    std::deque<WindowEvent> _overflow;
+    //! Set by producer once overflow is used, cleared by consumer once overflow is empty.
+    volatile bool _overflowed;
+    //! Serialises access to overflow.
+    pthread_mutex_t _overflowMutex;
+
+    /*!
+     * Merges newer configuration of same window into event.
+     */
+    static void
+    merge(WindowEvent* event, const WindowEvent& newer);
+
+    /*!
+     * Returns true if event can be merged with a following configuration.
+     */
+    static bool
+    mergeable(const WindowEvent& event);
+};
+
+} /* namespace ilixi */
+#endif /* ILIXI_WINDOWEVENTQUEUE_H_ */
@@ -0,0 +1,288 @@
+/*
+ Copyright 2010-2015 Tarik Sekmen.
+
+ All Rights Reserved.
+
+ Written by Tarik Sekmen <tarik@ilixi.org>.
+
+ This file is part of ilixi.
+
+ ilixi is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ ilixi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <compositor/Zygote.h>
+#include <compositor/AppInfo.h>
+#include <core/Logger.h>
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ilixi
+{
+
+D_DEBUG_DOMAIN( ILX_ZYGOTE, "ilixi/compositor/Zygote", "Zygote");
+
+Zygote::ReplyThread::ReplyThread(Zygote* zygote)
+        : Thread(),
+          _zygote(zygote)
+{
+}
+
+Zygote::ReplyThread::~ReplyThread()
+{
+    cancel();
+}
+
+int
+Zygote::ReplyThread::run()
+{
+    while (true)
+    {
+        pid_t pid = -1;
+        ssize_t ret = recv(_zygote->_socket, &pid, sizeof(pid), 0);
+        if (ret == -1 && errno == EINTR)
+            continue;
+
+        // Do not cancel while a reply is handled.
+        int state;
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &state);
+        if (ret != sizeof(pid))
+        {
+            ILOG_ERROR(ILX_ZYGOTE, "Launcher exited, pending requests failed!\n");
+            RequestList requests;
+            pthread_mutex_lock(&_zygote->_lock);
+            _zygote->_alive = 0;
+            requests.swap(_zygote->_requests);
+            pthread_mutex_unlock(&_zygote->_lock);
+
+            for (RequestList::iterator it = requests.begin(); it != requests.end(); ++it)
+                _zygote->sigLaunched(*it, -1);
+            pthread_setcancelstate(state, NULL);
+            return 1;
+        }
+
+        AppInfo* info = NULL;
+        pthread_mutex_lock(&_zygote->_lock);
+        if (!_zygote->_requests.empty())
+        {
+            info = _zygote->_requests.front();
+            _zygote->_requests.pop_front();
+        }
+        pthread_mutex_unlock(&_zygote->_lock);
+
+        if (info)
+        {
+            ILOG_DEBUG(ILX_ZYGOTE, " -> Launched %s (%d)\n", info->name().c_str(), pid);
+            _zygote->sigLaunched(info, pid);
+        }
+        pthread_setcancelstate(state, NULL);
+    }
+    return 0;
+}
+
+Zygote::Zygote()
+        : _pid(-1),
+          _socket(-1),
+          _alive(0),
+          _thread(NULL)
+{
+    ILOG_TRACE_F(ILX_ZYGOTE);
+    pthread_mutex_init(&_lock, NULL);
+}
+
+Zygote::~Zygote()
+{
+    ILOG_TRACE_F(ILX_ZYGOTE);
+    stop();
+    pthread_mutex_destroy(&_lock);
+}
+
+bool
+Zygote::start()
+{
+    ILOG_TRACE_F(ILX_ZYGOTE);
+    if (running())
+        return true;
+
+#ifndef PR_SET_CHILD_SUBREAPER
+    ILOG_ERROR(ILX_ZYGOTE, "PR_SET_CHILD_SUBREAPER is not supported!\n");
+    return false;
+#else
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) == -1)
+    {
+        ILOG_ERROR(ILX_ZYGOTE, "Cannot create socket pair: %s\n", strerror(errno));
+        return false;
+    }
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+
+    // Closed by a successful exec, otherwise child writes errno to it.
+    int status[2];
+    if (pipe(status) == -1)
+    {
+        ILOG_ERROR(ILX_ZYGOTE, "Cannot create status pipe: %s\n", strerror(errno));
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    fcntl(status[0], F_SETFD, FD_CLOEXEC);
+    fcntl(status[1], F_SETFD, FD_CLOEXEC);
+
+    char fd[16];
+    snprintf(fd, sizeof(fd), "%d", fds[1]);
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        execl(ILIXI_BINDIR ILIXI_ZYGOTE_EXEC, ILIXI_ZYGOTE_EXEC, fd, (char*) NULL);
+        int err = errno;
+        ssize_t ret = write(status[1], &err, sizeof(err));
+        (void) ret;
+        _exit(1);
+    }
+
+    close(fds[1]);
+    close(status[1]);
+    if (pid == -1)
+    {
+        ILOG_ERROR(ILX_ZYGOTE, "Cannot fork: %s\n", strerror(errno));
+        close(fds[0]);
+        close(status[0]);
+        return false;
+    }
+
+    int err = 0;
+    ssize_t ret;
+    do
+        ret = read(status[0], &err, sizeof(err));
+    while (ret == -1 && errno == EINTR);
+    close(status[0]);
+    if (ret == sizeof(err))
+    {
+        ILOG_ERROR(ILX_ZYGOTE, "Cannot execute %s: %s\n", ILIXI_BINDIR ILIXI_ZYGOTE_EXEC, strerror(err));
+        close(fds[0]);
+        return false;
+    }
+
+    _socket = fds[0];
+    _pid = pid;
+    ILOG_DEBUG(ILX_ZYGOTE, " -> Launcher pid: %d\n", _pid);
+
+    if (prctl(PR_SET_CHILD_SUBREAPER, 1, 0, 0, 0) == -1)
+    {
+        ILOG_ERROR(ILX_ZYGOTE, "Cannot become child subreaper: %s\n", strerror(errno));
+        stop();
+        return false;
+    }
+
+    _alive = 1;
+    _thread = new ReplyThread(this);
+    if (!_thread->start())
+    {
+        ILOG_ERROR(ILX_ZYGOTE, "Cannot start reply thread!\n");
+        stop();
+        return false;
+    }
+    return true;
+#endif
+}
+
+void
+Zygote::stop()
+{
+    ILOG_TRACE_F(ILX_ZYGOTE);
+    delete _thread;
+    _thread = NULL;
+    _alive = 0;
+    _requests.clear();
+
+    if (_socket != -1)
+    {
+        close(_socket);
+        _socket = -1;
+    }
+
+    if (_pid > 0)
+    {
+        kill(_pid, SIGTERM);
+        _pid = -1;
+    }
+}
+
+bool
+Zygote::running() const
+{
+    return _alive;
+}
+
+bool
+Zygote::launch(AppInfo* info)
+{
+    ILOG_TRACE_F(ILX_ZYGOTE);
+    if (!running())
+        return false;
+
+    const std::string& path = info->path();
+    const std::string& args = info->args();
+
+    // Request is a list of NUL terminated strings; path followed by arguments.
+    char request[ILIXI_ZYGOTE_REQUEST_SIZE];
+    size_t length = path.length() + 1;
+    if (length + args.length() + 1 > sizeof(request))
+    {
+        ILOG_ERROR(ILX_ZYGOTE, "Launch request for %s is too long!\n", path.c_str());
+        return false;
+    }
+    memcpy(request, path.c_str(), length);
+
+    char str[ILIXI_ZYGOTE_REQUEST_SIZE];
+    strncpy(str, args.c_str(), sizeof(str) - 1);
+    str[sizeof(str) - 1] = 0;
+    for (char* p = strtok(str, " "); p != NULL; p = strtok(NULL, " "))
+    {
+        size_t size = strlen(p) + 1;
+        memcpy(request + length, p, size);
+        length += size;
+    }
+
+    // Request is queued with send, so replies are matched in order.
+    pthread_mutex_lock(&_lock);
+    bool sent = _alive && send(_socket, request, length, MSG_NOSIGNAL) == (ssize_t) length;
+    if (sent)
+        _requests.push_back(info);
+    pthread_mutex_unlock(&_lock);
+
+    if (!sent)
+        ILOG_ERROR(ILX_ZYGOTE, "Cannot send launch request for %s!\n", path.c_str());
+    return sent;
+}
+
+bool
+Zygote::pending(AppInfo* info)
+{
+    pthread_mutex_lock(&_lock);
+    bool found = std::find(_requests.begin(), _requests.end(), info) != _requests.end();
+    pthread_mutex_unlock(&_lock);
+    return found;
+}
+
+} /* namespace ilixi */
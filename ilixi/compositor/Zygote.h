@@ -0,0 +1,149 @@
+/*
+ Copyright 2010-2015 Tarik Sekmen.
+
+ All Rights Reserved.
+
+ Written by Tarik Sekmen <tarik@ilixi.org>.
+
+ This file is part of ilixi.
+
+ ilixi is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ ilixi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ILIXI_ZYGOTE_H_
+#define ILIXI_ZYGOTE_H_
+
+#include <lib/Thread.h>
+#include <list>
+#include <string>
+#include <sys/types.h>
+
+//! Name of launcher executable.
+#define ILIXI_ZYGOTE_EXEC "ilixi_zygote"
+//! Entry point looked up in applications loaded by launcher.
+#define ILIXI_ZYGOTE_MAIN "ilixi_main"
+//! Maximum size of a launch request.
+#define ILIXI_ZYGOTE_REQUEST_SIZE 4096
+
+namespace ilixi
+{
+class AppInfo;
+
+//! Launches applications by forking a pre-initialised process.
+/*!
+ * Zygote starts ilixi_zygote, a launcher process which has ilixi and its dependencies loaded and
+ * fontconfig initialised. Launcher waits for requests on a socket and forks a new process for each
+ * request. Forked process loads application module from ILIXI_ZYGOTEDIR using dlopen() and calls its
+ * ILIXI_ZYGOTE_MAIN entry point. If there is no module, application is started using execvp().
+ *
+ * Applications provide a module by exporting ILIXI_ZYGOTE_MAIN and building their sources as a
+ * libtool module installed to ILIXI_ZYGOTEDIR, e.g. apps/calc.
+ *
+ * Launched applications are reparented to compositor, so compositor receives SIGCHLD as if it had
+ * forked them itself. This requires PR_SET_CHILD_SUBREAPER support.
+ *
+ * Requests are sent without waiting, launcher replies with process IDs in request order. Replies are
+ * read by a thread which emits sigLaunched.
+ *
+ * Applications opt in using APP_ZYGOTE flag.
+ */
+class Zygote
+{
+public:
+    /*!
+     * Constructor.
+     */
+    Zygote();
+
+    /*!
+     * Destructor.
+     *
+     * Stops launcher process.
+     */
+    ~Zygote();
+
+    /*!
+     * Starts launcher process. Returns true if successful.
+     */
+    bool
+    start();
+
+    /*!
+     * Terminates launcher process.
+     */
+    void
+    stop();
+
+    /*!
+     * Returns true if launcher process is running.
+     */
+    bool
+    running() const;
+
+    /*!
+     * Sends a launch request for an application. Returns false if request can not be sent.
+     *
+     * Result is reported using sigLaunched.
+     */
+    bool
+    launch(AppInfo* info);
+
+    /*!
+     * Returns true if a launch request for application is not replied yet.
+     */
+    bool
+    pending(AppInfo* info);
+
+    /*!
+     * This signal is emitted from reply thread when launcher replies to a request.
+     *
+     * Process ID is -1 if launch failed or launcher exited.
+     */
+    sigc::signal<void, AppInfo*, pid_t> sigLaunched;
+
+private:
+    //! Reads process IDs sent by launcher.
+    class ReplyThread : public Thread
+    {
+    public:
+        ReplyThread(Zygote* zygote);
+
+        virtual
+        ~ReplyThread();
+
+        virtual int
+        run();
+
+    private:
+        Zygote* _zygote;
+    };
+
+    typedef std::list<AppInfo*> RequestList;
+
+    //! Launcher process ID.
+    pid_t _pid;
+    //! Socket connected to launcher.
+    int _socket;
+    //! Set while launcher accepts requests, cleared by reply thread if launcher exits.
+    volatile int _alive;
+    //! Reply thread.
+    ReplyThread* _thread;
+    //! Requests waiting for a reply, in order.
+    RequestList _requests;
+    //! This locks socket writes and request list.
+    pthread_mutex_t _lock;
+};
+
+} /* namespace ilixi */
+#endif /* ILIXI_ZYGOTE_H_ */
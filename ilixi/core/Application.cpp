@@ -26,6 +26,7 @@
 #include <core/Engine.h>
 #include <core/Logger.h>
 #include <core/PlatformManager.h>
+#include <core/Profiler.h>
 
 #include <graphics/Stylist.h>
 
@@ -41,6 +42,11 @@ D_DEBUG_DOMAIN( ILX_APPLICATION_TIMER, "ilixi/core/Application/Timers", "Applica
 D_DEBUG_DOMAIN( ILX_APPLICATION_UPDATES, "ilixi/core/Application/Updates", "Application Updates");
 D_DEBUG_DOMAIN( ILX_APPLICATION_EVENTS, "ilixi/core/Application/Events", "Application Events");
 
+//! Interval for timers and callbacks while hidden by compositor.
+static const unsigned int __backgroundInterval = 1000;
+//! Interval for window updates, timers and callbacks with OptBackgroundLowRate.
+static const unsigned int __lowRateInterval = 250;
+
 Application* Application::__instance = NULL;
 
 Application::Application(int* argc, char*** argv, AppOptions opts)
@@ -48,7 +54,9 @@ Application::Application(int* argc, char*** argv, AppOptions opts)
           _appWindow(NULL),
           __flags(APS_HIDDEN),
           __activeWindow(NULL),
-          _frameTime(0)
+          _frameTime(0),
+          __background(false),
+          _backgroundPaint(0)
 {
     ILOG_TRACE_F(ILX_APPLICATION);
 
@@ -167,8 +175,10 @@ Application::exec()
             break;
         else
         {
-            __instance->handleEvents(Engine::instance().cycle());
-            updateWindows();
+            updateBackgroundState();
+            __instance->handleEvents(Engine::instance().cycle(), __flags & APS_BACKGROUND);
+            if (!(__flags & APS_BACKGROUND) || backgroundPaintDue())
+                updateWindows();
         }
     }
 
@@ -382,6 +392,7 @@ void
 Application::handleEvents(int32_t timeout, bool forceWait)
 {
     ILOG_TRACE_F(ILX_APPLICATION_EVENTS);
+    ILIXI_PROFILE("Application::handleEvents");
 
     bool wait = true;
     if (!forceWait)
@@ -516,6 +527,52 @@ Application::updateWindows()
     ILOG_DEBUG(ILX_APPLICATION_UPDATES, " -> finished updating windows.\n");
 }
 
+void
+Application::setCompositorVisible(bool visible)
+{
+    if (__instance)
+    {
+        __instance->__background = !visible;
+        Engine::instance().wakeUp();
+    }
+}
+
+void
+Application::updateBackgroundState()
+{
+    bool background = __background;
+    if (background == ((__flags & APS_BACKGROUND) != 0))
+        return;
+
+    if (background)
+    {
+        bool lowRate = PlatformManager::instance().appOptions() & OptBackgroundLowRate;
+        ILOG_DEBUG(ILX_APPLICATION, "Hidden by compositor, %s.\n", lowRate ? "using low rate" : "suspending updates");
+        __flags = (AppFlags) (__flags | APS_BACKGROUND);
+        _backgroundPaint = 0;
+        Engine::instance().setThrottle(lowRate ? __lowRateInterval : __backgroundInterval);
+    } else
+    {
+        ILOG_DEBUG(ILX_APPLICATION, "Visible, resuming updates.\n");
+        __flags = (AppFlags) (__flags & ~APS_BACKGROUND);
+        Engine::instance().setThrottle(0);
+    }
+}
+
+bool
+Application::backgroundPaintDue()
+{
+    if (!(PlatformManager::instance().appOptions() & OptBackgroundLowRate))
+        return false;
+
+    long long now = direct_clock_get_millis();
+    if (now < _backgroundPaint)
+        return false;
+
+    _backgroundPaint = now + __lowRateInterval;
+    return true;
+}
+
 void
 Application::setStylist(StylistBase* stylist)
 {
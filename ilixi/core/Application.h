@@ -205,7 +205,8 @@ protected:
         APS_INITIALISED = 0x0000001,    //!< Application is initialised.
         APS_VISIBLE = 0x0000002,        //!< Application has a visible window and has access to events.
         APS_HIDDEN = 0x0000004,         //!< Application has no window and has no access to events.
-        APS_CUSTOM = 0x0000008          //!< Disable waking up of buffer when an update is received.
+        APS_CUSTOM = 0x0000008,         //!< Disable waking up of buffer when an update is received.
+        APS_BACKGROUND = 0x0000010      //!< Application is hidden by compositor, painting and timers are throttled.
     };
 
     AppWindow*
@@ -320,6 +321,28 @@ private:
 
     //! Frame time set during window update
     long long _frameTime;
+    //! Set by compositor notifications while application is hidden.
+    volatile bool __background;
+    //! Time when next window update is allowed in background.
+    long long _backgroundPaint;
+
+    /*!
+     * Called from FusionDale thread when compositor shows or hides application.
+     */
+    static void
+    setCompositorVisible(bool visible);
+
+    /*!
+     * Applies visibility reported by compositor and throttles Engine while hidden.
+     */
+    void
+    updateBackgroundState();
+
+    /*!
+     * Returns true if windows should be updated while in background.
+     */
+    bool
+    backgroundPaintDue();
 
     /*!
      * Returns active window.
@@ -391,6 +414,7 @@ private:
     setDragging(bool dragging);
 
     friend class AppWindow;
+    friend class DaleDFB;               // setCompositorVisible
     friend class DragHelper;            // set _dragging
     friend class ILXCompositor;
     friend class PlatformManager;
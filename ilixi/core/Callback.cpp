@@ -32,7 +32,10 @@ namespace ilixi
 
 Callback::Callback(Functionoid* funck)
         : _funck(funck),
-          _running(false)
+          _running(false),
+          _prev(NULL),
+          _next(NULL),
+          _generation(0)
 {
 }
 
@@ -80,6 +80,12 @@ private:
     Functionoid* _funck;
     //! This flag specifies whether callback is actively running.
     bool _running;
+    //! Previous callback in Engine's list.
+    Callback* _prev;
+    //! Next callback in Engine's list.
+    Callback* _next;
+    //! Engine generation when callback is added.
+    unsigned int _generation;
 };
 }
 
@@ -164,12 +164,20 @@ typedef struct
     pid_t client;       //!< PID of client application.
 } NotificationAckData;
 
+//! This structure is used for requesting an image which is loaded by compositor.
+typedef struct
+{
+    char path[256];         //!< Path to image file.
+    DFBSurfaceID surfaceID; //!< Set by compositor, 0 if image is not available.
+} SharedImageData;
+
 //! This enum specifies the COMA methods for Compositor component.
 typedef enum
 {
     AddNotification,    //!< Add notification using "NotificationData" as argument.
     GetAppList,         //!< Send list of registered applications to client.
     GetFPS,             //!< Send current compositor fps.
+    GetSharedImage,     //!< Load image once in compositor and return its surface ID using "SharedImageData" as argument.
     HideHome,           //!< Hide Home application.
     HideSwitcher,       //!< Hide Switcher.
     SendBackKey,        //!< Send DIKS_BACK key to currently visible application.
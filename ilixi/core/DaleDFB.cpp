@@ -22,8 +22,10 @@
  */
 
 #include <core/DaleDFB.h>
+#include <core/Application.h>
 #include <core/ComponentData.h>
 #include <core/Logger.h>
+#include <core/PlatformManager.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -36,10 +38,18 @@ IComa* DaleDFB::__coma = NULL;
 IComaComponent* DaleDFB::__oskComp = NULL;
 IComaComponent* DaleDFB::__compComp = NULL;
 IComaComponent* DaleDFB::__soundComp = NULL;
+SoundEffectQueue DaleDFB::__soundQueue;
 DaleDFB::Notifications DaleDFB::__nots;
 #endif
 D_DEBUG_DOMAIN( ILX_DALEDFB, "ilixi/core/DaleDFB", "DaleDFB");
 
+#if ILIXI_HAVE_COMPOSITOR
+//! Interval (ms) for attaching to sound effect queue and checking that compositor still consumes it.
+static const long long __soundQueueCheck = 1000;
+//! Maximum interval (ms) between failed attach attempts.
+static const long long __soundQueueMaxCheck = 16000;
+#endif
+
 DaleDFB::DaleDFB()
 {
 #if ILIXI_HAVE_COMPOSITOR
@@ -152,6 +162,31 @@ DaleDFB::hideOSK()
     }
     return DFB_OK;
 }
+
+DFBResult
+DaleDFB::getSharedImage(const std::string& path, DFBSurfaceID* id)
+{
+    ILOG_TRACE_F(ILX_DALEDFB);
+    *id = 0;
+
+    if (path.length() > 255 || getCompComp() == DFB_FAILURE)
+        return DFB_FAILURE;
+
+    void *ptr;
+    if (comaGetLocal(sizeof(Compositor::SharedImageData), &ptr) != DFB_OK)
+        return DFB_FAILURE;
+
+    Compositor::SharedImageData* data = (Compositor::SharedImageData*) ptr;
+    snprintf(data->path, 256, "%s", path.c_str());
+    data->surfaceID = 0;
+
+    if (comaCallComponent(__compComp, Compositor::GetSharedImage, (void*) data) != DFB_OK || !data->surfaceID)
+        return DFB_FAILURE;
+
+    *id = data->surfaceID;
+    ILOG_DEBUG(ILX_DALEDFB, " -> %s (DFBSurfaceID: %u)\n", path.c_str(), *id);
+    return DFB_OK;
+}
 #endif
 
 DFBResult
@@ -192,6 +227,8 @@ DaleDFB::releaseDale()
 {
     ILOG_TRACE_F(ILX_DALEDFB);
 #if ILIXI_HAVE_COMPOSITOR
+    __soundQueue.release();
+
     if (__soundComp)
     {
         __soundComp->Release(__soundComp);
@@ -267,6 +304,7 @@ DaleDFB::getCompComp()
             }
 
             __compComp->Listen(__compComp, Compositor::NotificationAck, notificationListener, NULL);
+            __compComp->Listen(__compComp, Compositor::AppStatus, appStatusListener, NULL);
 
         } else
             return DFB_FAILURE;
@@ -330,6 +368,19 @@ DaleDFB::removeNotification(Notify* n)
     return DFB_FAILURE;
 }
 
+void
+DaleDFB::appStatusListener(void* ctx, void* arg)
+{
+    Compositor::VisibilityData* data = (Compositor::VisibilityData*) arg;
+    if (data->pid != getpid())
+        return;
+
+    if (data->status & Compositor::AppVisible)
+        Application::setCompositorVisible(true);
+    else if (data->status & Compositor::AppHidden)
+        Application::setCompositorVisible(false);
+}
+
 void
 DaleDFB::notificationListener(void* ctx, void* arg)
 {
@@ -367,6 +418,38 @@ DaleDFB::playSoundEffect(const std::string& id)
     return comaCallComponent(__soundComp, SoundMixer::PlaySoundEffect, ptr);
 }
 
+DFBResult
+DaleDFB::playSoundEffect(int id)
+{
+    // Compositor may create queue after first effect or restart later, so check periodically.
+    static long long lastCheck = 0;
+    static long long interval = __soundQueueCheck;
+    long long now = direct_clock_get_millis();
+    if (now - lastCheck >= interval)
+    {
+        lastCheck = now;
+        if (__soundQueue.valid() && !__soundQueue.consumerAlive())
+        {
+            ILOG_DEBUG(ILX_DALEDFB, " -> Sound effect queue is stale, detaching.\n");
+            __soundQueue.release();
+        }
+        if (!__soundQueue.valid())
+        {
+            // Back off while attach fails, e.g. sound effects do not match.
+            if (__soundQueue.attach(PlatformManager::instance().soundEffectSignature()))
+            {
+                ILOG_DEBUG(ILX_DALEDFB, " -> Attached to sound effect queue.\n");
+                interval = __soundQueueCheck;
+            } else if (interval < __soundQueueMaxCheck)
+                interval *= 2;
+        }
+    }
+
+    if (!__soundQueue.valid())
+        return DFB_FAILURE;
+    return __soundQueue.push(id) ? DFB_OK : DFB_FAILURE;
+}
+
 DFBResult
 DaleDFB::setSoundEffectLevel(float level)
 {
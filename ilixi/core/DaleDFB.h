@@ -31,6 +31,7 @@ extern "C"
 }
 #include <ilixiConfig.h>
 #if ILIXI_HAVE_COMPOSITOR
+#include <core/SoundEffectQueue.h>
 #include <lib/Notify.h>
 #endif
 #include <types/Rectangle.h>
@@ -87,6 +88,15 @@ public:
      */
     static DFBResult
     hideOSK();
+
+    /*!
+     * Requests an image which is loaded once by compositor and shared among applications.
+     *
+     * @param[in] path image file.
+     * @param[out] id surface ID which can be used with IDirectFB::GetSurface().
+     */
+    static DFBResult
+    getSharedImage(const std::string& path, DFBSurfaceID* id);
 #endif
 
 private:
@@ -96,6 +106,8 @@ private:
     static IComaComponent* __oskComp;
     static IComaComponent* __compComp;
     static IComaComponent* __soundComp;
+    //! Sound effect triggers for compositor.
+    static SoundEffectQueue __soundQueue;
 
     struct OSKRequest
     {
@@ -161,12 +173,26 @@ private:
     static void
     notificationListener(void* ctx, void* arg);
 
+    /*!
+     * Forwards visibility of this application reported by compositor.
+     */
+    static void
+    appStatusListener(void* ctx, void* arg);
+
     /*!
      * Plays a sound effect via SoundMixer component.
      */
     static DFBResult
     playSoundEffect(const std::string& id);
 
+    /*!
+     * Adds a sound effect to compositor's sound effect queue.
+     *
+     * Returns DFB_FAILURE if queue is not available or full.
+     */
+    static DFBResult
+    playSoundEffect(int id);
+
     /*!
      * Sets sound effect master volume via SoundMixer component.
      */
@@ -25,6 +25,7 @@
 
 #include <core/Logger.h>
 #include <core/PlatformManager.h>
+#include <core/Profiler.h>
 
 #include <algorithm>
 
@@ -52,7 +53,16 @@ Engine::instance()
 
 Engine::Engine()
         : __buffer(NULL),
-          _terminate(false)
+          _terminate(false),
+          __cbHead(NULL),
+          __cbTail(NULL),
+          __cbNext(NULL),
+          __cbCurrent(NULL),
+          __cbCount(0),
+          __cbGeneration(0),
+          __cbActive(false),
+          __throttle(0),
+          __throttleNext(0)
 {
     ILOG_TRACE(ILX_ENGINE);
 }
@@ -80,6 +90,31 @@ Engine::initialise()
 
 }
 
+void
+Engine::unlinkCallback(Callback* cb)
+{
+    if (cb == __cbNext)
+        __cbNext = cb->_next;
+    if (cb == __cbCurrent)
+        __cbCurrent = NULL;
+
+    if (cb->_prev)
+        cb->_prev->_next = cb->_next;
+    else
+        __cbHead = cb->_next;
+
+    if (cb->_next)
+        cb->_next->_prev = cb->_prev;
+    else
+        __cbTail = cb->_prev;
+
+    cb->_prev = NULL;
+    cb->_next = NULL;
+    cb->_running = false;
+    --__cbCount;
+    __cbActive = (__cbHead != NULL);
+}
+
 void
 Engine::release()
 {
@@ -96,9 +131,35 @@ Engine::release()
 int32_t
 Engine::cycle()
 {
+    if (__throttle)
+    {
+        int64_t now = direct_clock_get_millis();
+        if (now < __throttleNext)
+            return __throttleNext - now;
+        __throttleNext = now + __throttle;
+    }
+
+    ILIXI_PROFILE_POLL();
     runCallbacks();
     sigPerformWork();
-    return runTimers();
+    int32_t timeout = runTimers();
+    if (__throttle)
+    {
+        // runTimers() runs a single expired timer, run others before sleeping.
+        for (size_t i = _timers.size(); i && timeout <= 1; --i)
+            timeout = runTimers();
+        if (timeout < (int32_t) __throttle)
+            timeout = __throttle;
+    }
+    return timeout;
+}
+
+void
+Engine::setThrottle(unsigned int msec)
+{
+    ILOG_DEBUG(ILX_ENGINE, "setThrottle( %u )\n", msec);
+    __throttle = msec;
+    __throttleNext = 0;
 }
 
 void
@@ -130,15 +191,24 @@ Engine::addCallback(Callback* cb)
     {
         pthread_mutex_lock(&__cbMutex);
 
-        CallbackList::iterator it = std::find(__callbacks.begin(), __callbacks.end(), cb);
-        if (cb == *it)
+        if (cb->_running)
         {
-        	cb->_running = true;
             pthread_mutex_unlock(&__cbMutex);
             ILOG_DEBUG(ILX_ENGINE, "Callback %p already added!\n", cb);
             return false;
         }
-        __callbacks.push_back(cb);
+
+        cb->_running = true;
+        cb->_generation = __cbGeneration;
+        cb->_prev = __cbTail;
+        cb->_next = NULL;
+        if (__cbTail)
+            __cbTail->_next = cb;
+        else
+            __cbHead = cb;
+        __cbTail = cb;
+        ++__cbCount;
+        __cbActive = true;
 
         pthread_mutex_unlock(&__cbMutex);
         ILOG_DEBUG(ILX_ENGINE, "Callback %p is added.\n", cb);
@@ -155,16 +225,12 @@ Engine::removeCallback(Callback* cb)
     {
         pthread_mutex_lock(&__cbMutex);
 
-        for (CallbackList::iterator it = __callbacks.begin(); it != __callbacks.end(); ++it)
+        if (cb->_running)
         {
-            if (cb == *it)
-            {
-            	cb->_running = false;
-                __callbacks.erase(it);
-                pthread_mutex_unlock(&__cbMutex);
-                ILOG_DEBUG(ILX_ENGINE, "Callback %p is removed.\n", cb);
-                return true;
-            }
+            unlinkCallback(cb);
+            pthread_mutex_unlock(&__cbMutex);
+            ILOG_DEBUG(ILX_ENGINE, "Callback %p is removed.\n", cb);
+            return true;
         }
 
         pthread_mutex_unlock(&__cbMutex);
@@ -175,7 +241,7 @@ Engine::removeCallback(Callback* cb)
 unsigned int
 Engine::numCallbacks() const
 {
-    return __callbacks.size();
+    return __cbCount;
 }
 
 bool
@@ -262,25 +328,27 @@ void
 Engine::runCallbacks()
 {
     ILOG_TRACE(ILX_ENGINE_LOOP);
+    ILIXI_PROFILE("Engine::runCallbacks");
 
     pthread_mutex_lock(&__cbMutex);
-    std::vector<Callback*> list_copy;
-    CallbackList::iterator it = __callbacks.begin();
-    while (it != __callbacks.end())
+    ++__cbGeneration;
+    Callback* cb = __cbHead;
+    while (cb)
     {
-        list_copy.push_back(*it);
-        ++it;
-    }
-    std::vector<Callback*>::iterator it2 = list_copy.begin();
-    while (it2 != list_copy.end())
-    {
-        if (((Callback*) *it2)->_funck->funck() == 0)
+        __cbNext = cb->_next;
+        if (cb->_generation != __cbGeneration)
         {
-            ILOG_DEBUG(ILX_ENGINE_LOOP, " -> Callback %p is removed.\n", ((Callback*) *it2));
-            removeCallback(*it2);
+            __cbCurrent = cb;
+            if (cb->_funck->funck() == 0 && __cbCurrent)
+            {
+                ILOG_DEBUG(ILX_ENGINE_LOOP, " -> Callback %p is removed.\n", cb);
+                unlinkCallback(cb);
+            }
         }
-        ++it2;
+        cb = __cbNext;
     }
+    __cbNext = NULL;
+    __cbCurrent = NULL;
     pthread_mutex_unlock(&__cbMutex);
 }
 
@@ -288,6 +356,7 @@ int32_t
 Engine::runTimers()
 {
     ILOG_TRACE(ILX_ENGINE_LOOP);
+    ILIXI_PROFILE("Engine::runTimers");
     int32_t timeout = 100;
 
     pthread_mutex_lock(&__timerMutex);
@@ -399,10 +468,10 @@ Engine::waitForEvents(int32_t timeout)
 
     if (timeout < 1)
         ILOG_ERROR(ILX_ENGINE_LOOP, "Timeout error with value %d\n", timeout);
-    else if (timeout && Engine::instance().numCallbacks())
+    else if (timeout && __cbActive && !__throttle)
     {
         // do not wait
-    	ILOG_DEBUG(ILX_ENGINE_LOOP, " -> we have %d callbacks!\n", Engine::instance().numCallbacks());
+    	ILOG_DEBUG(ILX_ENGINE_LOOP, " -> we have %u callbacks!\n", __cbCount);
     } else
     {
         // discard window update event in buffer.
@@ -424,12 +493,11 @@ bool
 Engine::addSurfaceEventListener(SurfaceEventListener* sel)
 {
     ILOG_TRACE(ILX_ENGINE);
-    if (sel)
+    if (sel && sel->sourceSurface())
     {
         pthread_mutex_lock(&__selMutex);
 
-        SurfaceListenerList::iterator it = std::find(__selList.begin(), __selList.end(), sel);
-        if (sel == *it)
+        if (__selIDs.find(sel) != __selIDs.end())
         {
             pthread_mutex_unlock(&__selMutex);
             ILOG_ERROR(ILX_ENGINE, "SurfaceEventListener %p already added!\n", sel);
@@ -437,22 +505,20 @@ Engine::addSurfaceEventListener(SurfaceEventListener* sel)
         }
 
         ILOG_DEBUG(ILX_ENGINE, "SurfaceEventListener %p is added.\n", sel);
-        // check whether to attach source surface
-        bool attach = true;
-        for (SurfaceListenerList::iterator it = __selList.begin(); it != __selList.end(); ++it)
-        {
-            if (sel->sourceSurface() == ((SurfaceEventListener*) *it)->sourceSurface())
-                attach = false;
-        }
-
-        if (attach)
+        DFBSurfaceID id = sel->sourceID();
+        SurfaceListeners& entry = __selMap[id];
+        if (entry.listeners.empty())
         {
-            sel->sourceSurface()->MakeClient(sel->sourceSurface());
-            sel->sourceSurface()->AttachEventBuffer(sel->sourceSurface(), __buffer);
-            ILOG_DEBUG(ILX_ENGINE, " -> Surface[%p] is attached.\n", sel->sourceSurface());
+            // Event buffer is attached once per surface, keep interface alive while there are listeners.
+            entry.surface = sel->sourceSurface();
+            entry.surface->AddRef(entry.surface);
+            entry.surface->MakeClient(entry.surface);
+            entry.surface->AttachEventBuffer(entry.surface, __buffer);
+            ILOG_DEBUG(ILX_ENGINE, " -> Surface[%d] is attached.\n", id);
         }
 
-        __selList.push_back(sel);
+        entry.listeners.push_back(sel);
+        __selIDs.insert(std::make_pair(sel, id));
         pthread_mutex_unlock(&__selMutex);
         return true;
     }
@@ -467,41 +533,37 @@ Engine::removeSurfaceEventListener(SurfaceEventListener* sel)
     {
         pthread_mutex_lock(&__selMutex);
 
-        bool ret = false;
-        IDirectFBSurface* source = sel->sourceSurface();
-
-        for (SurfaceListenerList::iterator it = __selList.begin(); it != __selList.end(); ++it)
+        SurfaceListenerIDMap::iterator it = __selIDs.find(sel);
+        if (it == __selIDs.end())
         {
-            if (sel == *it)
-            {
-                __selList.erase(it);
-                ILOG_DEBUG(ILX_ENGINE, "SurfaceEventListener %p is removed.\n", sel);
-                ret = true;
-                break;
-            }
+            pthread_mutex_unlock(&__selMutex);
+            return false;
         }
 
-        if (ret)
+        DFBSurfaceID id = it->second;
+        __selIDs.erase(it);
+        ILOG_DEBUG(ILX_ENGINE, "SurfaceEventListener %p is removed.\n", sel);
+
+        IDirectFBSurface* detach = NULL;
+        SurfaceListenerMap::iterator entry = __selMap.find(id);
+        if (entry != __selMap.end())
         {
-            bool detach = true;
-            for (SurfaceListenerList::iterator it = __selList.begin(); it != __selList.end(); ++it)
+            entry->second.listeners.remove(sel);
+            if (entry->second.listeners.empty())
             {
-                if (source == ((SurfaceEventListener*) *it)->sourceSurface())
-                    detach = false;
+                detach = entry->second.surface;
+                __selMap.erase(entry);
             }
-            pthread_mutex_unlock(&__selMutex);
+        }
+        pthread_mutex_unlock(&__selMutex);
 
-            if (detach)
-            {
-                sel->sourceSurface()->DetachEventBuffer(sel->sourceSurface(), __buffer);
-                ILOG_DEBUG(ILX_ENGINE, " -> Surface[%p] is detached.\n", sel->sourceSurface());
-            }
-            return true;
-        } else
+        if (detach)
         {
-            pthread_mutex_unlock(&__selMutex);
-            return false;
+            detach->DetachEventBuffer(detach, __buffer);
+            detach->Release(detach);
+            ILOG_DEBUG(ILX_ENGINE, " -> Surface[%d] is detached.\n", id);
         }
+        return true;
     }
     return false;
 }
@@ -512,8 +574,12 @@ Engine::consumeSurfaceEvent(const DFBSurfaceEvent& event)
     pthread_mutex_lock(&__selMutex);
 
     ILOG_DEBUG(ILX_ENGINE_UPDATES, " -> SURFACE EVENT [%3d]  %4d,%4d-%4dx%4d (count %d)\n", event.surface_id, DFB_RECTANGLE_VALS_FROM_REGION(&event.update), event.flip_count);
-    for (SurfaceListenerList::iterator it = __selList.begin(); it != __selList.end(); ++it)
-        ((SurfaceEventListener*) *it)->consumeSurfaceEvent(event);
+    SurfaceListenerMap::iterator entry = __selMap.find(event.surface_id);
+    if (entry != __selMap.end())
+    {
+        for (SurfaceListenerList::iterator it = entry->second.listeners.begin(); it != entry->second.listeners.end(); ++it)
+            ((SurfaceEventListener*) *it)->consumeSurfaceEvent(event);
+    }
 
     pthread_mutex_unlock(&__selMutex);
 }
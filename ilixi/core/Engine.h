@@ -31,6 +31,7 @@
 
 #include <directfb.h>
 #include <list>
+#include <map>
 #include <sigc++/signal.h>
 
 #if ILIXI_HAS_SURFACEEVENTS
@@ -94,6 +95,15 @@ public:
     unsigned int
     numCallbacks() const;
 
+    /*!
+     * Limits callbacks and timers to run at most once every msec milliseconds.
+     *
+     * Application uses this while it is hidden by compositor. Events are still
+     * handled without delay. Set 0 to disable.
+     */
+    void
+    setThrottle(unsigned int msec);
+
     /*!
      * Adds a new timer to be monitored.
      */
@@ -158,11 +168,26 @@ private:
     //! Termination flag.
     bool _terminate;
 
-    typedef std::list<Callback*> CallbackList;
-    //! List of callbacks
-    CallbackList __callbacks;
-    //! Serialises access to __callbacks.
+    //! First registered callback, callbacks are linked using Callback::_next.
+    Callback* __cbHead;
+    //! Last registered callback.
+    Callback* __cbTail;
+    //! Next callback to run, advanced if it is removed during runCallbacks().
+    Callback* __cbNext;
+    //! Callback being run, set to NULL if it is removed during its own run.
+    Callback* __cbCurrent;
+    //! Number of registered callbacks.
+    unsigned int __cbCount;
+    //! Incremented by runCallbacks(), callbacks added during a run are skipped until next run.
+    unsigned int __cbGeneration;
+    //! This flag is set while there are registered callbacks.
+    bool __cbActive;
+    //! Serialises access to callbacks.
     pthread_mutex_t __cbMutex;
+    //! Minimum interval between cycles in milliseconds, 0 if disabled.
+    unsigned int __throttle;
+    //! Time when next throttled cycle is allowed.
+    int64_t __throttleNext;
 
     typedef std::list<Timer*> TimerList;
     TimerList _timers;
@@ -170,9 +195,20 @@ private:
 
 #if ILIXI_HAS_SURFACEEVENTS
     typedef std::list<SurfaceEventListener*> SurfaceListenerList;
-    //! List of surface event listeners.
-    SurfaceListenerList __selList;
-    //! Serialises access to _selList.
+    //! This struct stores listeners of a source surface.
+    struct SurfaceListeners
+    {
+        //! Referenced interface which event buffer is attached to.
+        IDirectFBSurface* surface;
+        SurfaceListenerList listeners;
+    };
+    typedef std::map<DFBSurfaceID, SurfaceListeners> SurfaceListenerMap;
+    //! Surface event listeners by source surface id.
+    SurfaceListenerMap __selMap;
+    typedef std::map<SurfaceEventListener*, DFBSurfaceID> SurfaceListenerIDMap;
+    //! Source surface id of each listener at the time it is added.
+    SurfaceListenerIDMap __selIDs;
+    //! Serialises access to __selMap and __selIDs.
     pthread_mutex_t __selMutex;
 #endif // end ILIXI_HAS_SURFACEEVENTS
     Engine();
@@ -183,6 +219,12 @@ private:
     void
     initialise();
 
+    /*!
+     * Removes callback from list, caller must hold __cbMutex.
+     */
+    void
+    unlinkCallback(Callback* cb);
+
     void
     release();
 
@@ -23,37 +23,399 @@
 
 #include <core/Logger.h>
 #ifdef ILIXI_LOGGER_ENABLED
+#include <algorithm>
 #include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sys/syscall.h>
 #include <syslog.h>
+#include <time.h>
+#include <unistd.h>
 
-using namespace ilixi;
-using namespace std;
+namespace ilixi
+{
+
+int __ilixiLogLevel = LogDebug;
+
+//! Number of records in a thread's queue.
+static const unsigned int __ringSize = 256;
+//! Flusher wakes up at least this often (ms) to write queued debug messages.
+static const int __flushInterval = 50;
+
+//! A formatted message.
+struct LogRecord
+{
+    //! Monotonic time (us) when message is logged.
+    long long time;
+    int level;
+    int tid;
+    const char* domain;
+    char text[232];
+};
+
+//! Single producer, single consumer queue of a thread's messages.
+struct LogRing
+{
+    //! Next record to write, modified by owner thread only.
+    volatile unsigned int head;
+    //! Next record to read, modified by flusher only.
+    volatile unsigned int tail;
+    //! Number of messages dropped since queue was full.
+    volatile unsigned int dropped;
+    //! Number of dropped messages already reported.
+    unsigned int reported;
+    //! Set while a thread uses this queue.
+    volatile int owned;
+    //! Thread id of owner.
+    int tid;
+    LogRing* next;
+    LogRecord records[__ringSize];
+};
+
+//! Queues of all threads, queues of exited threads are reused.
+static LogRing* volatile __rings = NULL;
+static pthread_key_t __ringKey;
+static pthread_once_t __ringOnce = PTHREAD_ONCE_INIT;
+
+static pthread_mutex_t __stateLock = PTHREAD_MUTEX_INITIALIZER;
+//! Held while queues are read and output is written.
+static pthread_mutex_t __drainLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t __flusher;
+static volatile int __running = 0;
+static volatile int __wakeups = 0;
+static volatile int __sleeping = 0;
+
+static LogOutput __output = LogStderr;
+static int __fd = STDERR_FILENO;
+
+static const char* const __levelNames[] = { "EMERG", "ALERT", "FATAL", "ERROR", "WARNING", "NOTICE", "INFO", "DEBUG" };
+
+static long long
+logTime()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static void
+releaseRing(void* ring)
+{
+    __sync_synchronize();
+    ((LogRing*) ring)->owned = 0;
+}
+
+static void
+resetAfterFork()
+{
+    // Only the forking thread exists in child, flusher is restarted when needed.
+    pthread_mutex_t unlocked = PTHREAD_MUTEX_INITIALIZER;
+    __drainLock = unlocked;
+    __stateLock = unlocked;
+    __running = 0;
+    __sleeping = 0;
+
+    // Parent flushes pending records, rings of other threads are free in child.
+    LogRing* own = __rings ? (LogRing*) pthread_getspecific(__ringKey) : NULL;
+    if (own)
+        own->tid = syscall(SYS_gettid);
+    for (LogRing* ring = __rings; ring; ring = ring->next)
+    {
+        ring->tail = ring->head;
+        if (ring != own)
+            ring->owned = 0;
+    }
+}
+
+static void
+createRingKey()
+{
+    pthread_key_create(&__ringKey, releaseRing);
+    pthread_atfork(NULL, NULL, resetAfterFork);
+}
+
+static LogRing*
+threadRing()
+{
+    pthread_once(&__ringOnce, createRingKey);
+    LogRing* ring = (LogRing*) pthread_getspecific(__ringKey);
+    if (ring)
+        return ring;
+
+    for (ring = __rings; ring; ring = ring->next)
+        if (!ring->owned && __sync_bool_compare_and_swap(&ring->owned, 0, 1))
+            break;
+
+    if (!ring)
+    {
+        ring = (LogRing*) calloc(1, sizeof(LogRing));
+        if (!ring)
+            return NULL;
+        ring->owned = 1;
+        do
+            ring->next = __rings;
+        while (!__sync_bool_compare_and_swap(&__rings, ring->next, ring));
+    }
+    ring->tid = syscall(SYS_gettid);
+    pthread_setspecific(__ringKey, ring);
+    return ring;
+}
+
+static void
+wakeFlusher()
+{
+    __sync_fetch_and_add(&__wakeups, 1);
+    if (__sleeping)
+        syscall(SYS_futex, &__wakeups, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+static void
+writeOutput(const char* buffer, size_t length)
+{
+    while (length)
+    {
+        ssize_t ret = write(__fd, buffer, length);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        buffer += ret;
+        length -= ret;
+    }
+}
+
+//! Writes a record to output, buffer is flushed when it can not hold another line.
+static void
+writeRecord(const LogRecord* record, char* buffer, size_t* used, size_t size)
+{
+    if (__output == LogSyslog)
+    {
+        syslog(record->level, "%s%s%s", record->domain ? record->domain : "", record->domain ? ": " : "", record->text);
+        return;
+    }
+
+    if (size - *used < sizeof(LogRecord) + 64)
+    {
+        writeOutput(buffer, *used);
+        *used = 0;
+    }
+
+    size_t length = strlen(record->text);
+    int n = snprintf(buffer + *used, size - *used, "%lld.%06lld (%5d) %-7s %s%s%.*s\n", record->time / 1000000, record->time % 1000000, record->tid, __levelNames[record->level & 7], record->domain ? record->domain : "", record->domain ? ": " : "", (int) (length && record->text[length - 1] == '\n' ? length - 1 : length), record->text);
+    if (n > 0)
+        *used += std::min((size_t) n, size - *used - 1);
+}
+
+//! Writes queued records of all threads ordered by time.
+static void
+drain()
+{
+    char buffer[8192];
+    size_t used = 0;
+
+    pthread_mutex_lock(&__drainLock);
+    while (true)
+    {
+        LogRing* next = NULL;
+        for (LogRing* ring = __rings; ring; ring = ring->next)
+        {
+            if (ring->dropped != ring->reported)
+            {
+                LogRecord record;
+                record.time = logTime();
+                record.level = LogWarning;
+                record.tid = 0;
+                record.domain = "ilixi/core/Logger";
+                unsigned int dropped = ring->dropped;
+                snprintf(record.text, sizeof(record.text), "%u messages dropped, queue is full.\n", dropped - ring->reported);
+                ring->reported = dropped;
+                writeRecord(&record, buffer, &used, sizeof(buffer));
+            }
+            if (ring->tail != ring->head && (!next || ring->records[ring->tail % __ringSize].time < next->records[next->tail % __ringSize].time))
+                next = ring;
+        }
+        if (!next)
+            break;
+
+        __sync_synchronize();
+        writeRecord(&next->records[next->tail % __ringSize], buffer, &used, sizeof(buffer));
+        __sync_synchronize();
+        next->tail = next->tail + 1;
+    }
+    if (used)
+        writeOutput(buffer, used);
+    pthread_mutex_unlock(&__drainLock);
+}
+
+static void*
+flusherMain(void*)
+{
+    struct timespec ts;
+    ts.tv_sec = __flushInterval / 1000;
+    ts.tv_nsec = (__flushInterval % 1000) * 1000000;
+    while (__running)
+    {
+        int wakeups = __wakeups;
+        drain();
+        __sleeping = 1;
+        __sync_synchronize();
+        if (__running)
+            syscall(SYS_futex, &__wakeups, FUTEX_WAIT, wakeups, &ts, NULL, 0);
+        __sleeping = 0;
+    }
+    drain();
+    return NULL;
+}
+
+static void
+stopFlusher()
+{
+    pthread_mutex_lock(&__stateLock);
+    if (__running)
+    {
+        __running = 0;
+        wakeFlusher();
+        pthread_join(__flusher, NULL);
+    }
+    pthread_mutex_unlock(&__stateLock);
+}
+
+static void
+startFlusher()
+{
+    static bool registered = false;
+    pthread_mutex_lock(&__stateLock);
+    if (!__running)
+    {
+        __running = 1;
+        if (pthread_create(&__flusher, NULL, flusherMain, NULL))
+            __running = 0;
+        else if (!registered)
+        {
+            atexit(stopFlusher);
+            registered = true;
+        }
+    }
+    pthread_mutex_unlock(&__stateLock);
+}
+
+static void
+push(int level, const char* domain, const char* message, va_list args)
+{
+    LogRing* ring = threadRing();
+    if (!ring)
+        return;
+
+    unsigned int head = ring->head;
+    if (head - ring->tail >= __ringSize)
+    {
+        __sync_fetch_and_add(&ring->dropped, 1);
+        wakeFlusher();
+        return;
+    }
+
+    LogRecord* record = &ring->records[head % __ringSize];
+    record->time = logTime();
+    record->level = level;
+    record->tid = ring->tid;
+    record->domain = domain;
+    vsnprintf(record->text, sizeof(record->text), message, args);
+    __sync_synchronize();
+    ring->head = head + 1;
+
+    if (!__running)
+        startFlusher();
+    // Debug messages are written in batches, others as soon as possible.
+    if (level <= LogWarning || head - ring->tail >= __ringSize / 2)
+        wakeFlusher();
+    if (level <= LogFatal)
+        ilixi_log_flush();
+}
 
 void
-ilixi::ilixi_log_init(char* ident, int facility)
+ilixi_log_init(char* ident, int facility, LogOutput output, const char* file)
 {
-#ifdef ILIXI_LOG_DEBUG_ENABLED
-    setlogmask(LOG_UPTO(LOG_NOTICE));
-#endif
-    if (facility)
-        openlog(ident, LOG_NDELAY | LOG_CONS | LOG_PID, facility);
-    else
-        openlog(ident, LOG_NDELAY | LOG_CONS | LOG_PID, LOG_USER);
+    int fd = STDERR_FILENO;
+    if (output == LogFile)
+    {
+        fd = file ? open(file, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644) : -1;
+        if (fd < 0)
+        {
+            fprintf(stderr, " -> ERROR (ilixi/core/Logger): Cannot open log file %s: %s\n", file ? file : "(null)", strerror(errno));
+            output = LogStderr;
+            fd = STDERR_FILENO;
+        }
+    }
+
+    // Messages queued so far go to previous output.
+    drain();
+    pthread_mutex_lock(&__drainLock);
+    if (__output == LogSyslog)
+        closelog();
+    else if (__fd != STDERR_FILENO)
+        close(__fd);
+    __output = output;
+    __fd = fd;
+    if (output == LogSyslog)
+        openlog(ident, LOG_NDELAY | LOG_CONS | LOG_PID, facility ? facility : LOG_USER);
+    pthread_mutex_unlock(&__drainLock);
+    startFlusher();
+}
+
+void
+ilixi_log_close()
+{
+    stopFlusher();
+    drain();
+    pthread_mutex_lock(&__drainLock);
+    if (__output == LogSyslog)
+        closelog();
+    else if (__fd != STDERR_FILENO)
+        close(__fd);
+    __output = LogStderr;
+    __fd = STDERR_FILENO;
+    pthread_mutex_unlock(&__drainLock);
 }
 
 void
-ilixi::ilixi_log_close()
+ilixi_log_flush()
 {
-    closelog();
+    drain();
 }
 
 void
-ilixi::ilixi_log(int level, const char* message, ...)
+ilixi_log_set_level(int level)
 {
+    __ilixiLogLevel = level;
+}
+
+void
+ilixi_log(int level, const char* message, ...)
+{
+    if (level > __ilixiLogLevel)
+        return;
     va_list args;
     va_start(args, message);
-    vsyslog(level, message, args);
+    push(level, NULL, message, args);
     va_end(args);
 }
 
+void
+ilixi_log_at(int level, const char* domain, const char* message, ...)
+{
+    va_list args;
+    va_start(args, message);
+    push(level, domain, message, args);
+    va_end(args);
+}
+
+} /* namespace ilixi */
+
 #endif
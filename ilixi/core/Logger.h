@@ -40,32 +40,91 @@ D_DEBUG_DOMAIN( ILX_TYPES, "ilixi/types", "Types");
 D_DEBUG_DOMAIN( ILX_UI, "ilixi/ui", "Widgets");
 
 #ifdef ILIXI_LOGGER_ENABLED
+//! Log levels, same as syslog priorities.
+enum LogLevel
+{
+    LogFatal = 2,       //!< Critical conditions
+    LogError = 3,       //!< Error conditions
+    LogWarning = 4,     //!< Warning conditions
+    LogNotice = 5,      //!< Normal but significant conditions
+    LogInfo = 6,        //!< Informational messages
+    LogDebug = 7        //!< Debug and trace messages
+};
+
+//! Destinations for log messages.
+enum LogOutput
+{
+    LogStderr,          //!< Write to standard error, default until ilixi_log_init() is called.
+    LogSyslog,          //!< Submit to syslog.
+    LogFile             //!< Append to a file.
+};
+
+//! Messages above this level are discarded before formatting, see ilixi_log_set_level().
+extern int __ilixiLogLevel;
+
 /*!
- * Opens a connection to Syslog in preparation for submitting messages.
+ * Selects where log messages are written.
+ *
+ * Messages are formatted by the logging thread into a per-thread queue and written
+ * by a background thread, so logging never waits for output. If a queue is full its
+ * messages are dropped and the number of dropped messages is reported later.
+ *
+ * @param ident prepended to syslog messages.
+ * @param facility syslog facility, default is LOG_USER.
+ * @param output destination of messages.
+ * @param file path to log file if output is LogFile.
  */
 void
-ilixi_log_init(char* ident, int facility = 0);
+ilixi_log_init(char* ident, int facility = 0, LogOutput output = LogStderr, const char* file = NULL);
 
 /*!
- * Closes the current Syslog connection.
+ * Writes pending messages, stops background thread and closes current output.
  */
 void
 ilixi_log_close();
 
 /*!
- * Submits a message to the Syslog facility on the same system.
+ * Writes pending messages of all threads before returning.
+ */
+void
+ilixi_log_flush();
+
+/*!
+ * Sets the most verbose level which is logged, default is LogDebug.
+ */
+void
+ilixi_log_set_level(int level);
+
+/*!
+ * Queues a message with given level, e.g. LogError.
+ *
+ * Logging may allocate a queue and start background thread, so neither this function nor
+ * ILOG_* macros are async-signal-safe and they must not be used inside signal handlers.
+ */
+void
+ilixi_log(int level, const char* message, ...) D_FORMAT_PRINTF(2);
+
+/*!
+ * Queues a message of given debug domain.
  */
 void
-ilixi_log(int level, const char* message, ...);
+ilixi_log_at(int level, const char* domain, const char* message, ...) D_FORMAT_PRINTF(3);
+
+#define ILOG_AT(Level, Domain, _fmt...) do { if ((Level) <= ilixi::__ilixiLogLevel) ilixi::ilixi_log_at(Level, Domain.name, _fmt); } while(0)
 
 #ifdef ILIXI_LOG_DEBUG_ENABLED
-#define ILOG_TRACE(Domain)              D_DEBUG_AT(Domain, "[%p] %s()\n", this, __FUNCTION__)
-#define ILOG_TRACE_F(Domain)            D_DEBUG_AT(Domain, "%s()\n", __FUNCTION__)
-#define ILOG_TRACE_W(Domain)            D_DEBUG_AT(Domain, "[%d:%p] %s()\n", id(), this, __FUNCTION__)
-#define ILOG_DEBUG( Domain, _fmt... )   D_DEBUG_AT(Domain, _fmt)
-#define ILOG_INFO( Domain, _fmt...)     D_LOG(Domain, INFO, _fmt)
-#define ILOG_NOTICE( Domain, _fmt...)   D_LOG(Domain, NOTICE, _fmt)
-#define ILOG_WARNING( Domain, _fmt...)  D_LOG(Domain, WARNING, _fmt)
+#if ILIXI_DFB_VERSION >= VERSION_CODE(1,6,0)
+#define ILOG_DEBUG_AT(Domain, _fmt...)  do { if (ilixi::LogDebug <= ilixi::__ilixiLogLevel && direct_debug_check_domain(&Domain)) ilixi::ilixi_log_at(ilixi::LogDebug, Domain.name, _fmt); } while(0)
+#else
+#define ILOG_DEBUG_AT(Domain, _fmt...)  D_DEBUG_AT(Domain, _fmt)
+#endif
+#define ILOG_TRACE(Domain)              ILOG_DEBUG_AT(Domain, "[%p] %s()\n", this, __FUNCTION__)
+#define ILOG_TRACE_F(Domain)            ILOG_DEBUG_AT(Domain, "%s()\n", __FUNCTION__)
+#define ILOG_TRACE_W(Domain)            ILOG_DEBUG_AT(Domain, "[%d:%p] %s()\n", id(), this, __FUNCTION__)
+#define ILOG_DEBUG( Domain, _fmt... )   ILOG_DEBUG_AT(Domain, _fmt)
+#define ILOG_INFO( Domain, _fmt...)     ILOG_AT(ilixi::LogInfo, Domain, _fmt)
+#define ILOG_NOTICE( Domain, _fmt...)   ILOG_AT(ilixi::LogNotice, Domain, _fmt)
+#define ILOG_WARNING( Domain, _fmt...)  ILOG_AT(ilixi::LogWarning, Domain, _fmt)
 #else // ILIXI_LOG_DEBUG_ENABLED = 0
 #define ILOG_TRACE(Domain)              do {} while(0)
 #define ILOG_TRACE_F(Domain)            do {} while(0)
@@ -75,13 +134,8 @@ ilixi_log(int level, const char* message, ...);
 #define ILOG_NOTICE(_fmt...)            do {} while(0)
 #define ILOG_WARNING(_fmt...)           do {} while(0)
 #endif // end ILIXI_LOG_DEBUG_ENABLED
-#if ILIXI_DFB_VERSION >= VERSION_CODE(1,6,0)
-#define ILOG_ERROR(Domain, _fmt...)     D_LOG(Domain, ERROR, _fmt)
-#define ILOG_FATAL(Domain, _fmt...)     D_LOG(Domain, FATAL, _fmt)
-#else
-#define ILOG_ERROR(Domain, _fmt...)     D_ERROR(_fmt)
-#define ILOG_FATAL(Domain, _fmt...)     D_ERROR(_fmt)
-#endif
+#define ILOG_ERROR(Domain, _fmt...)     ILOG_AT(ilixi::LogError, Domain, _fmt)
+#define ILOG_FATAL(Domain, _fmt...)     ILOG_AT(ilixi::LogFatal, Domain, _fmt)
 #else // ILIXI_LOGGER_ENABLED = 0
 #define ILOG_TRACE(Domain)              do {} while(0)
 #define ILOG_TRACE_F(Domain)            do {} while(0)
@@ -25,8 +25,11 @@
 
 #include <core/Application.h>
 #include <core/Logger.h>
+#include <core/SoundEffectQueue.h>
 #include <graphics/ImagePack.h>
+#include <graphics/Painter.h>
 #include <lib/FileSystem.h>
+#include <lib/Thread.h>
 #include <lib/XMLReader.h>
 #include <types/FontCache.h>
 #include <algorithm>
@@ -44,6 +47,10 @@ extern "C"
 #include <core/SoundDFB.h>
 #endif
 
+#ifdef ILIXI_HAVE_CAIRO
+#include <graphics/CairoPainter.h>
+#endif
+
 #ifdef ILIXI_HAVE_NLS
 #include <libintl.h>
 #include <types/I18NBase.h>
@@ -65,6 +72,45 @@ namespace ilixi
 D_DEBUG_DOMAIN( ILX_PLATFORMMANAGER, "ilixi/core/PlatformManager", "PlatformManager");
 D_DEBUG_DOMAIN( ILX_PLATFORMMANAGER_TRACE, "ilixi/core/PlatformManagerTrace", "PlatformManagerTrace");
 
+#if ILIXI_HAVE_FUSIONSOUND
+//! Loads sound effect samples in background.
+class PlatformManager::SoundLoader : public Thread
+{
+public:
+    SoundLoader()
+            : Thread()
+    {
+    }
+
+    virtual
+    ~SoundLoader()
+    {
+    }
+
+    //! Adds a sound whose sample is loaded from given file.
+    void
+    add(Sound* sound, const std::string& file)
+    {
+        _items.push_back(std::make_pair(sound, file));
+    }
+
+protected:
+    int
+    run()
+    {
+        ILOG_DEBUG(ILX_PLATFORMMANAGER, "Loading %zu sound effects...\n", _items.size());
+        for (ItemList::iterator it = _items.begin(); it != _items.end(); ++it)
+            it->first->setFileName(it->second);
+        ILOG_DEBUG(ILX_PLATFORMMANAGER, " -> Sound effects are loaded.\n");
+        return 0;
+    }
+
+private:
+    typedef std::vector<std::pair<Sound*, std::string> > ItemList;
+    ItemList _items;
+};
+#endif
+
 static DirectFBPixelFormatNames( format_names );
 
 PlatformManager&
@@ -101,6 +147,34 @@ PlatformManager::getLayer(const std::string& name) const
     return NULL;
 }
 
+IDirectFBDisplayLayer*
+PlatformManager::getScanoutLayer() const
+{
+    ILOG_TRACE_F(ILX_PLATFORMMANAGER);
+    for (HardwareLayerMap::const_iterator itHW = _hwLayerMap.begin(); itHW != _hwLayerMap.end(); ++itHW)
+    {
+        if (!itHW->second.scanout)
+            continue;
+
+        bool used = false;
+        for (LogicLayerMap::const_iterator it = _layerMap.begin(); it != _layerMap.end(); ++it)
+        {
+            if (it->second.id == itHW->first)
+            {
+                used = true;
+                break;
+            }
+        }
+
+        if (!used)
+        {
+            ILOG_DEBUG(ILX_PLATFORMMANAGER, " -> layer: %p\n", itHW->second.layer);
+            return itHW->second.layer;
+        }
+    }
+    return NULL;
+}
+
 DFBDisplayLayerID
 PlatformManager::getLayerID(const std::string& name) const
 {
@@ -207,6 +281,12 @@ PlatformManager::getWindowSurfaceCaps() const
     return _windowConf.caps;
 }
 
+bool
+PlatformManager::useBatchDrawing() const
+{
+    return _windowConf.batch;
+}
+
 const std::string&
 PlatformManager::getThemeDirectory() const
 {
@@ -317,18 +397,58 @@ PlatformManager::playSoundEffect(const std::string& id)
 {
     ILOG_TRACE_F(ILX_PLATFORMMANAGER);
 #if ILIXI_HAVE_FUSIONSOUND
+    SoundIDMap::const_iterator it = _soundIDs.find(id);
+    if (it != _soundIDs.end())
+        playSoundEffect((int) it->second);
+#endif
+}
+
+void
+PlatformManager::playSoundEffect(int id)
+{
+#if ILIXI_HAVE_FUSIONSOUND
+    if (id < 0 || id >= (int) _sounds.size())
+        return;
 #if ILIXI_HAVE_COMPOSITOR
     if (_options & OptExclSoundEffect)
-        DaleDFB::playSoundEffect(id);
-    else
     {
+        // Queue is full or not available, ask SoundMixer component.
+        if (DaleDFB::playSoundEffect(id) != DFB_OK)
+        {
+            for (SoundIDMap::const_iterator it = _soundIDs.begin(); it != _soundIDs.end(); ++it)
+            {
+                if (it->second == (unsigned int) id)
+                {
+                    DaleDFB::playSoundEffect(it->first);
+                    break;
+                }
+            }
+        }
+    } else
 #endif // ILIXI_HAVE_FUSIONDALE
-        SoundMap::const_iterator it = _soundMap.find(id);
-        if (it != _soundMap.end())
-            it->second->start();
-#if ILIXI_HAVE_COMPOSITOR
-    }
-#endif // ILIXI_HAVE_FUSIONDALE
+    if (_sounds[id])
+        _sounds[id]->start();
+#endif
+}
+
+int
+PlatformManager::soundEffectID(const std::string& name) const
+{
+#if ILIXI_HAVE_FUSIONSOUND
+    SoundIDMap::const_iterator it = _soundIDs.find(name);
+    if (it != _soundIDs.end())
+        return it->second;
+#endif
+    return -1;
+}
+
+unsigned int
+PlatformManager::soundEffectSignature() const
+{
+#if ILIXI_HAVE_FUSIONSOUND
+    return _soundSignature;
+#else
+    return 0;
 #endif
 }
 
@@ -344,8 +464,9 @@ PlatformManager::setSoundEffectLevel(float level)
     {
 #endif // ILIXI_HAVE_FUSIONDALE
         _soundLevel = level;
-        for (SoundMap::iterator it = _soundMap.begin(); it != _soundMap.end(); ++it)
-            it->second->setVolume(_soundLevel);
+        for (SoundList::iterator it = _sounds.begin(); it != _sounds.end(); ++it)
+            if (*it)
+                (*it)->setVolume(_soundLevel);
 #if ILIXI_HAVE_COMPOSITOR
     }
 #endif // ILIXI_HAVE_FUSIONDALE
@@ -524,7 +645,9 @@ PlatformManager::PlatformManager()
           _pixelFormat(DSPF_UNKNOWN),
           _configFile("")
 #ifdef ILIXI_HAVE_FUSIONSOUND
-          ,_soundLevel(100)
+          ,_soundSignature(0),
+          _soundLevel(100),
+          _soundLoader(NULL)
 #endif
 {
     ILOG_TRACE_F(ILX_PLATFORMMANAGER);
@@ -621,7 +744,14 @@ PlatformManager::initialize(int* argc, char*** argv, AppOptions opts)
 
 #if ILIXI_HAVE_FUSIONDALE
         if ((_options & OptDaleAuto) && DaleDFB::initDale(argc, argv) == DFB_OK)
+        {
             ILOG_INFO(ILX_PLATFORMMANAGER, "FusionDale is ready.\n");
+#if ILIXI_HAVE_COMPOSITOR
+            // Listen for visibility changes from compositor.
+            if (!(_options & OptExclusive) && FileSystem::fileExists(PrintF("%silx_compositor.pid", FileSystem::ilxDirectory().c_str())))
+                DaleDFB::getCompComp();
+#endif
+        }
 #endif
 
         if (!parseConfig())
@@ -648,6 +778,10 @@ PlatformManager::release()
         _imgPackMap.clear();
 
         FontCache::Instance()->releaseAllEntries();
+        Painter::releaseGradientCache();
+#ifdef ILIXI_HAVE_CAIRO
+        CairoPainter::releasePathCache();
+#endif
 
         if ((appOptions() & OptExclusive) && _cursorImage)
             _cursorImage->Release(_cursorImage);
@@ -664,9 +798,18 @@ PlatformManager::release()
 #if ILIXI_HAVE_FUSIONSOUND
         if (_options & OptSound)
         {
-            ILOG_DEBUG(ILX_PLATFORMMANAGER, "Releasing SoundMap...\n");
-            for (SoundMap::iterator it = _soundMap.begin(); it != _soundMap.end(); ++it)
-                delete it->second;
+            ILOG_DEBUG(ILX_PLATFORMMANAGER, "Releasing sound effects...\n");
+            if (_soundLoader)
+            {
+                _soundLoader->join();
+                delete _soundLoader;
+                _soundLoader = NULL;
+            }
+            for (SoundList::iterator it = _sounds.begin(); it != _sounds.end(); ++it)
+                delete *it;
+            _sounds.clear();
+            _soundIDs.clear();
+            _soundSignature = 0;
 
             ILOG_DEBUG(ILX_PLATFORMMANAGER, "Releasing FusionSound...\n");
             SoundDFB::releaseSound();
@@ -816,6 +959,7 @@ PlatformManager::setHardwareLayers(xmlNodePtr node)
         xmlChar* flipModeC = xmlGetProp(node, (xmlChar*) "flipMode");
         xmlChar* bufferModeC = xmlGetProp(node, (xmlChar*) "bufferMode");
         xmlChar* exclusiveC = xmlGetProp(node, (xmlChar*) "exclusive");
+        xmlChar* scanoutC = xmlGetProp(node, (xmlChar*) "scanout");
         xmlChar* xC = xmlGetProp(node, (xmlChar*) "x");
         xmlChar* yC = xmlGetProp(node, (xmlChar*) "y");
         xmlChar* wC = xmlGetProp(node, (xmlChar*) "w");
@@ -848,12 +992,18 @@ PlatformManager::setHardwareLayers(xmlNodePtr node)
             info.flipMode = FlipNone;
             info.layer = layer;
             info.rect = Rectangle(0, 0, conf.width, conf.height);
+            info.scanout = (xmlStrcmp(scanoutC, (xmlChar*) "yes") == 0);
 
             std::pair<HardwareLayerMap::iterator, bool> ret = _hwLayerMap.insert(std::pair<unsigned int, HardwareLayer>(id, info));
             if (ret.second == false)
                 ILOG_ERROR(ILX_PLATFORMMANAGER, "A layer with id [%d] already exists, cannot add duplicate record!\n", id);
             else if ((_options & OptExclusive))
+            {
                 configureHWLayer(layer, id, (HardwareLayer*) &(ret.first->second), bufferModeC, flipModeC, atoi((char*) xC), atoi((char*) yC), atoi((char*) wC), atoi((char*) hC));
+                // Scanout layer stays hidden until compositor puts a surface on it.
+                if (info.scanout)
+                    layer->SetOpacity(layer, 0);
+            }
         }
 
         xmlFree(xC);
@@ -861,6 +1011,7 @@ PlatformManager::setHardwareLayers(xmlNodePtr node)
         xmlFree(wC);
         xmlFree(hC);
         xmlFree(exclusiveC);
+        xmlFree(scanoutC);
         xmlFree(idC);
         xmlFree(fsuC);
         xmlFree(flipModeC);
@@ -1264,6 +1415,10 @@ PlatformManager::setWindow(xmlNodePtr node)
                 _windowConf.caps = DSCAPS_NONE;
             else if (xmlStrcmp(pcDATA, (xmlChar*) "triple") == 0)
                 _windowConf.caps = DSCAPS_TRIPLE;
+        } else if (xmlStrcmp(node->name, (xmlChar*) "BatchDrawing") == 0)
+        {
+            if (xmlStrcmp(pcDATA, (xmlChar*) "on") == 0)
+                _windowConf.batch = true;
         }
 
         xmlFree(pcDATA);
@@ -1273,6 +1428,7 @@ PlatformManager::setWindow(xmlNodePtr node)
     ILOG_DEBUG(ILX_PLATFORMMANAGER, " -> fsu: %d\n", _windowConf.fsu);
     ILOG_DEBUG(ILX_PLATFORMMANAGER, " -> flipMode: %d\n", _windowConf.flipMode);
     ILOG_DEBUG(ILX_PLATFORMMANAGER, " -> caps: %x\n", _windowConf.caps);
+    ILOG_DEBUG(ILX_PLATFORMMANAGER, " -> batch: %d\n", _windowConf.batch);
 }
 
 void
@@ -1370,17 +1526,29 @@ PlatformManager::setSounds(xmlNodePtr node)
         std::string file = sounddir;
         file.append(path);
 
-        Sound* sound = new Sound(file);
-
-        std::pair<SoundMap::iterator, bool> ret = _soundMap.insert(std::pair<std::string, Sound*>((char*) nameC, sound));
+        std::pair<SoundIDMap::iterator, bool> ret = _soundIDs.insert(std::pair<std::string, unsigned int>((char*) nameC, _sounds.size()));
         if (ret.second == false)
-        {
-            delete sound;
             ILOG_ERROR(ILX_PLATFORMMANAGER, "A sound with name [%s] already exists, cannot add duplicate record!\n", (char*) nameC);
-        } else
+        else
         {
-            sound->setVolume(_soundLevel);
-            ILOG_DEBUG(ILX_PLATFORMMANAGER, " -> Added %s - %s\n", (char*) nameC, file.c_str());
+            // Effects are played by compositor, only ids are needed.
+            Sound* sound = NULL;
+            if (!(_options & OptExclSoundEffect))
+            {
+                sound = new Sound();
+                xmlChar* voicesC = xmlGetProp(element, (xmlChar*) "voices");
+                if (voicesC)
+                {
+                    sound->setVoices(atoi((char*) voicesC));
+                    xmlFree(voicesC);
+                }
+                if (!_soundLoader)
+                    _soundLoader = new SoundLoader();
+                _soundLoader->add(sound, file);
+            }
+            _sounds.push_back(sound);
+            _soundSignature = SoundEffectQueue::signature(_soundSignature, (char*) nameC);
+            ILOG_DEBUG(ILX_PLATFORMMANAGER, " -> Added %s [%d] - %s\n", (char*) nameC, ret.first->second, file.c_str());
         }
 
         xmlFree(pcDATA);
@@ -1388,8 +1556,13 @@ PlatformManager::setSounds(xmlNodePtr node)
 
         element = element->next;
     }
-    for (SoundMap::iterator it = _soundMap.begin(); it != _soundMap.end(); ++it)
-        it->second->setVolume(_soundLevel);
+    for (SoundList::iterator it = _sounds.begin(); it != _sounds.end(); ++it)
+        if (*it)
+            (*it)->setVolume(_soundLevel);
+
+    // Samples are read and decoded while application continues initialising.
+    if (_soundLoader)
+        _soundLoader->start();
 }
 #endif // ILIXI_HAVE_FUSIONSOUND
 void
@@ -29,6 +29,7 @@
 #include <string>
 #include <libxml/tree.h>
 #include <map>
+#include <vector>
 #include <types/Enums.h>
 #include <types/Rectangle.h>
 #ifdef ILIXI_HAVE_FUSIONSOUND
@@ -79,6 +80,12 @@ public:
     IDirectFBDisplayLayer*
     getLayer(const std::string& name = "ui") const;
 
+    /*!
+     * Returns a hardware layer marked for scanout which is not used by any logic layer, otherwise returns NULL.
+     */
+    IDirectFBDisplayLayer*
+    getScanoutLayer() const;
+
     /*!
      * Returns a DFBLayerID logic layer name is matched, otherwise returns DLID_PRIMARY.
      */
@@ -124,6 +131,12 @@ public:
     DFBSurfaceCapabilities
     getWindowSurfaceCaps() const;
 
+    /*!
+     * Returns whether window repaints are recorded and submitted in batches.
+     */
+    bool
+    useBatchDrawing() const;
+
     /*!
      * Returns path to theme directory.
      */
@@ -191,11 +204,33 @@ public:
     getCursorImage() const;
 
     /*!
-     * Plays a sound from SoundMap.
+     * Plays a sound effect with given name.
      */
     void
     playSoundEffect(const std::string& id = "Click");
 
+    /*!
+     * Plays a sound effect with given id.
+     *
+     * @see soundEffectID()
+     */
+    void
+    playSoundEffect(int id);
+
+    /*!
+     * Returns id of sound effect with given name, or -1 if there is no such effect.
+     *
+     * Ids are assigned in the order effects are listed in configuration.
+     */
+    int
+    soundEffectID(const std::string& name) const;
+
+    /*!
+     * Returns signature of sound effect names in id order.
+     */
+    unsigned int
+    soundEffectSignature() const;
+
     /*!
      * Sets level for sound effects.
      *
@@ -244,6 +279,7 @@ private:
         LayerFlipMode flipMode;             // Controls surface flip behaviour
         IDirectFBDisplayLayer* layer;
         Rectangle rect;
+        bool scanout;                       // Spare layer for showing client surfaces directly
     };
 
     struct LogicLayer
@@ -269,20 +305,31 @@ private:
         WindowConf()
                 : fsu(false),
                   flipMode(FlipNew),
-                  caps((DFBSurfaceCapabilities) (DSCAPS_DOUBLE | DSCAPS_VIDEOONLY))
+                  caps((DFBSurfaceCapabilities) (DSCAPS_DOUBLE | DSCAPS_VIDEOONLY)),
+                  batch(false)
         {
         }
 
         bool fsu;
         LayerFlipMode flipMode;
         DFBSurfaceCapabilities caps;
+        bool batch;
     };
 
 #ifdef ILIXI_HAVE_FUSIONSOUND
-    typedef std::map<std::string, Sound*> SoundMap;
-    SoundMap _soundMap;
+    typedef std::map<std::string, unsigned int> SoundIDMap;
+    //! Sound effect ids by name.
+    SoundIDMap _soundIDs;
+    typedef std::vector<Sound*> SoundList;
+    //! Sound effects by id, NULL if effects are played by compositor.
+    SoundList _sounds;
+    //! Signature of sound effect names, used for matching ids with compositor.
+    unsigned int _soundSignature;
     //! Master sound effect level
     float _soundLevel;
+    class SoundLoader;
+    //! Loads sound effect samples in background.
+    SoundLoader* _soundLoader;
 #endif
 
 #ifdef ILIXI_HAVE_NLS
@@ -0,0 +1,254 @@
+/*
+ Copyright 2010-2015 Tarik Sekmen.
+
+ All Rights Reserved.
+
+ Written by Tarik Sekmen <tarik@ilixi.org>.
+
+ This file is part of ilixi.
+
+ ilixi is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ ilixi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <core/Profiler.h>
+#ifdef ILIXI_FRAME_PROFILER
+#include <core/Logger.h>
+#include <lib/FileSystem.h>
+#include <algorithm>
+#include <cxxabi.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+namespace ilixi
+{
+
+D_DEBUG_DOMAIN( ILX_PROFILER, "ilixi/core/Profiler", "Profiler");
+
+//! Number of events kept per thread.
+static const unsigned int __ringSize = 32768;
+
+struct ProfileEvent
+{
+    const char* name;
+    const char* type;
+    long long start;
+    int duration;
+    int tid;
+};
+
+//! Events of a thread, written by owner thread only.
+struct ProfileRing
+{
+    //! Number of events recorded so far.
+    volatile unsigned int head;
+    //! Set while a thread uses this ring.
+    volatile int owned;
+    //! Thread id of owner.
+    int tid;
+    ProfileRing* next;
+    ProfileEvent events[__ringSize];
+};
+
+//! Rings of all threads, rings of exited threads are reused.
+static ProfileRing* volatile __rings = NULL;
+static pthread_key_t __ringKey;
+static pthread_once_t __ringOnce = PTHREAD_ONCE_INIT;
+static volatile sig_atomic_t __dumpRequested = 0;
+
+static void
+requestDump(int)
+{
+    __dumpRequested = 1;
+}
+
+static void
+dumpAtExit()
+{
+    Profiler::dump();
+}
+
+static void
+releaseRing(void* ring)
+{
+    __sync_synchronize();
+    ((ProfileRing*) ring)->owned = 0;
+}
+
+static void
+initProfiler()
+{
+    pthread_key_create(&__ringKey, releaseRing);
+
+    struct sigaction act;
+    memset(&act, 0, sizeof(act));
+    act.sa_handler = requestDump;
+    act.sa_flags = SA_RESTART;
+    sigemptyset(&act.sa_mask);
+    sigaction(SIGUSR2, &act, NULL);
+
+    atexit(dumpAtExit);
+}
+
+static ProfileRing*
+threadRing()
+{
+    pthread_once(&__ringOnce, initProfiler);
+    ProfileRing* ring = (ProfileRing*) pthread_getspecific(__ringKey);
+    if (ring)
+        return ring;
+
+    for (ring = __rings; ring; ring = ring->next)
+        if (!ring->owned && __sync_bool_compare_and_swap(&ring->owned, 0, 1))
+            break;
+
+    if (!ring)
+    {
+        ring = (ProfileRing*) calloc(1, sizeof(ProfileRing));
+        if (!ring)
+            return NULL;
+        ring->owned = 1;
+        do
+            ring->next = __rings;
+        while (!__sync_bool_compare_and_swap(&__rings, ring->next, ring));
+    }
+    ring->tid = syscall(SYS_gettid);
+    pthread_setspecific(__ringKey, ring);
+    return ring;
+}
+
+//! Returns readable name of event, e.g. ilixi::PushButton::compose.
+static const std::string&
+eventName(const ProfileEvent& event, std::map<std::pair<const char*, const char*>, std::string>& names)
+{
+    std::pair<const char*, const char*> key(event.name, event.type);
+    std::map<std::pair<const char*, const char*>, std::string>::iterator it = names.find(key);
+    if (it != names.end())
+        return it->second;
+
+    std::string name;
+    if (event.type)
+    {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(event.type, NULL, NULL, &status);
+        name = status == 0 && demangled ? demangled : event.type;
+        free(demangled);
+        name.append("::");
+    }
+    name.append(event.name);
+
+    // Escape for JSON.
+    std::string escaped;
+    for (size_t i = 0; i < name.size(); ++i)
+    {
+        if (name[i] == '"' || name[i] == '\\')
+            escaped.push_back('\\');
+        escaped.push_back(name[i]);
+    }
+    return names.insert(std::make_pair(key, escaped)).first->second;
+}
+
+void
+Profiler::record(const char* name, const char* type, long long start, long long end)
+{
+    ProfileRing* ring = threadRing();
+    if (!ring)
+        return;
+
+    unsigned int head = ring->head;
+    ProfileEvent* event = &ring->events[head % __ringSize];
+    event->name = name;
+    event->type = type;
+    event->start = start;
+    event->duration = end - start;
+    event->tid = ring->tid;
+    __sync_synchronize();
+    ring->head = head + 1;
+}
+
+bool
+Profiler::dump(const std::string& path)
+{
+    std::string file = path;
+    if (file.empty())
+    {
+        char* var = getenv("ILX_TRACEFILE");
+        if (var)
+            file = var;
+        else
+            file = PrintF("%strace_%d.json", FileSystem::ilxDirectory().c_str(), getpid());
+    }
+
+    FILE* fp = fopen(file.c_str(), "w");
+    if (!fp)
+    {
+        ILOG_ERROR(ILX_PROFILER, "Cannot open %s\n", file.c_str());
+        return false;
+    }
+
+    int pid = getpid();
+    char exe[256];
+    ssize_t len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    exe[len > 0 ? len : 0] = 0;
+    unsigned int count = 0;
+    std::map<std::pair<const char*, const char*>, std::string> names;
+    std::vector<ProfileEvent> events;
+    fprintf(fp, "{\"traceEvents\":[\n");
+    fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}},\n", pid, pid, len > 0 ? FileSystem::fileName(exe).c_str() : "ilixi");
+    fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"main\"}}", pid, pid);
+    for (ProfileRing* ring = __rings; ring; ring = ring->next)
+    {
+        // Copy events, then drop those which may be overwritten while copying.
+        unsigned int head = ring->head;
+        __sync_synchronize();
+        unsigned int first = head > __ringSize ? head - __ringSize : 0;
+        events.assign(ring->events + (first % __ringSize), ring->events + __ringSize);
+        events.insert(events.end(), ring->events, ring->events + (first % __ringSize));
+        events.resize(head - first);
+        __sync_synchronize();
+        unsigned int current = ring->head;
+        unsigned int valid = current > __ringSize ? current - __ringSize : 0;
+        if (valid > first)
+            events.erase(events.begin(), events.begin() + std::min(valid - first, (unsigned int) events.size()));
+
+        for (std::vector<ProfileEvent>::const_iterator it = events.begin(); it != events.end(); ++it)
+            fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"ilixi\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%d,\"pid\":%d,\"tid\":%d}", eventName(*it, names).c_str(), it->start, it->duration, pid, it->tid);
+        count += events.size();
+    }
+    fprintf(fp, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(fp);
+
+    ILOG_NOTICE(ILX_PROFILER, "Wrote %u events to %s\n", count, file.c_str());
+    return true;
+}
+
+void
+Profiler::poll()
+{
+    if (__dumpRequested)
+    {
+        __dumpRequested = 0;
+        dump();
+    }
+}
+
+} /* namespace ilixi */
+
+#endif
@@ -0,0 +1,121 @@
+/*
+ Copyright 2010-2015 Tarik Sekmen.
+
+ All Rights Reserved.
+
+ Written by Tarik Sekmen <tarik@ilixi.org>.
+
+ This file is part of ilixi.
+
+ ilixi is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ ilixi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ILIXI_PROFILER_H_
+#define ILIXI_PROFILER_H_
+
+#include <ilixiConfig.h>
+
+#ifdef ILIXI_FRAME_PROFILER
+#include <string>
+#include <time.h>
+#include <typeinfo>
+
+namespace ilixi
+{
+
+//! Records how long each stage of a frame takes.
+/*!
+ * Stages are timed using ILIXI_PROFILE() scopes and stored in a ring buffer per thread,
+ * which holds the most recent events. Buffers are written as Chrome trace event JSON,
+ * which can be loaded in chrome://tracing, when process exits or receives SIGUSR2.
+ *
+ * Trace is written to ILX_TRACEFILE if set, otherwise to trace_<pid>.json inside
+ * ~/.ilixi/. Profiler is only available if ilixi is configured using --enable-frame-profiler.
+ */
+class Profiler
+{
+public:
+    //! Records time spent inside its scope.
+    class Scope
+    {
+    public:
+        /*!
+         * Starts timing.
+         *
+         * @param name of stage, must be a static string.
+         * @param type mangled type name, prepended to name if set.
+         */
+        Scope(const char* name, const char* type = NULL)
+                : _name(name),
+                  _type(type),
+                  _start(now())
+        {
+        }
+
+        /*!
+         * Records elapsed time.
+         */
+        ~Scope()
+        {
+            record(_name, _type, _start, now());
+        }
+
+    private:
+        const char* _name;
+        const char* _type;
+        long long _start;
+    };
+
+    /*!
+     * Returns monotonic time in microseconds.
+     */
+    static long long
+    now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+    }
+
+    /*!
+     * Adds an event to calling thread's buffer.
+     */
+    static void
+    record(const char* name, const char* type, long long start, long long end);
+
+    /*!
+     * Writes events of all threads to given file, or to default trace file if path is empty.
+     */
+    static bool
+    dump(const std::string& path = "");
+
+    /*!
+     * Writes trace if SIGUSR2 is received, called by Engine on main thread.
+     */
+    static void
+    poll();
+};
+
+} /* namespace ilixi */
+
+#define ILIXI_PROFILE(Name)                     ilixi::Profiler::Scope __ilixiProfileScope(Name)
+#define ILIXI_PROFILE_TYPE(Name, Object)        ilixi::Profiler::Scope __ilixiProfileScope(Name, typeid(Object).name())
+#define ILIXI_PROFILE_POLL()                    ilixi::Profiler::poll()
+#else // ILIXI_FRAME_PROFILER = 0
+#define ILIXI_PROFILE(Name)                     do {} while(0)
+#define ILIXI_PROFILE_TYPE(Name, Object)        do {} while(0)
+#define ILIXI_PROFILE_POLL()                    do {} while(0)
+#endif // end ILIXI_FRAME_PROFILER
+
+#endif /* ILIXI_PROFILER_H_ */
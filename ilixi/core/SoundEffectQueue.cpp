@@ -0,0 +1,325 @@
+/*
+ Copyright 2010-2015 Tarik Sekmen.
+
+ All Rights Reserved.
+
+ Written by Tarik Sekmen <tarik@ilixi.org>.
+
+ This file is part of ilixi.
+
+ ilixi is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ ilixi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <core/SoundEffectQueue.h>
+#include <core/Logger.h>
+#include <lib/FileSystem.h>
+#include <direct/clock.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace ilixi
+{
+
+D_DEBUG_DOMAIN( ILX_SOUNDEFFECTQUEUE, "ilixi/core/SoundEffectQueue", "SoundEffectQueue");
+
+//! Marks an initialised queue.
+static const unsigned int __magic = 0x494c5853;
+//! Time (ms) after which a claimed slot which is not published is skipped.
+static const long long __staleTimeout = 1000;
+
+static std::string
+queuePath()
+{
+    return FileSystem::ilxDirectory() + "ilx_sound.queue";
+}
+
+static void
+futexWait(volatile int* addr, int value, int timeout)
+{
+    struct timespec ts;
+    ts.tv_sec = timeout / 1000;
+    ts.tv_nsec = (timeout % 1000) * 1000000;
+    syscall(SYS_futex, addr, FUTEX_WAIT, value, timeout < 0 ? NULL : &ts, NULL, 0);
+}
+
+static void
+futexWake(volatile int* addr)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+SoundEffectQueue::SoundEffectQueue()
+        : _shared(NULL),
+          _owner(false),
+          _rejected(0),
+          _stalePos(0),
+          _staleSince(0)
+{
+}
+
+SoundEffectQueue::~SoundEffectQueue()
+{
+    release();
+}
+
+bool
+SoundEffectQueue::create(unsigned int signature)
+{
+    ILOG_TRACE_F(ILX_SOUNDEFFECTQUEUE);
+    release();
+    // Applications still attached to a stale queue keep its old file.
+    unlink(queuePath().c_str());
+    if (!map(true))
+        return false;
+
+    _owner = true;
+    _shared->signature = signature;
+    _shared->consumer = getpid();
+    _shared->head = 0;
+    _shared->tail = 0;
+    _shared->wakeups = 0;
+    _shared->sleeping = 0;
+    for (unsigned int i = 0; i < Capacity; ++i)
+        _shared->slots[i].sequence = i;
+    __sync_synchronize();
+    _shared->magic = __magic;
+    ILOG_DEBUG(ILX_SOUNDEFFECTQUEUE, " -> signature: %x\n", signature);
+    return true;
+}
+
+bool
+SoundEffectQueue::attach(unsigned int signature)
+{
+    ILOG_TRACE_F(ILX_SOUNDEFFECTQUEUE);
+    release();
+    if (!map(false))
+        return false;
+
+    if (_shared->magic != __magic)
+    {
+        ILOG_DEBUG(ILX_SOUNDEFFECTQUEUE, " -> Queue is not initialised.\n");
+        release();
+        return false;
+    }
+
+    if (!consumerAlive())
+    {
+        ILOG_DEBUG(ILX_SOUNDEFFECTQUEUE, " -> Compositor %d is not running, queue is stale.\n", _shared->consumer);
+        release();
+        return false;
+    }
+
+    if (_shared->signature != signature)
+    {
+        // Attach is retried, warn once for each compositor.
+        if (_rejected != _shared->consumer)
+        {
+            ILOG_WARNING(ILX_SOUNDEFFECTQUEUE, "Sound effects of compositor do not match, not using queue.\n");
+            _rejected = _shared->consumer;
+        }
+        release();
+        return false;
+    }
+    return true;
+}
+
+void
+SoundEffectQueue::release()
+{
+    if (!_shared)
+        return;
+
+    if (_owner)
+    {
+        _shared->magic = 0;
+        unlink(queuePath().c_str());
+        _owner = false;
+    }
+    munmap((void*) _shared, sizeof(Shared));
+    _shared = NULL;
+}
+
+bool
+SoundEffectQueue::valid() const
+{
+    return _shared != NULL;
+}
+
+bool
+SoundEffectQueue::consumerAlive() const
+{
+    if (!_shared || _shared->magic != __magic)
+        return false;
+    return kill(_shared->consumer, 0) == 0 || errno == EPERM;
+}
+
+bool
+SoundEffectQueue::push(unsigned int id)
+{
+    if (!_shared)
+        return false;
+
+    Slot* slot;
+    unsigned int pos = _shared->head;
+    while (true)
+    {
+        slot = &_shared->slots[pos % Capacity];
+        int diff = (int) (slot->sequence - pos);
+        if (diff == 0)
+        {
+            if (__sync_bool_compare_and_swap(&_shared->head, pos, pos + 1))
+                break;
+        } else if (diff < 0)
+        {
+            ILOG_DEBUG(ILX_SOUNDEFFECTQUEUE, " -> queue is full.\n");
+            return false;
+        }
+        pos = _shared->head;
+    }
+
+    slot->id = id;
+    __sync_synchronize();
+    // Fails if consumer skipped this slot as stale.
+    if (!__sync_bool_compare_and_swap(&slot->sequence, pos, pos + 1))
+    {
+        ILOG_DEBUG(ILX_SOUNDEFFECTQUEUE, " -> slot %u is skipped by consumer.\n", pos);
+        return false;
+    }
+
+    __sync_fetch_and_add(&_shared->wakeups, 1);
+    if (_shared->sleeping)
+        futexWake(&_shared->wakeups);
+    return true;
+}
+
+bool
+SoundEffectQueue::pop(unsigned int* id, int timeout)
+{
+    if (!_shared)
+        return false;
+
+    if (take(id))
+        return true;
+
+    int wakeups = _shared->wakeups;
+    _shared->sleeping = 1;
+    __sync_synchronize();
+    // A push after reading wakeups makes futex return at once.
+    if (!take(id))
+        futexWait(&_shared->wakeups, wakeups, timeout);
+    else
+    {
+        _shared->sleeping = 0;
+        return true;
+    }
+    _shared->sleeping = 0;
+    return take(id);
+}
+
+unsigned int
+SoundEffectQueue::signature(unsigned int seed, const char* name)
+{
+    // FNV-1a, names are separated by their terminating zero.
+    do
+    {
+        seed ^= (unsigned char) *name;
+        seed *= 16777619;
+    } while (*name++);
+    return seed;
+}
+
+bool
+SoundEffectQueue::map(bool create)
+{
+    std::string path = queuePath();
+    int fd = open(path.c_str(), create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0600);
+    if (fd < 0)
+    {
+        if (create)
+            ILOG_ERROR(ILX_SOUNDEFFECTQUEUE, "Cannot open %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (create ? ftruncate(fd, sizeof(Shared)) : (fstat(fd, &st) || st.st_size < (off_t) sizeof(Shared)))
+    {
+        ILOG_ERROR(ILX_SOUNDEFFECTQUEUE, "Cannot size %s\n", path.c_str());
+        close(fd);
+        return false;
+    }
+
+    void* ptr = mmap(NULL, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+    {
+        ILOG_ERROR(ILX_SOUNDEFFECTQUEUE, "Cannot map %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    _shared = (Shared*) ptr;
+    return true;
+}
+
+bool
+SoundEffectQueue::take(unsigned int* id)
+{
+    unsigned int pos;
+    Slot* slot;
+    while (true)
+    {
+        pos = _shared->tail;
+        slot = &_shared->slots[pos % Capacity];
+        if ((int) (slot->sequence - (pos + 1)) >= 0)
+            break;
+
+        // Empty, or slot is claimed by a producer which has not published it yet.
+        if (_shared->head == pos || !stale(pos))
+            return false;
+
+        // Producer exited between claiming and publishing slot.
+        if (__sync_bool_compare_and_swap(&slot->sequence, pos, pos + Capacity))
+        {
+            ILOG_WARNING(ILX_SOUNDEFFECTQUEUE, "Skipping slot %u which is never published.\n", pos);
+            _shared->tail = pos + 1;
+        }
+    }
+
+    *id = slot->id;
+    __sync_synchronize();
+    slot->sequence = pos + Capacity;
+    _shared->tail = pos + 1;
+    return true;
+}
+
+bool
+SoundEffectQueue::stale(unsigned int pos)
+{
+    long long now = direct_clock_get_millis();
+    if (_stalePos != pos || !_staleSince)
+    {
+        _stalePos = pos;
+        _staleSince = now;
+        return false;
+    }
+    return now - _staleSince >= __staleTimeout;
+}
+
+} /* namespace ilixi */
@@ -0,0 +1,170 @@
+/*
+ Copyright 2010-2015 Tarik Sekmen.
+
+ All Rights Reserved.
+
+ Written by Tarik Sekmen <tarik@ilixi.org>.
+
+ This file is part of ilixi.
+
+ ilixi is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ ilixi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ILIXI_SOUNDEFFECTQUEUE_H_
+#define ILIXI_SOUNDEFFECTQUEUE_H_
+
+namespace ilixi
+{
+//! Passes sound effect triggers from applications to compositor.
+/*!
+ * Queue is a ring of sound effect ids inside a file mapped by compositor and
+ * applications. Any number of applications can push ids without locking, a single
+ * thread inside compositor pops them and plays the effects.
+ *
+ * Sound effect ids are assigned in the order effects are listed in configuration.
+ * Compositor stores a signature of effect names in queue and applications attach only if
+ * their own signature matches, so an id means the same effect on both sides.
+ *
+ * Queue also stores process id of compositor, so applications can detect a queue left
+ * behind by a crashed compositor, see consumerAlive(). A slot claimed by an application
+ * which exits before publishing it is skipped by compositor after a timeout.
+ */
+class SoundEffectQueue
+{
+public:
+    /*!
+     * Constructor.
+     */
+    SoundEffectQueue();
+
+    /*!
+     * Destructor.
+     *
+     * Unmaps queue.
+     */
+    ~SoundEffectQueue();
+
+    /*!
+     * Creates queue, used by compositor.
+     *
+     * @param signature of sound effect names.
+     */
+    bool
+    create(unsigned int signature);
+
+    /*!
+     * Attaches to queue created by compositor, used by applications.
+     *
+     * Returns false if there is no queue or signature does not match.
+     */
+    bool
+    attach(unsigned int signature);
+
+    /*!
+     * Unmaps queue, compositor also removes its file.
+     */
+    void
+    release();
+
+    /*!
+     * Returns true if queue is mapped.
+     */
+    bool
+    valid() const;
+
+    /*!
+     * Returns true if queue is mapped and compositor which created it is still running.
+     */
+    bool
+    consumerAlive() const;
+
+    /*!
+     * Adds a sound effect id to queue. Returns false if queue is full or not mapped.
+     */
+    bool
+    push(unsigned int id);
+
+    /*!
+     * Removes next sound effect id from queue, waiting up to timeout (ms) if queue is empty.
+     *
+     * Returns false if there is no id after timeout. Only a single thread should pop.
+     */
+    bool
+    pop(unsigned int* id, int timeout);
+
+    /*!
+     * Adds given name to signature and returns new signature.
+     *
+     * Signature of a list of names is built by starting with 0 and adding names in id order.
+     */
+    static unsigned int
+    signature(unsigned int seed, const char* name);
+
+private:
+    enum
+    {
+        Capacity = 64
+    };
+
+    //! This struct stores a queued sound effect id.
+    struct Slot
+    {
+        //! Position this slot is ready for, see push() and pop().
+        volatile unsigned int sequence;
+        unsigned int id;
+    };
+
+    //! This struct specifies layout of mapped file.
+    struct Shared
+    {
+        //! Set by compositor once queue is initialised.
+        volatile unsigned int magic;
+        unsigned int signature;
+        //! Process id of compositor.
+        int consumer;
+        //! Next position to write, shared by producers.
+        volatile unsigned int head;
+        //! Next position to read, modified by consumer only.
+        volatile unsigned int tail;
+        //! Incremented after each push, consumer waits on this futex.
+        volatile int wakeups;
+        //! Set while consumer is waiting.
+        volatile int sleeping;
+        Slot slots[Capacity];
+    };
+
+    //! This property stores mapped queue.
+    Shared* _shared;
+    //! This property is true if queue is created by this process.
+    bool _owner;
+    //! Process id of compositor whose queue is rejected due to signature mismatch.
+    int _rejected;
+    //! Position consumer is waiting on, see stale().
+    unsigned int _stalePos;
+    //! Time (ms) when consumer started waiting on _stalePos.
+    long long _staleSince;
+
+    bool
+    map(bool create);
+
+    bool
+    take(unsigned int* id);
+
+    //! Returns true if consumer waits on a claimed slot at pos for too long.
+    bool
+    stale(unsigned int pos);
+};
+
+} /* namespace ilixi */
+#endif /* ILIXI_SOUNDEFFECTQUEUE_H_ */
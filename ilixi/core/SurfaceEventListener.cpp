@@ -31,12 +31,40 @@ namespace ilixi
 {
 D_DEBUG_DOMAIN(ILX_SURFACELISTENER_UPDATES, "ilixi/core/SurfaceEventListener", "SurfaceEventListener");
 
+static inline long long
+regionArea(const DFBRegion& r)
+{
+    return (long long) (r.x2 - r.x1 + 1) * (r.y2 - r.y1 + 1);
+}
+
+static inline DFBRegion
+regionUnion(const DFBRegion& a, const DFBRegion& b)
+{
+    DFBRegion r;
+    r.x1 = a.x1 < b.x1 ? a.x1 : b.x1;
+    r.y1 = a.y1 < b.y1 ? a.y1 : b.y1;
+    r.x2 = a.x2 > b.x2 ? a.x2 : b.x2;
+    r.y2 = a.y2 > b.y2 ? a.y2 : b.y2;
+    return r;
+}
+
+//! Returns true if regions overlap or share an edge.
+static inline bool
+regionTouches(const DFBRegion& a, const DFBRegion& b)
+{
+    return a.x1 <= b.x2 + 1 && b.x1 <= a.x2 + 1 && a.y1 <= b.y2 + 1 && b.y1 <= a.y2 + 1;
+}
+
 SurfaceEventListener::SurfaceEventListener()
         : _surfaceID(0),
           _sourceSurface(NULL),
           _cb(this),
           _lastTime(0)
 {
+    _damage.firstFlip = 0;
+    _damage.lastFlip = 0;
+    _damage.flips = 0;
+    _damage.count = 0;
 }
 
 SurfaceEventListener::~SurfaceEventListener()
@@ -75,6 +103,12 @@ SurfaceEventListener::startSurfaceEventListener()
     _cb.start();
 }
 
+const SurfaceEventListener::SourceDamage&
+SurfaceEventListener::sourceDamage() const
+{
+    return _damage;
+}
+
 bool
 SurfaceEventListener::consumeSurfaceEvent(const DFBSurfaceEvent& event)
 {
@@ -85,8 +119,8 @@ SurfaceEventListener::consumeSurfaceEvent(const DFBSurfaceEvent& event)
             onSourceDestroyed(event);
         else if (event.type == DSEVT_UPDATE)
         {
-            _queue.push(event);
-            ILOG_DEBUG(ILX_SURFACELISTENER_UPDATES, " -> surface id: %d -- flip count: %d -- queue.size: %d\n", event.surface_id, event.flip_count, _queue.size());
+            addDamage(event);
+            ILOG_DEBUG(ILX_SURFACELISTENER_UPDATES, " -> surface id: %d -- flip count: %d -- flips: %u regions: %d\n", event.surface_id, event.flip_count, _damage.flips, _damage.count);
             _cb.start();
 
             _lastTime = event.time_stamp;
@@ -99,19 +133,79 @@ SurfaceEventListener::consumeSurfaceEvent(const DFBSurfaceEvent& event)
 bool
 SurfaceEventListener::funck()
 {
-    if (!_queue.empty())
+    if (_damage.flips)
     {
-        // FIXME: avoid queuing up too much
-        while (_queue.size() > 2)
-            _queue.pop();
-
-        if (onSourceUpdate(_queue.front()))
+        DFBSurfaceEvent event = _event;
+        event.update = _damage.regions[0];
+        for (int i = 1; i < _damage.count; ++i)
+            event.update = regionUnion(event.update, _damage.regions[i]);
+#ifdef ILIXI_STEREO_OUTPUT
+        event.update_right = _damage.right;
+#endif
+
+        if (onSourceUpdate(event))
         {
-            _queue.pop();
+            ILOG_DEBUG(ILX_SURFACELISTENER_UPDATES, " -> surface id: %d -- handled flips %u-%u\n", _surfaceID, _damage.firstFlip, _damage.lastFlip);
+            _damage.flips = 0;
+            _damage.count = 0;
             return true;
         }
     }
     return false;
 }
 
+void
+SurfaceEventListener::addDamage(const DFBSurfaceEvent& event)
+{
+    _event = event;
+    if (!_damage.flips)
+    {
+        _damage.firstFlip = event.flip_count;
+        _damage.count = 0;
+#ifdef ILIXI_STEREO_OUTPUT
+        _damage.right = event.update_right;
+    } else
+        _damage.right = regionUnion(_damage.right, event.update_right);
+#else
+    }
+#endif
+    _damage.lastFlip = event.flip_count;
+    ++_damage.flips;
+
+    DFBRegion region = event.update;
+    while (true)
+    {
+        // Merge with a region it touches, or with the region growing least if set is full.
+        int target = -1;
+        long long cost = 0;
+        for (int i = 0; i < _damage.count; ++i)
+        {
+            if (regionTouches(_damage.regions[i], region))
+            {
+                target = i;
+                break;
+            }
+            if (_damage.count == MaxDamageRegions)
+            {
+                long long grow = regionArea(regionUnion(_damage.regions[i], region)) - regionArea(_damage.regions[i]) - regionArea(region);
+                if (target < 0 || grow < cost)
+                {
+                    target = i;
+                    cost = grow;
+                }
+            }
+        }
+
+        if (target < 0)
+        {
+            _damage.regions[_damage.count++] = region;
+            break;
+        }
+
+        // Merged region may now touch others, so take it out and insert again.
+        region = regionUnion(_damage.regions[target], region);
+        _damage.regions[target] = _damage.regions[--_damage.count];
+    }
+}
+
 } /* namespace ilixi */
@@ -24,14 +24,19 @@
 #ifndef ILIXI_SURFACELISTENER_H_
 #define ILIXI_SURFACELISTENER_H_
 
+#include <ilixiConfig.h>
 #include <directfb.h>
-#include <queue>
 #include <core/Callback.h>
 
 namespace ilixi
 {
 
 //! Listens to incoming events from a surface.
+/*!
+ * Update events of source surface are not queued. Damage of all flips which are not
+ * handled yet is merged into a small set of regions and delivered with a single
+ * call to onSourceUpdate(), using the flip count of latest flip.
+ */
 class SurfaceEventListener : public Functionoid
 {
     friend class Engine;
@@ -61,6 +66,30 @@ public:
     sourceSurface() const;
 
 protected:
+    enum
+    {
+        MaxDamageRegions = 4    //!< Maximum number of regions in SourceDamage.
+    };
+
+    //! This struct stores damage of flips which are not handled yet.
+    struct SourceDamage
+    {
+        //! Flip count of first merged flip.
+        unsigned int firstFlip;
+        //! Flip count of latest merged flip.
+        unsigned int lastFlip;
+        //! Number of merged flips.
+        unsigned int flips;
+        //! Number of regions.
+        int count;
+        //! Damaged regions in source surface coordinates, these do not overlap.
+        DFBRegion regions[MaxDamageRegions];
+#ifdef ILIXI_STEREO_OUTPUT
+        //! Bounding region of damage for right eye.
+        DFBRegion right;
+#endif
+    };
+
     //! ID of source surface.
     DFBSurfaceID _surfaceID;
 
@@ -82,7 +111,11 @@ protected:
     /*!
      * This method is called if source surface is updated.
      *
-     * @param update Region to update in source surface coordinates.
+     * Event stores latest flip count and bounding region of damage, use sourceDamage() for
+     * individual regions. If this method returns false damage is kept and merged with
+     * following updates.
+     *
+     * @param event Update event in source surface coordinates.
      */
     virtual bool
     onSourceUpdate(const DFBSurfaceEvent& event) = 0;
@@ -98,11 +131,23 @@ protected:
     void
     startSurfaceEventListener();
 
+    /*!
+     * Returns damage which is being delivered, valid inside onSourceUpdate().
+     */
+    const SourceDamage&
+    sourceDamage() const;
+
 private:
     //! Callback for stack.
     Callback _cb;
-    //! Stack of surface events waiting.
-    std::queue<DFBSurfaceEvent> _queue;
+    //! Latest update event.
+    DFBSurfaceEvent _event;
+    //! Damage accumulated since last handled update.
+    SourceDamage _damage;
+
+    //! Merges region of given update event into damage.
+    void
+    addDamage(const DFBSurfaceEvent& event);
 
     //! Intercepts surface events of source surface.
     bool
@@ -41,9 +41,30 @@ const double CPM_D2R = 0.0174532925;
 
 D_DEBUG_DOMAIN(ILX_CPAINTER, "ilixi/graphics/CairoPainter", "CairoPainter");
 
+//! Maximum number of cached rounded rectangles.
+static const unsigned int __roundRectanglesMax = 64;
+
+CairoPainter::NamedPathMap CairoPainter::__namedPaths;
+CairoPainter::RoundRectanglePathMap CairoPainter::__roundRectangles;
+unsigned int CairoPainter::__pathTick = 0;
+cairo_t* CairoPainter::__pathContext = NULL;
+
+bool
+CairoPainter::RoundRectangleKey::operator<(const RoundRectangleKey& other) const
+{
+    if (width != other.width)
+        return width < other.width;
+    if (height != other.height)
+        return height < other.height;
+    if (radius != other.radius)
+        return radius < other.radius;
+    return corners < other.corners;
+}
+
 CairoPainter::CairoPainter(Widget* widget)
         : _myWidget(widget),
           _antiAliasMode(AliasSubPixel),
+          _context(NULL),
           _state(PFNone)
 {
     ILOG_TRACE(ILX_CPAINTER);
@@ -59,32 +80,46 @@ void
 CairoPainter::begin(const PaintEvent& event)
 {
     ILOG_TRACE(ILX_CPAINTER);
-    _myWidget->surface()->lock();
-    _context = _myWidget->surface()->cairoContext();
-    cairo_set_antialias(_context, (cairo_antialias_t) _antiAliasMode);
+    Surface* surface = _myWidget->surface();
+    surface->flushRecording();
+    // context is created once and reused, it is not modified until locked.
+    _context = surface->cairoContext();
+    if (!_context)
+        return;
+
+    surface->lock();
 #ifdef ILIXI_STEREO_OUTPUT
-    if (_myWidget->surface()->flags() & Surface::SharedSurface)
-    {
-        if (event.eye == PaintEvent::LeftEye)
-        _myWidget->surface()->clip(event.rect);
-        else
-        _myWidget->surface()->clip(event.right);
-    } else
-    {
-        if (event.eye == PaintEvent::LeftEye)
-        _myWidget->surface()->clip(Rectangle(event.rect.x() - _myWidget->absX() - _myWidget->z(), event.rect.y() - _myWidget->absY(), event.rect.width(), event.rect.height()));
-        else
-        _myWidget->surface()->clip(Rectangle(event.right.x() - _myWidget->absX() + _myWidget->z(), event.right.y() - _myWidget->absY(), event.right.width(), event.right.height()));
-    }
+    Rectangle rect = event.eye == PaintEvent::LeftEye ? event.rect : event.right;
+    if (surface->flags() & Surface::SharedSurface)
+        surface->clip(rect);
+    else if (event.eye == PaintEvent::LeftEye)
+        surface->clip(Rectangle(rect.x() - _myWidget->absX() - _myWidget->z(), rect.y() - _myWidget->absY(), rect.width(), rect.height()));
+    else
+        surface->clip(Rectangle(rect.x() - _myWidget->absX() + _myWidget->z(), rect.y() - _myWidget->absY(), rect.width(), rect.height()));
 #else
-    if (_myWidget->surface()->flags() & Surface::SharedSurface)
-        _myWidget->surface()->clip(event.rect);
+    const Rectangle& rect = event.rect;
+    if (surface->flags() & Surface::SharedSurface)
+        surface->clip(rect);
     else
-        _myWidget->surface()->clip(Rectangle(event.rect.x() - _myWidget->absX(), event.rect.y() - _myWidget->absY(), event.rect.width(), event.rect.height()));
+        surface->clip(Rectangle(rect.x() - _myWidget->absX(), rect.y() - _myWidget->absY(), rect.width(), rect.height()));
 #endif
     _state = PFActive;
-    _myWidget->surface()->dfbSurface()->SetDrawingFlags(_myWidget->surface()->dfbSurface(), DSDRAW_NOFX);
-    _myWidget->surface()->dfbSurface()->SetPorterDuff(_myWidget->surface()->dfbSurface(), DSPD_SRC_OVER);
+    surface->dfbSurface()->SetDrawingFlags(surface->dfbSurface(), DSDRAW_NOFX);
+    surface->dfbSurface()->SetPorterDuff(surface->dfbSurface(), DSPD_SRC_OVER);
+
+    // Context may be shared with other widgets, state set here is reverted in end().
+    cairo_save(_context);
+    cairo_new_path(_context);
+    cairo_set_antialias(_context, (cairo_antialias_t) _antiAliasMode);
+    if (surface->flags() & Surface::SharedSurface)
+#ifdef ILIXI_STEREO_OUTPUT
+        cairo_translate(_context, _myWidget->absX(), _myWidget->absY());
+#else
+        cairo_translate(_context, surface->xOffset(), surface->yOffset());
+#endif
+    Rectangle clip = _myWidget->mapToSurface(rect);
+    cairo_rectangle(_context, clip.x(), clip.y(), clip.width(), clip.height());
+    cairo_clip(_context);
 }
 
 void
@@ -94,7 +129,12 @@ CairoPainter::end()
     if (_state & PFActive)
     {
         _state = PFNone;
-        cairo_surface_flush(_myWidget->surface()->cairoSurface());
+        cairo_new_path(_context);
+        cairo_restore(_context);
+        // Drawing is clipped to event rectangle, so only damaged pixels are written back.
+        cairo_surface_flush(cairo_get_target(_context));
+        // cairo changes DirectFB state of surface directly.
+        _myWidget->surface()->dfbState()->invalidate();
         _myWidget->surface()->unlock();
     }
 }
@@ -161,7 +201,11 @@ CairoPainter::setBrush(const Brush& brush)
 {
     ILOG_TRACE(ILX_CPAINTER);
     _brush = brush;
-    _brush.applyBrush(_context);
+    if (_state & PFActive)
+    {
+        _brush.applyBrush(_context);
+        _state = (PainterFlags) (_state | PFBrushActive);
+    }
 }
 
 void
@@ -196,10 +240,7 @@ CairoPainter::drawArc(double x, double y, double width, double height, double an
 {
     ILOG_TRACE(ILX_CPAINTER);
     cairo_save(_context);
-    if (_myWidget->surface()->flags() & Surface::SharedSurface)
-        cairo_translate(_context, _myWidget->absX() + x + width * 0.5, _myWidget->absY() + y + height * 0.5);
-    else
-        cairo_translate(_context, x + width * 0.5, y + height * 0.5);
+    cairo_translate(_context, x + width * 0.5, y + height * 0.5);
     cairo_scale(_context, width * 0.5, height * 0.5);
     cairo_arc(_context, 0.0, 0.0, 1.0, angle1 * CPM_D2R, angle2 * CPM_D2R);
     cairo_restore(_context);
@@ -218,10 +259,7 @@ CairoPainter::drawChord(double x, double y, double width, double height, double
 {
     ILOG_TRACE(ILX_CPAINTER);
     cairo_save(_context);
-    if (_myWidget->surface()->flags() & Surface::SharedSurface)
-        cairo_translate(_context, _myWidget->absX() + x + width * 0.5, _myWidget->absY() + y + height * 0.5);
-    else
-        cairo_translate(_context, x + width * 0.5, y + height * 0.5);
+    cairo_translate(_context, x + width * 0.5, y + height * 0.5);
     cairo_scale(_context, width * 0.5, height * 0.5);
     cairo_arc(_context, 0.0, 0.0, 1.0, angle1 * CPM_D2R, angle2 * CPM_D2R);
     cairo_close_path(_context);
@@ -241,10 +279,7 @@ CairoPainter::drawEllipse(double x, double y, double width, double height, Drawi
     ILOG_TRACE(ILX_CPAINTER);
     cairo_save(_context);
     cairo_new_sub_path(_context);
-    if (_myWidget->surface()->flags() & Surface::SharedSurface)
-        cairo_translate(_context, _myWidget->absX() + x + width * 0.5, _myWidget->absY() + y + height * 0.5);
-    else
-        cairo_translate(_context, x + width * 0.5, y + height * 0.5);
+    cairo_translate(_context, x + width * 0.5, y + height * 0.5);
     cairo_scale(_context, width * 0.5, height * 0.5);
     cairo_arc(_context, 0.0, 0.0, 1.0, 0.0, 2 * CPM_PI);
     cairo_close_path(_context);
@@ -262,15 +297,8 @@ void
 CairoPainter::drawLine(double x1, double y1, double x2, double y2, DrawingMode mode)
 {
     ILOG_TRACE(ILX_CPAINTER);
-    if (_myWidget->surface()->flags() & Surface::SharedSurface)
-    {
-        cairo_move_to(_context, _myWidget->absX() + x1, _myWidget->absY() + y1);
-        cairo_line_to(_context, _myWidget->absX() + x2, _myWidget->absY() + y2);
-    } else
-    {
-        cairo_move_to(_context, x1, y1);
-        cairo_line_to(_context, x2, y2);
-    }
+    cairo_move_to(_context, x1, y1);
+    cairo_line_to(_context, x2, y2);
     applyDrawingMode(mode);
 }
 
@@ -291,17 +319,9 @@ CairoPainter::drawPolygon(const Point* points, int pointCount, DrawingMode mode)
 {
     ILOG_TRACE(ILX_CPAINTER);
     cairo_new_sub_path(_context);
-    if (_myWidget->surface()->flags() & Surface::SharedSurface)
-    {
-        cairo_move_to(_context, _myWidget->absX() + points[0].x(), _myWidget->absY() + points[0].y());
-        for (int i = 1; i < pointCount; i++)
-            cairo_line_to(_context, _myWidget->absX() + points[i].x(), _myWidget->absY() + points[i].y());
-    } else
-    {
-        cairo_move_to(_context, points[0].x(), points[0].y());
-        for (int i = 1; i < pointCount; i++)
-            cairo_line_to(_context, points[i].x(), points[i].y());
-    }
+    cairo_move_to(_context, points[0].x(), points[0].y());
+    for (int i = 1; i < pointCount; i++)
+        cairo_line_to(_context, points[i].x(), points[i].y());
     cairo_close_path(_context);
     applyDrawingMode(mode);
 }
@@ -312,10 +332,7 @@ CairoPainter::drawRectangle(double x, double y, double width, double height, Dra
     ILOG_TRACE(ILX_CPAINTER);
     if (mode != FillPath)
         getUserCoordinates(x, y, width, height);
-    if (_myWidget->surface()->flags() & Surface::SharedSurface)
-        cairo_rectangle(_context, _myWidget->absX() + x, _myWidget->absY() + y, width, height);
-    else
-        cairo_rectangle(_context, x, y, width, height);
+    cairo_rectangle(_context, x, y, width, height);
     applyDrawingMode(mode);
 }
 
@@ -331,70 +348,11 @@ CairoPainter::drawRoundRectangle(double x, double y, double width, double height
     ILOG_TRACE(ILX_CPAINTER);
     if (mode != FillPath)
         getUserCoordinates(x, y, width, height);
+    RoundRectangleKey key = { width, height, radius, corners };
+    cairo_path_t* path = roundRectanglePath(key);
     cairo_save(_context);
-    cairo_new_sub_path(_context);
-
-    // Top-right
-    if (corners & TopRight)
-    {
-        if (_myWidget->surface()->flags() & Surface::SharedSurface)
-            cairo_arc(_context, _myWidget->absX() + x + width - radius, _myWidget->absY() + y + radius, radius, -1.57079628, 0);
-        else
-            cairo_arc(_context, x + width - radius, y + radius, radius, -1.57079628, 0);
-    } else
-    {
-        if (_myWidget->surface()->flags() & Surface::SharedSurface)
-            cairo_line_to(_context, _myWidget->absX() + x + width, _myWidget->absY() + y);
-        else
-            cairo_line_to(_context, x + width, y);
-    }
-
-    // Bottom-right
-    if (corners & BottomRight)
-    {
-        if (_myWidget->surface()->flags() & Surface::SharedSurface)
-            cairo_arc(_context, _myWidget->absX() + x + width - radius, _myWidget->absY() + y + height - radius, radius, 0, 1.57079628);
-        else
-            cairo_line_to(_context, x + width, y + height);
-    } else
-    {
-        if (_myWidget->surface()->flags() & Surface::SharedSurface)
-            cairo_line_to(_context, _myWidget->absX() + x + width, _myWidget->absY() + y + height);
-        else
-            cairo_line_to(_context, x + width, y + height);
-    }
-
-    // Bottom-left
-    if (corners & BottomLeft)
-    {
-        if (_myWidget->surface()->flags() & Surface::SharedSurface)
-            cairo_arc(_context, _myWidget->absX() + x + radius, _myWidget->absY() + y + height - radius, radius, 1.57079628, 3.14159265);
-        else
-            cairo_arc(_context, x + radius, y + height - radius, radius, 1.57079628, 3.14159265);
-    } else
-    {
-        if (_myWidget->surface()->flags() & Surface::SharedSurface)
-            cairo_line_to(_context, _myWidget->absX() + x, _myWidget->absY() + y + height);
-        else
-            cairo_line_to(_context, x, y + height);
-    }
-
-    // Top-left
-    if (corners & TopLeft)
-    {
-        if (_myWidget->surface()->flags() & Surface::SharedSurface)
-            cairo_arc(_context, _myWidget->absX() + x + radius, _myWidget->absY() + y + radius, radius, 3.14159265, 4.712388975);
-        else
-            cairo_arc(_context, x + radius, y + radius, radius, 3.14159265, 4.712388975);
-    } else
-    {
-        if (_myWidget->surface()->flags() & Surface::SharedSurface)
-            cairo_line_to(_context, _myWidget->absX() + x, _myWidget->absY() + y);
-        else
-            cairo_line_to(_context, x, y);
-    }
-
-    cairo_close_path(_context);
+    cairo_translate(_context, x, y);
+    cairo_append_path(_context, path);
     cairo_restore(_context);
     applyDrawingMode(mode);
 }
@@ -409,15 +367,8 @@ void
 CairoPainter::drawPoint(double x, double y)
 {
     ILOG_TRACE(ILX_CPAINTER);
-    if (_myWidget->surface()->flags() & Surface::SharedSurface)
-    {
-        cairo_move_to(_context, _myWidget->absX() + x, _myWidget->absY() + y);
-        cairo_line_to(_context, _myWidget->absX() + x, _myWidget->absY() + y);
-    } else
-    {
-        cairo_move_to(_context, x, y);
-        cairo_line_to(_context, x, y);
-    }
+    cairo_move_to(_context, x, y);
+    cairo_line_to(_context, x, y);
     applyCairoPen();
 }
 
@@ -440,10 +391,7 @@ CairoPainter::drawText(const std::string& text, int x, int y)
     if (_state & PFActive)
     {
         applyCairoFont();
-        if (_myWidget->surface()->flags() & Surface::SharedSurface)
-            cairo_move_to(_context, _myWidget->absX() + x, _myWidget->absY() + y);
-        else
-            cairo_move_to(_context, x, y);
+        cairo_move_to(_context, x, y);
         cairo_show_text(_context, text.c_str());
         applyCairoBrush();
     }
@@ -459,10 +407,7 @@ CairoPainter::drawLayout(const TextLayout& layout, int x, int y)
     if (_state & PFActive)
     {
         applyCairoFont();
-        if (_myWidget->surface()->flags() & Surface::SharedSurface)
-            layout.drawTextLayout(_context, _myWidget->absX() + x, _myWidget->absY() + y);
-        else
-            layout.drawTextLayout(_context, x, y);
+        layout.drawTextLayout(_context, x, y);
         applyCairoBrush();
     }
 }
@@ -474,6 +419,67 @@ CairoPainter::drawCurrentPath(DrawingMode mode)
         applyDrawingMode(mode);
 }
 
+void
+CairoPainter::cachePath(const std::string& name)
+{
+    ILOG_TRACE(ILX_CPAINTER);
+    if (!(_state & PFActive))
+        return;
+    cairo_path_t* path = cairo_copy_path(_context);
+    cairo_new_path(_context);
+    if (path->status != CAIRO_STATUS_SUCCESS)
+    {
+        ILOG_ERROR(ILX_CPAINTER, "Cannot copy path %s: %s\n", name.c_str(), cairo_status_to_string(path->status));
+        cairo_path_destroy(path);
+        return;
+    }
+
+    NamedPathMap::iterator it = __namedPaths.find(name);
+    if (it != __namedPaths.end())
+    {
+        cairo_path_destroy(it->second);
+        it->second = path;
+    } else
+        __namedPaths.insert(std::make_pair(name, path));
+}
+
+bool
+CairoPainter::drawCachedPath(const std::string& name, double x, double y, DrawingMode mode)
+{
+    ILOG_TRACE(ILX_CPAINTER);
+    if (!(_state & PFActive))
+        return false;
+    NamedPathMap::iterator it = __namedPaths.find(name);
+    if (it == __namedPaths.end())
+        return false;
+
+    cairo_save(_context);
+    cairo_translate(_context, x, y);
+    cairo_append_path(_context, it->second);
+    cairo_restore(_context);
+    applyDrawingMode(mode);
+    return true;
+}
+
+void
+CairoPainter::releasePathCache()
+{
+    ILOG_TRACE_F(ILX_CPAINTER);
+    for (NamedPathMap::iterator it = __namedPaths.begin(); it != __namedPaths.end(); ++it)
+        cairo_path_destroy(it->second);
+    __namedPaths.clear();
+
+    for (RoundRectanglePathMap::iterator it = __roundRectangles.begin(); it != __roundRectangles.end(); ++it)
+        cairo_path_destroy(it->second.path);
+    __roundRectangles.clear();
+
+    if (__pathContext)
+    {
+        cairo_destroy(__pathContext);
+        __pathContext = NULL;
+    }
+}
+
 void
 CairoPainter::applyCairoBrush()
 {
@@ -540,4 +546,67 @@ CairoPainter::getUserCoordinates(double &x, double &y, double &width, double &he
     height -= offsetEnd;
 }
 
+cairo_path_t*
+CairoPainter::roundRectanglePath(const RoundRectangleKey& key)
+{
+    RoundRectanglePathMap::iterator it = __roundRectangles.find(key);
+    if (it != __roundRectangles.end())
+    {
+        it->second.used = ++__pathTick;
+        return it->second.path;
+    }
+
+    if (!__pathContext)
+    {
+        cairo_surface_t* scratch = cairo_image_surface_create(CAIRO_FORMAT_A8, 1, 1);
+        __pathContext = cairo_create(scratch);
+        cairo_surface_destroy(scratch);
+    }
+
+    double width = key.width;
+    double height = key.height;
+    int radius = key.radius;
+    cairo_new_path(__pathContext);
+    cairo_new_sub_path(__pathContext);
+
+    if (key.corners & TopRight)
+        cairo_arc(__pathContext, width - radius, radius, radius, -1.57079628, 0);
+    else
+        cairo_line_to(__pathContext, width, 0);
+
+    if (key.corners & BottomRight)
+        cairo_arc(__pathContext, width - radius, height - radius, radius, 0, 1.57079628);
+    else
+        cairo_line_to(__pathContext, width, height);
+
+    if (key.corners & BottomLeft)
+        cairo_arc(__pathContext, radius, height - radius, radius, 1.57079628, 3.14159265);
+    else
+        cairo_line_to(__pathContext, 0, height);
+
+    if (key.corners & TopLeft)
+        cairo_arc(__pathContext, radius, radius, radius, 3.14159265, 4.712388975);
+    else
+        cairo_line_to(__pathContext, 0, 0);
+
+    cairo_close_path(__pathContext);
+    cairo_path_t* path = cairo_copy_path(__pathContext);
+    cairo_new_path(__pathContext);
+
+    if (__roundRectangles.size() >= __roundRectanglesMax)
+    {
+        RoundRectanglePathMap::iterator oldest = __roundRectangles.begin();
+        for (RoundRectanglePathMap::iterator i = __roundRectangles.begin(); i != __roundRectangles.end(); ++i)
+            if (i->second.used < oldest->second.used)
+                oldest = i;
+        cairo_path_destroy(oldest->second.path);
+        __roundRectangles.erase(oldest);
+    }
+
+    CachedPath item = { path, ++__pathTick };
+    __roundRectangles.insert(std::make_pair(key, item));
+    ILOG_DEBUG(ILX_CPAINTER, " -> Cached rounded rectangle %.1fx%.1f radius %d\n", width, height, radius);
+    return path;
+}
+
 } /* namespace ilixi */
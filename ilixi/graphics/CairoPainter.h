@@ -25,6 +25,7 @@
 #define ILIXI_CAIROPAINTER_H_
 
 #include <graphics/Painter.h>
+#include <map>
 
 namespace ilixi
 {
@@ -87,13 +88,17 @@ public:
      * Locks current widget's surface for drawing operations and blocks
      * consecutive calls to begin() until end() is called. You should
      * call this method in order to serialise access to the widget's surface.
+     *
+     * Widgets which share a window surface also share its cairo context. Painter
+     * translates context to widget's position and clips to event rectangle, so all
+     * coordinates are relative to widget.
      */
     void
     begin(const PaintEvent& event);
 
     /*!
-     * Unlocks current widget's surface. This method is automatically
-     * called upon destruction of the painter.
+     * Restores context, flushes drawing inside event rectangle and unlocks current
+     * widget's surface. This method is automatically called upon destruction of the painter.
      */
     void
     end();
@@ -404,6 +409,38 @@ public:
     void
     setAntiAliasMode(AntiAliasMode mode);
 
+    /*!
+     * Stores current path with given name and clears it.
+     *
+     * Path should be relative to (0, 0), so that it can be drawn at any position using drawCachedPath().
+     * Cached paths are shared by all painters until releasePathCache() is called.
+     *
+     * \code
+     * if (!painter.drawCachedPath("gauge.bezel", x, y, CairoPainter::FillPath))
+     * {
+     *     painter.drawEllipse(0, 0, 100, 100, CairoPainter::AddPath);
+     *     painter.cachePath("gauge.bezel");
+     *     painter.drawCachedPath("gauge.bezel", x, y, CairoPainter::FillPath);
+     * }
+     * \endcode
+     */
+    void
+    cachePath(const std::string& name);
+
+    /*!
+     * Draws a path stored using cachePath() at given position.
+     *
+     * Returns false if there is no such path.
+     */
+    bool
+    drawCachedPath(const std::string& name, double x, double y, DrawingMode mode = StrokePath);
+
+    /*!
+     * Releases all cached paths.
+     */
+    static void
+    releasePathCache();
+
 private:
     //! This property holds Painter's current widget.
     Widget* _myWidget;
@@ -449,6 +486,43 @@ private:
     //! Transform coordinates so that cairo's stroke operation fills only opaque pixels.
     void
     getUserCoordinates(double &x, double &y, double &width, double &height);
+
+    //! This struct specifies a rounded rectangle at (0, 0).
+    struct RoundRectangleKey
+    {
+        double width;
+        double height;
+        int radius;
+        Corners corners;
+
+        bool
+        operator<(const RoundRectangleKey& other) const;
+    };
+
+    struct CachedPath
+    {
+        cairo_path_t* path;
+        //! Path tick when path was last drawn.
+        unsigned int used;
+    };
+
+    typedef std::map<std::string, cairo_path_t*> NamedPathMap;
+    typedef std::map<RoundRectangleKey, CachedPath> RoundRectanglePathMap;
+
+    //! This property stores paths added using cachePath().
+    static NamedPathMap __namedPaths;
+    //! This property stores recently drawn rounded rectangles.
+    static RoundRectanglePathMap __roundRectangles;
+    //! This property is incremented each time a cached rounded rectangle is drawn.
+    static unsigned int __pathTick;
+    //! This context is used for building cached paths outside painter's context.
+    static cairo_t* __pathContext;
+
+    /*!
+     * Returns path of a rounded rectangle, building it if necessary.
+     */
+    static cairo_path_t*
+    roundRectanglePath(const RoundRectangleKey& key);
 };
 
 } /* namespace ilixi */
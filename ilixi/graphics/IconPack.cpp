@@ -112,6 +112,7 @@ IconPack::parseIcons(const char* iconsFile)
         }
 
         _iconPack = new Image(file);
+        _iconPack->setShared(true);
         _iconSize = atoi((char*) imgDefSize);
         xmlFree(imgDefSize);
         xmlFree(imgFile);
@@ -164,6 +165,7 @@ operator>>(std::istream& is, IconPack& obj)
     std::string iconName;
     Point p;
     obj._iconPack = new Image();
+    obj._iconPack->setShared(true);
 
     is >> obj._iconSize;
     is.ignore(1);
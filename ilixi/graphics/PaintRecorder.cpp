@@ -0,0 +1,468 @@
+/*
+ Copyright 2010-2015 Tarik Sekmen.
+
+ All Rights Reserved.
+
+ Written by Tarik Sekmen <tarik@ilixi.org>.
+
+ This file is part of ilixi.
+
+ ilixi is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ ilixi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphics/PaintRecorder.h>
+#include <graphics/SurfaceState.h>
+#include <core/Logger.h>
+#include <ilixiConfig.h>
+#include <string.h>
+
+namespace ilixi
+{
+
+D_DEBUG_DOMAIN( ILX_PAINTRECORDER, "ilixi/graphics/PaintRecorder", "PaintRecorder");
+
+//! Number of earlier batches a new command may be merged into.
+static const unsigned int __lookBack = 8;
+
+static inline bool
+intersects(const DFBRegion& a, const DFBRegion& b)
+{
+    return a.x1 <= b.x2 && b.x1 <= a.x2 && a.y1 <= b.y2 && b.y1 <= a.y2;
+}
+
+static inline void
+unite(DFBRegion& a, const DFBRegion& b)
+{
+    if (b.x1 < a.x1)
+        a.x1 = b.x1;
+    if (b.y1 < a.y1)
+        a.y1 = b.y1;
+    if (b.x2 > a.x2)
+        a.x2 = b.x2;
+    if (b.y2 > a.y2)
+        a.y2 = b.y2;
+}
+
+/*!
+ * Clips dest to given region and moves source by the same amount.
+ * Returns false if nothing remains.
+ */
+static inline bool
+clipRect(DFBRectangle& dest, DFBRectangle* source, const DFBRegion& clip)
+{
+    int x1 = dest.x > clip.x1 ? dest.x : clip.x1;
+    int y1 = dest.y > clip.y1 ? dest.y : clip.y1;
+    int x2 = dest.x + dest.w - 1 < clip.x2 ? dest.x + dest.w - 1 : clip.x2;
+    int y2 = dest.y + dest.h - 1 < clip.y2 ? dest.y + dest.h - 1 : clip.y2;
+    if (x2 < x1 || y2 < y1)
+        return false;
+
+    if (source)
+    {
+        source->x += x1 - dest.x;
+        source->y += y1 - dest.y;
+        source->w = x2 - x1 + 1;
+        source->h = y2 - y1 + 1;
+    }
+    dest.x = x1;
+    dest.y = y1;
+    dest.w = x2 - x1 + 1;
+    dest.h = y2 - y1 + 1;
+    return true;
+}
+
+bool
+PaintRecorder::CommandState::operator==(const CommandState& other) const
+{
+    if (type != other.type || source != other.source || font != other.font || flags != other.flags || rule != other.rule)
+        return false;
+    if (color.a != other.color.a || color.r != other.color.r || color.g != other.color.g || color.b != other.color.b)
+        return false;
+    if (clipped != other.clipped)
+        return false;
+    if (clipped)
+        return clip.x1 == other.clip.x1 && clip.y1 == other.clip.y1 && clip.x2 == other.clip.x2 && clip.y2 == other.clip.y2;
+    return true;
+}
+
+PaintRecorder::PaintRecorder()
+        : _surface(NULL),
+          _state(NULL),
+          _active(false),
+          _numCommands(0),
+          _numSubmissions(0)
+{
+    ILOG_TRACE(ILX_PAINTRECORDER);
+}
+
+PaintRecorder::~PaintRecorder()
+{
+    ILOG_TRACE(ILX_PAINTRECORDER);
+    _commands.clear();
+    _batches.clear();
+    releaseReferences();
+}
+
+void
+PaintRecorder::begin(IDirectFBSurface* surface, SurfaceState* state)
+{
+    ILOG_TRACE(ILX_PAINTRECORDER);
+    if (_active)
+        end();
+    _surface = surface;
+    _state = state;
+    _active = (_surface != NULL && _state != NULL);
+}
+
+void
+PaintRecorder::end()
+{
+    ILOG_TRACE(ILX_PAINTRECORDER);
+    if (_active)
+    {
+        flush();
+        _active = false;
+        _surface = NULL;
+        _state = NULL;
+        ILOG_DEBUG(ILX_PAINTRECORDER, " -> commands: %u submissions: %u\n", _numCommands, _numSubmissions);
+    }
+}
+
+void
+PaintRecorder::flush()
+{
+    if (_active && !_commands.empty())
+    {
+        ILOG_TRACE(ILX_PAINTRECORDER);
+        replay();
+        _commands.clear();
+        _batches.clear();
+        _text.clear();
+        releaseReferences();
+    }
+}
+
+bool
+PaintRecorder::active() const
+{
+    return _active;
+}
+
+void
+PaintRecorder::blit(IDirectFBSurface* source, const DFBRectangle* sourceRect, int x, int y, DFBSurfaceBlittingFlags flags, DFBSurfacePorterDuffRule rule, const DFBColor& color, const DFBRegion& clip)
+{
+    if (!_active || !source)
+        return;
+
+    Command cmd;
+    if (sourceRect)
+        cmd.source = *sourceRect;
+    else
+    {
+        cmd.source.x = 0;
+        cmd.source.y = 0;
+        source->GetSize(source, &cmd.source.w, &cmd.source.h);
+    }
+    cmd.dest.x = x;
+    cmd.dest.y = y;
+    cmd.dest.w = cmd.source.w;
+    cmd.dest.h = cmd.source.h;
+    if (!clipRect(cmd.dest, &cmd.source, clip))
+        return;
+
+    cmd.state.type = CmdBlit;
+    cmd.state.source = source;
+    cmd.state.font = NULL;
+    cmd.state.flags = flags;
+    cmd.state.rule = rule;
+    cmd.state.color = color;
+    cmd.state.clipped = false;
+    reference(source);
+
+    DFBRegion bounds = { cmd.dest.x, cmd.dest.y, cmd.dest.x + cmd.dest.w - 1, cmd.dest.y + cmd.dest.h - 1 };
+    record(cmd, bounds);
+}
+
+void
+PaintRecorder::stretchBlit(IDirectFBSurface* source, const DFBRectangle* sourceRect, const DFBRectangle& destRect, DFBSurfaceBlittingFlags flags, DFBSurfacePorterDuffRule rule, const DFBColor& color, const DFBRegion& clip)
+{
+    if (!_active || !source)
+        return;
+
+    Command cmd;
+    if (sourceRect)
+        cmd.source = *sourceRect;
+    else
+    {
+        cmd.source.x = 0;
+        cmd.source.y = 0;
+        source->GetSize(source, &cmd.source.w, &cmd.source.h);
+    }
+    cmd.dest = destRect;
+
+    // Scaled blits can not be clipped exactly in software, so keep the clip unless it is not needed.
+    DFBRectangle visible = destRect;
+    if (!clipRect(visible, NULL, clip))
+        return;
+
+    cmd.state.type = CmdStretchBlit;
+    cmd.state.source = source;
+    cmd.state.font = NULL;
+    cmd.state.flags = flags;
+    cmd.state.rule = rule;
+    cmd.state.color = color;
+    cmd.state.clipped = (visible.w != destRect.w || visible.h != destRect.h);
+    if (cmd.state.clipped)
+        cmd.state.clip = clip;
+    reference(source);
+
+    DFBRegion bounds = { visible.x, visible.y, visible.x + visible.w - 1, visible.y + visible.h - 1 };
+    record(cmd, bounds);
+}
+
+void
+PaintRecorder::fillRectangle(const DFBRectangle& rect, DFBSurfaceDrawingFlags flags, DFBSurfacePorterDuffRule rule, const DFBColor& color, const DFBRegion& clip)
+{
+    if (!_active)
+        return;
+
+    Command cmd;
+    cmd.dest = rect;
+    if (!clipRect(cmd.dest, NULL, clip))
+        return;
+
+    cmd.state.type = CmdFill;
+    cmd.state.source = NULL;
+    cmd.state.font = NULL;
+    cmd.state.flags = flags;
+    cmd.state.rule = rule;
+    cmd.state.color = color;
+    cmd.state.clipped = false;
+
+    DFBRegion bounds = { cmd.dest.x, cmd.dest.y, cmd.dest.x + cmd.dest.w - 1, cmd.dest.y + cmd.dest.h - 1 };
+    record(cmd, bounds);
+}
+
+void
+PaintRecorder::drawString(const char* text, int bytes, int x, int y, DFBSurfaceTextFlags textFlags, IDirectFBFont* font, DFBSurfaceDrawingFlags flags, DFBSurfacePorterDuffRule rule, const DFBColor& color, const DFBRegion& clip)
+{
+    if (!_active || !text || !font)
+        return;
+
+    if (bytes < 0)
+        bytes = strlen(text);
+    if (bytes == 0 || clip.x2 < clip.x1 || clip.y2 < clip.y1)
+        return;
+
+    Command cmd;
+    cmd.dest.x = x;
+    cmd.dest.y = y;
+    cmd.text = _text.size();
+    cmd.bytes = bytes;
+    cmd.textFlags = textFlags;
+    _text.insert(_text.end(), text, text + bytes);
+
+    cmd.state.type = CmdText;
+    cmd.state.source = NULL;
+    cmd.state.font = font;
+    cmd.state.flags = flags;
+    cmd.state.rule = rule;
+    cmd.state.color = color;
+    cmd.state.clipped = true;
+    cmd.state.clip = clip;
+    reference(font);
+
+    // Glyph extents are not known here, text may touch anything inside its clip.
+    record(cmd, clip);
+}
+
+unsigned int
+PaintRecorder::commands() const
+{
+    return _numCommands;
+}
+
+unsigned int
+PaintRecorder::submissions() const
+{
+    return _numSubmissions;
+}
+
+void
+PaintRecorder::record(Command& cmd, const DFBRegion& bounds)
+{
+    ++_numCommands;
+
+    // Join the most recent batch with same state, unless a batch recorded after it overlaps this command.
+    unsigned int limit = _batches.size() > __lookBack ? _batches.size() - __lookBack : 0;
+    for (unsigned int i = _batches.size(); i > limit; --i)
+    {
+        Batch& batch = _batches[i - 1];
+        if (batch.state == cmd.state)
+        {
+            unite(batch.bounds, bounds);
+            batch.count++;
+            cmd.batch = i - 1;
+            _commands.push_back(cmd);
+            return;
+        }
+        if (intersects(batch.bounds, bounds))
+            break;
+    }
+
+    Batch batch;
+    batch.state = cmd.state;
+    batch.bounds = bounds;
+    batch.count = 1;
+    batch.first = 0;
+    cmd.batch = _batches.size();
+    _batches.push_back(batch);
+    _commands.push_back(cmd);
+}
+
+void
+PaintRecorder::reference(IDirectFBSurface* source)
+{
+    if (_sources.empty() || _sources.back() != source)
+    {
+        source->AddRef(source);
+        _sources.push_back(source);
+    }
+}
+
+void
+PaintRecorder::reference(IDirectFBFont* font)
+{
+    if (_fonts.empty() || _fonts.back() != font)
+    {
+        font->AddRef(font);
+        _fonts.push_back(font);
+    }
+}
+
+void
+PaintRecorder::replay()
+{
+    ILOG_DEBUG(ILX_PAINTRECORDER, " -> %u commands in %u batches\n", (unsigned int) _commands.size(), (unsigned int) _batches.size());
+
+    // Group command indices by batch while keeping recording order inside each batch.
+    unsigned int offset = 0;
+    for (unsigned int i = 0; i < _batches.size(); ++i)
+    {
+        _batches[i].first = offset;
+        offset += _batches[i].count;
+        _batches[i].count = 0;
+    }
+
+    _order.resize(_commands.size());
+    for (unsigned int i = 0; i < _commands.size(); ++i)
+    {
+        Batch& batch = _batches[_commands[i].batch];
+        _order[batch.first + batch.count++] = i;
+    }
+
+    DFBRegion clip;
+    _surface->GetClip(_surface, &clip);
+    _state->bind(_surface);
+
+    for (unsigned int i = 0; i < _batches.size(); ++i)
+        submit(_batches[i], &_order[_batches[i].first]);
+
+    _state->setClip(&clip);
+}
+
+void
+PaintRecorder::submit(const Batch& batch, unsigned int* indices)
+{
+    const CommandState& state = batch.state;
+    unsigned int num = batch.count;
+
+    _state->setPorterDuff(state.rule);
+    _state->setColor(state.color.r, state.color.g, state.color.b, state.color.a);
+    _state->setClip(state.clipped ? &state.clip : NULL);
+
+    switch (state.type)
+    {
+    case CmdBlit:
+        _rects.resize(num);
+        _points.resize(num);
+        for (unsigned int i = 0; i < num; ++i)
+        {
+            const Command& cmd = _commands[indices[i]];
+            _rects[i] = cmd.source;
+            _points[i].x = cmd.dest.x;
+            _points[i].y = cmd.dest.y;
+        }
+        _state->setBlittingFlags((DFBSurfaceBlittingFlags) state.flags);
+        _state->useSource();
+        _surface->BatchBlit(_surface, state.source, &_rects[0], &_points[0], num);
+        ++_numSubmissions;
+        break;
+
+    case CmdStretchBlit:
+        _rects.resize(num);
+        _rects2.resize(num);
+        for (unsigned int i = 0; i < num; ++i)
+        {
+            const Command& cmd = _commands[indices[i]];
+            _rects[i] = cmd.source;
+            _rects2[i] = cmd.dest;
+        }
+        _state->setBlittingFlags((DFBSurfaceBlittingFlags) state.flags);
+        _state->useSource();
+#if ILIXI_DFB_VERSION >= VERSION_CODE(1,6,0)
+        _surface->BatchStretchBlit(_surface, state.source, &_rects[0], &_rects2[0], num);
+        ++_numSubmissions;
+#else
+        for (unsigned int i = 0; i < num; ++i)
+            _surface->StretchBlit(_surface, state.source, &_rects[i], &_rects2[i]);
+        _numSubmissions += num;
+#endif
+        break;
+
+    case CmdFill:
+        _rects.resize(num);
+        for (unsigned int i = 0; i < num; ++i)
+            _rects[i] = _commands[indices[i]].dest;
+        _state->setDrawingFlags((DFBSurfaceDrawingFlags) state.flags);
+        _surface->FillRectangles(_surface, &_rects[0], num);
+        ++_numSubmissions;
+        break;
+
+    case CmdText:
+        _state->setDrawingFlags((DFBSurfaceDrawingFlags) state.flags);
+        _state->setFont(state.font);
+        for (unsigned int i = 0; i < num; ++i)
+        {
+            const Command& cmd = _commands[indices[i]];
+            _surface->DrawString(_surface, &_text[cmd.text], cmd.bytes, cmd.dest.x, cmd.dest.y, cmd.textFlags);
+        }
+        _numSubmissions += num;
+        break;
+    }
+}
+
+void
+PaintRecorder::releaseReferences()
+{
+    for (unsigned int i = 0; i < _sources.size(); ++i)
+        _sources[i]->Release(_sources[i]);
+    _sources.clear();
+
+    for (unsigned int i = 0; i < _fonts.size(); ++i)
+        _fonts[i]->Release(_fonts[i]);
+    _fonts.clear();
+}
+
+} /* namespace ilixi */
@@ -0,0 +1,217 @@
+/*
+ Copyright 2010-2015 Tarik Sekmen.
+
+ All Rights Reserved.
+
+ Written by Tarik Sekmen <tarik@ilixi.org>.
+
+ This file is part of ilixi.
+
+ ilixi is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ ilixi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ILIXI_PAINTRECORDER_H_
+#define ILIXI_PAINTRECORDER_H_
+
+#include <directfb.h>
+#include <vector>
+
+namespace ilixi
+{
+class SurfaceState;
+
+//! Records drawing commands of a window repaint and submits them in batches.
+/*!
+ * While recording, Painter does not draw blits, fills and text directly but stores them
+ * together with the surface state they require. On flush(), commands are grouped by state
+ * and replayed using BatchBlit(), BatchStretchBlit(), FillRectangles() and DrawString().
+ *
+ * A command may join an earlier group only if it does not overlap any group which was
+ * recorded in between, so the painting order of overlapping widgets is preserved.
+ * Blits and fills are clipped in software so that widgets with different clips can
+ * share a group.
+ *
+ * Any code which draws on a recorded surface without Painter should call
+ * Surface::flushRecording() first.
+ */
+class PaintRecorder
+{
+public:
+    /*!
+     * Constructor.
+     */
+    PaintRecorder();
+
+    /*!
+     * Destructor.
+     */
+    ~PaintRecorder();
+
+    /*!
+     * Starts recording commands for given surface.
+     *
+     * @param state used for setting surface state during replay.
+     */
+    void
+    begin(IDirectFBSurface* surface, SurfaceState* state);
+
+    /*!
+     * Replays recorded commands and stops recording.
+     */
+    void
+    end();
+
+    /*!
+     * Replays recorded commands and continues recording.
+     */
+    void
+    flush();
+
+    /*!
+     * Returns true if recorder is between begin() and end().
+     */
+    bool
+    active() const;
+
+    /*!
+     * Records a blit from source rectangle to (x, y).
+     *
+     * @param sourceRect area of source, if NULL whole source is used.
+     */
+    void
+    blit(IDirectFBSurface* source, const DFBRectangle* sourceRect, int x, int y, DFBSurfaceBlittingFlags flags, DFBSurfacePorterDuffRule rule, const DFBColor& color, const DFBRegion& clip);
+
+    /*!
+     * Records a stretched blit from source rectangle to destination rectangle.
+     *
+     * @param sourceRect area of source, if NULL whole source is used.
+     */
+    void
+    stretchBlit(IDirectFBSurface* source, const DFBRectangle* sourceRect, const DFBRectangle& destRect, DFBSurfaceBlittingFlags flags, DFBSurfacePorterDuffRule rule, const DFBColor& color, const DFBRegion& clip);
+
+    /*!
+     * Records a rectangle fill.
+     */
+    void
+    fillRectangle(const DFBRectangle& rect, DFBSurfaceDrawingFlags flags, DFBSurfacePorterDuffRule rule, const DFBColor& color, const DFBRegion& clip);
+
+    /*!
+     * Records a text run.
+     *
+     * @param bytes length of text, if -1 text is null terminated.
+     */
+    void
+    drawString(const char* text, int bytes, int x, int y, DFBSurfaceTextFlags textFlags, IDirectFBFont* font, DFBSurfaceDrawingFlags flags, DFBSurfacePorterDuffRule rule, const DFBColor& color, const DFBRegion& clip);
+
+    /*!
+     * Returns the number of commands recorded since construction.
+     */
+    unsigned int
+    commands() const;
+
+    /*!
+     * Returns the number of batches submitted to DirectFB since construction.
+     */
+    unsigned int
+    submissions() const;
+
+private:
+    enum CommandType
+    {
+        CmdBlit,
+        CmdStretchBlit,
+        CmdFill,
+        CmdText
+    };
+
+    //! Surface state required by a command.
+    struct CommandState
+    {
+        CommandType type;
+        IDirectFBSurface* source;
+        IDirectFBFont* font;
+        int flags;
+        DFBSurfacePorterDuffRule rule;
+        DFBColor color;
+        bool clipped;
+        DFBRegion clip;
+
+        bool
+        operator==(const CommandState& other) const;
+    };
+
+    struct Command
+    {
+        CommandState state;
+        DFBRectangle source;
+        DFBRectangle dest;
+        unsigned int text;
+        int bytes;
+        DFBSurfaceTextFlags textFlags;
+        unsigned int batch;
+    };
+
+    struct Batch
+    {
+        CommandState state;
+        DFBRegion bounds;
+        unsigned int count;
+        unsigned int first;
+    };
+
+    //! Target surface.
+    IDirectFBSurface* _surface;
+    //! Shadowed state of target surface.
+    SurfaceState* _state;
+    //! True while recording.
+    bool _active;
+
+    std::vector<Command> _commands;
+    std::vector<Batch> _batches;
+    //! Text runs are stored here.
+    std::vector<char> _text;
+    //! Referenced source surfaces and fonts, released after replay.
+    std::vector<IDirectFBSurface*> _sources;
+    std::vector<IDirectFBFont*> _fonts;
+
+    //! Scratch buffers used during replay.
+    std::vector<unsigned int> _order;
+    std::vector<DFBRectangle> _rects;
+    std::vector<DFBRectangle> _rects2;
+    std::vector<DFBPoint> _points;
+
+    unsigned int _numCommands;
+    unsigned int _numSubmissions;
+
+    void
+    record(Command& cmd, const DFBRegion& bounds);
+
+    void
+    reference(IDirectFBSurface* source);
+
+    void
+    reference(IDirectFBFont* font);
+
+    void
+    replay();
+
+    void
+    submit(const Batch& batch, unsigned int* indices);
+
+    void
+    releaseReferences();
+};
+
+} /* namespace ilixi */
+#endif /* ILIXI_PAINTRECORDER_H_ */
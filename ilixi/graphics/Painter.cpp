@@ -22,21 +22,110 @@
  */
 
 #include <graphics/Painter.h>
+#include <graphics/PaintRecorder.h>
 #include <types/TextLayout.h>
 #include <core/Logger.h>
+#include <core/PlatformManager.h>
+#ifdef ILIXI_USE_WSTRING
+#include <lib/utf8.h>
+#endif
 
 namespace ilixi
 {
 
 D_DEBUG_DOMAIN( ILX_PAINTER, "ilixi/graphics/Painter", "Painter");
 
+#ifndef ILX_DOXYGEN_SKIP
+//! Rendered area of a gradient.
+struct GradientCacheItem
+{
+    unsigned int hash;
+    int x;
+    int y;
+    int width;
+    int height;
+    IDirectFBSurface* surface;
+    unsigned int used;
+};
+#endif
+
+//! Maximum number of rendered gradient areas.
+static const int __gradientCacheSize = 8;
+//! Larger areas are rendered each time they are drawn.
+static const int __gradientCacheMaxPixels = 256 * 256;
+static GradientCacheItem __gradientCache[__gradientCacheSize];
+static unsigned int __gradientTick = 0;
+
+/*!
+ * Returns a surface with given area of gradient, sets cached to false if caller should release it.
+ */
+static IDirectFBSurface*
+gradientSurface(const Gradient& gradient, int x, int y, int width, int height, bool* cached)
+{
+    unsigned int hash = gradient.hash();
+    GradientCacheItem* slot = &__gradientCache[0];
+    for (int i = 0; i < __gradientCacheSize; ++i)
+    {
+        GradientCacheItem* item = &__gradientCache[i];
+        if (item->surface && item->hash == hash && item->x == x && item->y == y && item->width == width && item->height == height)
+        {
+            item->used = ++__gradientTick;
+            *cached = true;
+            return item->surface;
+        }
+        if (slot->surface && (!item->surface || item->used < slot->used))
+            slot = item;
+    }
+
+    DFBSurfaceDescription desc;
+    desc.flags = (DFBSurfaceDescriptionFlags) (DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT);
+    desc.width = width;
+    desc.height = height;
+    desc.pixelformat = DSPF_ARGB;
+
+    IDirectFBSurface* surface;
+    IDirectFB* dfb = PlatformManager::instance().getDFB();
+    if (dfb->CreateSurface(dfb, &desc, &surface) != DFB_OK)
+    {
+        ILOG_ERROR(ILX_PAINTER, "Cannot create gradient surface!\n");
+        return NULL;
+    }
+
+    void* data;
+    int pitch;
+    if (surface->Lock(surface, DSLF_WRITE, &data, &pitch) == DFB_OK)
+    {
+        gradient.render((u32*) data, pitch, x, y, width, height);
+        surface->Unlock(surface);
+    }
+    ILOG_DEBUG(ILX_PAINTER, " -> Rendered gradient %x at %d, %d - %dx%d\n", hash, x, y, width, height);
+
+    *cached = width * height <= __gradientCacheMaxPixels;
+    if (*cached)
+    {
+        if (slot->surface)
+            slot->surface->Release(slot->surface);
+        slot->hash = hash;
+        slot->x = x;
+        slot->y = y;
+        slot->width = width;
+        slot->height = height;
+        slot->surface = surface;
+        slot->used = ++__gradientTick;
+    }
+    return surface;
+}
+
 Painter::Painter(Widget* widget)
         : _myWidget(widget),
           dfbSurface(_myWidget->surface()->dfbSurface()),
           _brush(),
           _pen(),
           _font(),
-          _state(PFNone)
+          _state(PFNone),
+          _recorder(NULL),
+          _porterDuff(DSPD_SRC_OVER),
+          _dfbState(NULL)
 {
     _affine = NULL;
     ILOG_TRACE(ILX_PAINTER);
@@ -74,11 +163,21 @@ Painter::begin(const PaintEvent& event)
         _myWidget->surface()->clip(Rectangle(event.rect.x() - _myWidget->absX(), event.rect.y() - _myWidget->absY(), event.rect.width(), event.rect.height()));
 #endif
     _state = PFActive;
-    dfbSurface->SetDrawingFlags(dfbSurface, DSDRAW_NOFX);
     if (_myWidget->surface()->flags() & Surface::SharedSurface)
-        dfbSurface->SetPorterDuff(dfbSurface, DSPD_NONE);
+        _porterDuff = DSPD_NONE;
     else
-        dfbSurface->SetPorterDuff(dfbSurface, DSPD_SRC_OVER);
+        _porterDuff = DSPD_SRC_OVER;
+
+    _recorder = _myWidget->surface()->recorder();
+    if (_recorder && !_recorder->active())
+        _recorder = NULL;
+    if (!_recorder)
+        _myWidget->surface()->flushRecording();
+
+    _dfbState = _myWidget->surface()->dfbState();
+    _dfbState->bind(dfbSurface);
+    _dfbState->setDrawingFlags(DSDRAW_NOFX);
+    _dfbState->setPorterDuff(_porterDuff);
 }
 
 void
@@ -97,7 +196,8 @@ Painter::end()
             delete _affine;
         }
         _state = PFNone;
-        dfbSurface->ReleaseSource(dfbSurface);
+        _recorder = NULL;
+        _dfbState->releaseSource();
         _myWidget->surface()->unlock();
     }
 }
@@ -125,8 +225,9 @@ Painter::drawLine(double x1, double y1, double x2, double y2, const DFBSurfaceDr
 {
     if (_state & PFActive)
     {
+        flushRecorder();
         applyPen();
-        dfbSurface->SetDrawingFlags(dfbSurface, flags);
+        _dfbState->setDrawingFlags(flags);
         if (_myWidget->surface()->flags() & Surface::SharedSurface)
 #ifdef ILIXI_STEREO_OUTPUT
         {
@@ -160,8 +261,9 @@ Painter::drawRectangle(double x, double y, double width, double height, const DF
 {
     if (_state & PFActive)
     {
+        flushRecorder();
         applyPen();
-        dfbSurface->SetDrawingFlags(dfbSurface, flags);
+        _dfbState->setDrawingFlags(flags);
         if (_myWidget->surface()->flags() & Surface::SharedSurface)
 #ifdef ILIXI_STEREO_OUTPUT
         {
@@ -190,8 +292,19 @@ Painter::fillRectangle(double x, double y, double width, double height, const DF
     ILOG_TRACE(ILX_PAINTER);
     if (_state & PFActive)
     {
+        if (_brush._mode == Brush::GradientMode && _brush._gradient.type() != Gradient::None)
+        {
+            flushRecorder();
+            fillGradient(x, y, width, height, flags);
+            return;
+        }
+        if (_recorder)
+        {
+            recordFill(x, y, width, height, flags);
+            return;
+        }
         applyBrush();
-        dfbSurface->SetDrawingFlags(dfbSurface, flags);
+        _dfbState->setDrawingFlags(flags);
         if (_myWidget->surface()->flags() & Surface::SharedSurface)
 #ifdef ILIXI_STEREO_OUTPUT
         {
@@ -211,7 +324,7 @@ Painter::fillRectangle(double x, double y, double width, double height, const DF
 void
 Painter::fillRectangle(const Rectangle& rect, const DFBSurfaceDrawingFlags& flags)
 {
-    fillRectangle(rect.x(), rect.y(), rect.width(), rect.height());
+    fillRectangle(rect.x(), rect.y(), rect.width(), rect.height(), flags);
 }
 
 void
@@ -220,8 +333,9 @@ Painter::fillTriangle(int x1, int y1, int x2, int y2, int x3, int y3, const DFBS
     ILOG_TRACE(ILX_PAINTER);
     if (_state & PFActive)
     {
+        flushRecorder();
         applyBrush();
-        dfbSurface->SetDrawingFlags(dfbSurface, flags);
+        _dfbState->setDrawingFlags(flags);
         if (_myWidget->surface()->flags() & Surface::SharedSurface)
 #ifdef ILIXI_STEREO_OUTPUT
         {
@@ -252,9 +366,14 @@ Painter::drawText(const std::string& text, int x, int y, const DFBSurfaceDrawing
 
     if (_state & PFActive)
     {
+        if (_recorder)
+        {
+            recordText(text, x, y, flags);
+            return;
+        }
         applyBrush();
         applyFont();
-        dfbSurface->SetDrawingFlags(dfbSurface, flags);
+        _dfbState->setDrawingFlags(flags);
         if (_myWidget->surface()->flags() & Surface::SharedSurface)
 #ifdef ILIXI_STEREO_OUTPUT
         {
@@ -280,9 +399,17 @@ Painter::drawLayout(const TextLayout& layout, const DFBSurfaceDrawingFlags& flag
 
     if (_state & PFActive)
     {
+        if (_recorder)
+        {
+            if (_myWidget->surface()->flags() & Surface::SharedSurface)
+                recordLayout(layout, _myWidget->absX(), _myWidget->absY(), flags);
+            else
+                recordLayout(layout, 0, 0, flags);
+            return;
+        }
         applyBrush();
         applyFont();
-        dfbSurface->SetDrawingFlags(dfbSurface, flags);
+        _dfbState->setDrawingFlags(flags);
         if (_myWidget->surface()->flags() & Surface::SharedSurface)
 #ifdef ILIXI_STEREO_OUTPUT
         {
@@ -307,9 +434,17 @@ Painter::drawLayout(const TextLayout& layout, int x, int y, const DFBSurfaceDraw
 
     if (_state & PFActive)
     {
+        if (_recorder)
+        {
+            if (_myWidget->surface()->flags() & Surface::SharedSurface)
+                recordLayout(layout, _myWidget->surface()->xOffset() + x, _myWidget->surface()->yOffset() + y, flags);
+            else
+                recordLayout(layout, x, y, flags);
+            return;
+        }
         applyBrush();
         applyFont();
-        dfbSurface->SetDrawingFlags(dfbSurface, flags);
+        _dfbState->setDrawingFlags(flags);
         if (_myWidget->surface()->flags() & Surface::SharedSurface)
 #ifdef ILIXI_STEREO_OUTPUT
         {
@@ -337,8 +472,13 @@ Painter::stretchImage(Image* image, const Rectangle& destRect, const DFBSurfaceB
 {
     if ((_state & PFActive) && image)
     {
-        applyBrush();
         DFBRectangle dest = destRect.dfbRect();
+        if (_recorder)
+        {
+            recordStretchBlit(image, NULL, dest, flags);
+            return;
+        }
+        applyBrush();
         if (_myWidget->surface()->flags() & Surface::SharedSurface)
         {
 #ifdef ILIXI_STEREO_OUTPUT
@@ -351,10 +491,7 @@ Painter::stretchImage(Image* image, const Rectangle& destRect, const DFBSurfaceB
 #endif
             dest.y += _myWidget->absY();
         }
-        if (!(image->getCaps() & DICAPS_ALPHACHANNEL))
-            dfbSurface->SetBlittingFlags(dfbSurface, (DFBSurfaceBlittingFlags) (flags & ~DSBLIT_BLEND_ALPHACHANNEL));
-        else
-            dfbSurface->SetBlittingFlags(dfbSurface, flags);
+        applyBlittingFlags(image, flags);
         dfbSurface->StretchBlit(dfbSurface, image->getDFBSurface(), NULL, &dest);
     }
 }
@@ -364,9 +501,14 @@ Painter::stretchImage(Image* image, const Rectangle& destRect, const Rectangle&
 {
     if ((_state & PFActive) && image)
     {
-        applyBrush();
         DFBRectangle source = sourceRect.dfbRect();
         DFBRectangle dest = destRect.dfbRect();
+        if (_recorder)
+        {
+            recordStretchBlit(image, &source, dest, flags);
+            return;
+        }
+        applyBrush();
         if (_myWidget->surface()->flags() & Surface::SharedSurface)
         {
 #ifdef ILIXI_STEREO_OUTPUT
@@ -379,10 +521,7 @@ Painter::stretchImage(Image* image, const Rectangle& destRect, const Rectangle&
 #endif
             dest.y += _myWidget->absY();
         }
-        if (!(image->getCaps() & DICAPS_ALPHACHANNEL))
-            dfbSurface->SetBlittingFlags(dfbSurface, (DFBSurfaceBlittingFlags) (flags & ~DSBLIT_BLEND_ALPHACHANNEL));
-        else
-            dfbSurface->SetBlittingFlags(dfbSurface, flags);
+        applyBlittingFlags(image, flags);
         dfbSurface->StretchBlit(dfbSurface, image->getDFBSurface(), &source, &dest);
     }
 }
@@ -392,11 +531,13 @@ Painter::drawImage(Image* image, int x, int y, const DFBSurfaceBlittingFlags& fl
 {
     if ((_state & PFActive) && image)
     {
+        if (_recorder)
+        {
+            recordBlit(image, NULL, x, y, flags);
+            return;
+        }
         applyBrush();
-        if (!(image->getCaps() & DICAPS_ALPHACHANNEL))
-            dfbSurface->SetBlittingFlags(dfbSurface, (DFBSurfaceBlittingFlags) (flags & ~DSBLIT_BLEND_ALPHACHANNEL));
-        else
-            dfbSurface->SetBlittingFlags(dfbSurface, flags);
+        applyBlittingFlags(image, flags);
         if (_myWidget->surface()->flags() & Surface::SharedSurface)
 #ifdef ILIXI_STEREO_OUTPUT
         {
@@ -424,11 +565,9 @@ Painter::tileImage(Image* image, int x, int y, const DFBSurfaceBlittingFlags& fl
 {
     if ((_state & PFActive) && image)
     {
+        flushRecorder();
         applyBrush();
-        if (!(image->getCaps() & DICAPS_ALPHACHANNEL))
-            dfbSurface->SetBlittingFlags(dfbSurface, (DFBSurfaceBlittingFlags) (flags & ~DSBLIT_BLEND_ALPHACHANNEL));
-        else
-            dfbSurface->SetBlittingFlags(dfbSurface, flags);
+        applyBlittingFlags(image, flags);
         if (_myWidget->surface()->flags() & Surface::SharedSurface)
 #ifdef ILIXI_STEREO_OUTPUT
         {
@@ -450,11 +589,9 @@ Painter::tileImage(Image* image, int x, int y, const Rectangle& source, const DF
 {
     if ((_state & PFActive) && image)
     {
+        flushRecorder();
         applyBrush();
-        if (!(image->getCaps() & DICAPS_ALPHACHANNEL))
-            dfbSurface->SetBlittingFlags(dfbSurface, (DFBSurfaceBlittingFlags) (flags & ~DSBLIT_BLEND_ALPHACHANNEL));
-        else
-            dfbSurface->SetBlittingFlags(dfbSurface, flags);
+        applyBlittingFlags(image, flags);
         DFBRectangle r = source.dfbRect();
         if (_myWidget->surface()->flags() & Surface::SharedSurface)
 #ifdef ILIXI_STEREO_OUTPUT
@@ -478,12 +615,14 @@ Painter::blitImage(Image* image, const Rectangle& source, int x, int y, const DF
     ILOG_TRACE(ILX_PAINTER);
     if ((_state & PFActive) && image)
     {
-        applyBrush();
-        if (!(image->getCaps() & DICAPS_ALPHACHANNEL))
-            dfbSurface->SetBlittingFlags(dfbSurface, (DFBSurfaceBlittingFlags) (flags & ~DSBLIT_BLEND_ALPHACHANNEL));
-        else
-            dfbSurface->SetBlittingFlags(dfbSurface, flags);
         DFBRectangle r = source.dfbRect();
+        if (_recorder)
+        {
+            recordBlit(image, &r, x, y, flags);
+            return;
+        }
+        applyBrush();
+        applyBlittingFlags(image, flags);
         if (_myWidget->surface()->flags() & Surface::SharedSurface)
 #ifdef ILIXI_STEREO_OUTPUT
         {
@@ -505,11 +644,14 @@ Painter::batchBlitImage(Image* image, const DFBRectangle* sourceRects, const DFB
 {
     if ((_state & PFActive) && image)
     {
+        if (_recorder)
+        {
+            for (int i = 0; i < num; ++i)
+                recordBlit(image, &sourceRects[i], points[i].x, points[i].y, flags);
+            return;
+        }
         applyBrush();
-        if (!(image->getCaps() & DICAPS_ALPHACHANNEL))
-            dfbSurface->SetBlittingFlags(dfbSurface, (DFBSurfaceBlittingFlags) (flags & ~DSBLIT_BLEND_ALPHACHANNEL));
-        else
-            dfbSurface->SetBlittingFlags(dfbSurface, flags);
+        applyBlittingFlags(image, flags);
         if (_myWidget->surface()->flags() & Surface::SharedSurface)
         {
             DFBPoint dfbP[num];
@@ -537,11 +679,17 @@ Painter::batchBlitImage(Image* image, const Rectangle* sourceRects, const Point*
 {
     if ((_state & PFActive) && image)
     {
+        if (_recorder)
+        {
+            for (int i = 0; i < num; ++i)
+            {
+                DFBRectangle r = sourceRects[i].dfbRect();
+                recordBlit(image, &r, points[i].x(), points[i].y(), flags);
+            }
+            return;
+        }
         applyBrush();
-        if (!(image->getCaps() & DICAPS_ALPHACHANNEL))
-            dfbSurface->SetBlittingFlags(dfbSurface, (DFBSurfaceBlittingFlags) (flags & ~DSBLIT_BLEND_ALPHACHANNEL));
-        else
-            dfbSurface->SetBlittingFlags(dfbSurface, flags);
+        applyBlittingFlags(image, flags);
         if (_myWidget->surface()->flags() & Surface::SharedSurface)
         {
             DFBRectangle dfbR[num];
@@ -583,11 +731,14 @@ void Painter::batchStretchBlitImage(Image* image, const DFBRectangle* sourceRect
 {
     if ((_state & PFActive) && image)
     {
+        if (_recorder)
+        {
+            for (int i = 0; i < num; ++i)
+                recordStretchBlit(image, &sourceRects[i], destRects[i], flags);
+            return;
+        }
         applyBrush();
-        if (!(image->getCaps() & DICAPS_ALPHACHANNEL))
-        dfbSurface->SetBlittingFlags(dfbSurface, (DFBSurfaceBlittingFlags) (flags & ~DSBLIT_BLEND_ALPHACHANNEL));
-        else
-        dfbSurface->SetBlittingFlags(dfbSurface, flags);
+        applyBlittingFlags(image, flags);
         if (_myWidget->surface()->flags() & Surface::SharedSurface)
         {
             DFBRectangle dfbR[num];
@@ -617,11 +768,17 @@ Painter::batchStretchBlitImage(Image* image, const Rectangle* sourceRects, const
 {
     if ((_state & PFActive) && image)
     {
+        if (_recorder)
+        {
+            for (int i = 0; i < num; ++i)
+            {
+                DFBRectangle r = sourceRects[i].dfbRect();
+                recordStretchBlit(image, &r, destRects[i].dfbRect(), flags);
+            }
+            return;
+        }
         applyBrush();
-        if (!(image->getCaps() & DICAPS_ALPHACHANNEL))
-            dfbSurface->SetBlittingFlags(dfbSurface, (DFBSurfaceBlittingFlags) (flags & ~DSBLIT_BLEND_ALPHACHANNEL));
-        else
-            dfbSurface->SetBlittingFlags(dfbSurface, flags);
+        applyBlittingFlags(image, flags);
         if (_myWidget->surface()->flags() & Surface::SharedSurface)
         {
             DFBRectangle dfbS[num];
@@ -737,6 +894,13 @@ Painter::setAffine2D(const Affine2D& affine2D)
 {
     if (_state & PFActive)
     {
+        // Recorded commands can not be transformed.
+        if (_recorder)
+        {
+            flushRecorder();
+            _recorder = NULL;
+        }
+
         if (!_affine)
             _affine = new Affine2D(affine2D);
         else
@@ -758,34 +922,213 @@ Painter::textExtents(const std::string& text, int bytes)
 }
 
 void
-Painter::applyBrush()
+Painter::releaseGradientCache()
+{
+    for (int i = 0; i < __gradientCacheSize; ++i)
+    {
+        if (__gradientCache[i].surface)
+        {
+            __gradientCache[i].surface->Release(__gradientCache[i].surface);
+            __gradientCache[i].surface = NULL;
+        }
+    }
+}
+
+void
+Painter::fillGradient(int x, int y, int width, int height, const DFBSurfaceDrawingFlags& flags)
 {
-    if (!(_state & PFBrushActive) || _brush._modified)
+    if (width <= 0 || height <= 0)
+        return;
+
+    // Axis aligned gradients are rendered as a single row or column and stretched.
+    const Gradient& gradient = _brush._gradient;
+    int gx = x, gy = y, gw = width, gh = height;
+    bool horizontal;
+    if (gradient.axisAligned(&horizontal))
+    {
+        if (horizontal)
+        {
+            gy = 0;
+            gh = 1;
+        } else
+        {
+            gx = 0;
+            gw = 1;
+        }
+    }
+
+    bool cached;
+    IDirectFBSurface* source = gradientSurface(gradient, gx, gy, gw, gh, &cached);
+    if (!source)
+        return;
+
+    DFBRectangle dest = { x, y, width, height };
+    if (_myWidget->surface()->flags() & Surface::SharedSurface)
     {
-        _brush.applyBrush(dfbSurface);
-        _state = (PainterFlags) (_state | PFBrushActive);
+#ifdef ILIXI_STEREO_OUTPUT
+        if (_myWidget->surface()->stereoEye() == PaintEvent::LeftEye)
+            dest.x += _myWidget->surface()->xOffset() + _myWidget->z();
+        else
+            dest.x += _myWidget->surface()->xOffset() - _myWidget->z();
+#else
+        dest.x += _myWidget->surface()->xOffset();
+#endif
+        dest.y += _myWidget->surface()->yOffset();
     }
+
+    _dfbState->setBlittingFlags((flags & DSDRAW_BLEND) ? DSBLIT_BLEND_ALPHACHANNEL : DSBLIT_NOFX);
+    if (gw == width && gh == height)
+        dfbSurface->Blit(dfbSurface, source, NULL, dest.x, dest.y);
+    else
+        dfbSurface->StretchBlit(dfbSurface, source, NULL, &dest);
+
+    if (!cached)
+        source->Release(source);
+}
+
+void
+Painter::applyBrush()
+{
+    _dfbState->setColor(_brush._color.red(), _brush._color.green(), _brush._color.blue(), _brush._color.alpha());
 }
 
 void
 Painter::applyFont()
 {
+    _dfbState->setFont(currentFont());
+}
+
+void
+Painter::applyPen()
+{
+    _dfbState->setColor(_pen._color.red(), _pen._color.green(), _pen._color.blue(), _pen._color.alpha());
+}
+
+void
+Painter::applyBlittingFlags(Image* image, const DFBSurfaceBlittingFlags& flags)
+{
+    if (!(image->getCaps() & DICAPS_ALPHACHANNEL))
+        _dfbState->setBlittingFlags((DFBSurfaceBlittingFlags) (flags & ~DSBLIT_BLEND_ALPHACHANNEL));
+    else
+        _dfbState->setBlittingFlags(flags);
+    _dfbState->useSource();
+}
+
+void
+Painter::flushRecorder()
+{
+    if (_recorder)
+    {
+        _recorder->flush();
+        _dfbState->setPorterDuff(_porterDuff);
+    }
+}
+
+IDirectFBFont*
+Painter::currentFont()
+{
+    IDirectFBFont* font = NULL;
     if (_state & PFFontModified)
+        font = _font.dfbFont();
+    if (!font)
+        font = _myWidget->stylist()->defaultFont()->dfbFont();
+    return font;
+}
+
+void
+Painter::recordBlit(Image* image, const DFBRectangle* source, int x, int y, const DFBSurfaceBlittingFlags& flags)
+{
+    DFBRegion clip;
+    dfbSurface->GetClip(dfbSurface, &clip);
+    DFBColor color = { _brush._color.alpha(), _brush._color.red(), _brush._color.green(), _brush._color.blue() };
+    DFBSurfaceBlittingFlags blitFlags = flags;
+    if (!(image->getCaps() & DICAPS_ALPHACHANNEL))
+        blitFlags = (DFBSurfaceBlittingFlags) (flags & ~DSBLIT_BLEND_ALPHACHANNEL);
+    if (_myWidget->surface()->flags() & Surface::SharedSurface)
     {
-        if (!_font.applyFont(dfbSurface))
-            _myWidget->stylist()->defaultFont()->applyFont(dfbSurface);
-    } else
-        _myWidget->stylist()->defaultFont()->applyFont(dfbSurface);
+        x += _myWidget->surface()->xOffset();
+        y += _myWidget->surface()->yOffset();
+    }
+    _recorder->blit(image->getDFBSurface(), source, x, y, blitFlags, _porterDuff, color, clip);
 }
 
 void
-Painter::applyPen()
+Painter::recordStretchBlit(Image* image, const DFBRectangle* source, const DFBRectangle& dest, const DFBSurfaceBlittingFlags& flags)
+{
+    DFBRegion clip;
+    dfbSurface->GetClip(dfbSurface, &clip);
+    DFBColor color = { _brush._color.alpha(), _brush._color.red(), _brush._color.green(), _brush._color.blue() };
+    DFBSurfaceBlittingFlags blitFlags = flags;
+    if (!(image->getCaps() & DICAPS_ALPHACHANNEL))
+        blitFlags = (DFBSurfaceBlittingFlags) (flags & ~DSBLIT_BLEND_ALPHACHANNEL);
+    DFBRectangle r = dest;
+    if (_myWidget->surface()->flags() & Surface::SharedSurface)
+    {
+        r.x += _myWidget->surface()->xOffset();
+        r.y += _myWidget->surface()->yOffset();
+    }
+    _recorder->stretchBlit(image->getDFBSurface(), source, r, blitFlags, _porterDuff, color, clip);
+}
+
+void
+Painter::recordFill(int x, int y, int width, int height, const DFBSurfaceDrawingFlags& flags)
+{
+    DFBRegion clip;
+    dfbSurface->GetClip(dfbSurface, &clip);
+    DFBColor color = { _brush._color.alpha(), _brush._color.red(), _brush._color.green(), _brush._color.blue() };
+    DFBRectangle r = { x, y, width, height };
+    if (_myWidget->surface()->flags() & Surface::SharedSurface)
+    {
+        r.x += _myWidget->surface()->xOffset();
+        r.y += _myWidget->surface()->yOffset();
+    }
+    _recorder->fillRectangle(r, flags, _porterDuff, color, clip);
+}
+
+void
+Painter::recordText(const std::string& text, int x, int y, const DFBSurfaceDrawingFlags& flags)
 {
-    if ((_state & PFBrushActive) || _pen._modified)
+    DFBRegion clip;
+    dfbSurface->GetClip(dfbSurface, &clip);
+    DFBColor color = { _brush._color.alpha(), _brush._color.red(), _brush._color.green(), _brush._color.blue() };
+    if (_myWidget->surface()->flags() & Surface::SharedSurface)
     {
-        _pen.applyPen(dfbSurface);
-        _state = (PainterFlags) (_state & ~PFBrushActive);
+        x += _myWidget->surface()->xOffset();
+        y += _myWidget->surface()->yOffset();
     }
+    _recorder->drawString(text.c_str(), text.size(), x, y, DSTF_TOPLEFT, currentFont(), flags, _porterDuff, color, clip);
+}
+
+void
+Painter::recordLayout(const TextLayout& layout, int x, int y, const DFBSurfaceDrawingFlags& flags)
+{
+#ifdef ILIXI_USE_WSTRING
+    char* out = (char*) calloc(layout._text.size() * 4 + 1, 1);
+    wchar_to_utf8(layout._text.c_str(), layout._text.size(), out, layout._text.size() * 4 + 1, UTF8_SKIP_BOM);
+    const char* text = out;
+#else
+    const char* text = layout._text.c_str();
+#endif
+    // Same clip as TextLayout::drawTextLayout()
+    DFBRegion clip;
+    dfbSurface->GetClip(dfbSurface, &clip);
+    Rectangle layoutRect = layout._bounds;
+    layoutRect.translate(x, y);
+    DFBRegion clipLayout = Rectangle(clip.x1, clip.y1, clip.x2 - clip.x1 + 1, clip.y2 - clip.y1 + 1).intersected(layoutRect).dfbRegion();
+
+    x += layout._bounds.x();
+    if (layout._alignment == TextLayout::Center)
+        x += layout._bounds.width() / 2;
+    else if (layout._alignment == TextLayout::Right)
+        x += layout._bounds.width();
+
+    DFBColor color = { _brush._color.alpha(), _brush._color.red(), _brush._color.green(), _brush._color.blue() };
+    IDirectFBFont* font = currentFont();
+    for (TextLayout::LineList::const_iterator it = layout._lines.begin(); it != layout._lines.end(); ++it)
+        _recorder->drawString(text + ((TextLayout::LayoutLine) *it).offset, ((TextLayout::LayoutLine) *it).bytes, x, y + ((TextLayout::LayoutLine) *it).y, (DFBSurfaceTextFlags) layout._alignment, font, flags, _porterDuff, color, clipLayout);
+#ifdef ILIXI_USE_WSTRING
+    free(out);
+#endif
 }
 
 } /* namespace ilixi */
@@ -34,6 +34,7 @@
 namespace ilixi
 {
 class TextLayout;
+class PaintRecorder;
 
 //! Draws primitive shapes and renders text using pure DirectFB methods.
 /*!
@@ -51,6 +52,10 @@ class TextLayout;
  *    painter.end();                        // Painter resets clip and unlocks surface.
  * }
  * \endcode
+ *
+ * If window surface is being recorded (see Surface::beginRecording()), blits, fills and text
+ * are stored and submitted in batches at the end of the repaint. Other operations submit
+ * recorded commands first.
  */
 class Painter
 {
@@ -158,6 +163,9 @@ public:
     /*!
      * Fills inside the given rectangle using Brush.
      *
+     * If brush has a gradient, gradient is rendered into a temporary surface and
+     * blitted, a linear gradient along x or y axis is rendered as a single row or column.
+     *
      * @param x
      * @param y
      * @param width
@@ -349,12 +357,17 @@ public:
     Size
     textExtents(const std::string& text, int bytes = -1);
 
+    /*!
+     * Releases surfaces of rendered gradients.
+     */
+    static void
+    releaseGradientCache();
+
 private:
     enum PainterFlags
     {
         PFNone = 0x000, //!< Initial state
         PFActive = 0x001, //!< Painter is activated by begin()
-        PFBrushActive = 0x002,
         PFFontModified = 0x004,
         PFClipped = 0x008,
         PFTransformed = 0x010
@@ -376,6 +389,13 @@ private:
 
     Affine2D* _affine;
 
+    //! Recorder of window surface, if recording is active.
+    PaintRecorder* _recorder;
+    //! Porter/Duff rule set by begin().
+    DFBSurfacePorterDuffRule _porterDuff;
+    //! Shadowed state of dfbSurface, only changes are passed to DirectFB.
+    SurfaceState* _dfbState;
+
     //! Apply brush to context if it is modified.
     void
     applyBrush();
@@ -387,6 +407,42 @@ private:
     //! Apply pen to content if it is modified.
     void
     applyPen();
+
+    //! Fills rectangle using gradient of brush.
+    void
+    fillGradient(int x, int y, int width, int height, const DFBSurfaceDrawingFlags& flags);
+
+    //! Apply blitting flags for image, alpha blending is disabled if image has no alpha channel.
+    void
+    applyBlittingFlags(Image* image, const DFBSurfaceBlittingFlags& flags);
+
+    //! Submits recorded commands before drawing directly and restores painter state.
+    void
+    flushRecorder();
+
+    //! Returns font used for text.
+    IDirectFBFont*
+    currentFont();
+
+    //! Records a blit at (x, y) in widget coordinates.
+    void
+    recordBlit(Image* image, const DFBRectangle* source, int x, int y, const DFBSurfaceBlittingFlags& flags);
+
+    //! Records a stretched blit to dest in widget coordinates.
+    void
+    recordStretchBlit(Image* image, const DFBRectangle* source, const DFBRectangle& dest, const DFBSurfaceBlittingFlags& flags);
+
+    //! Records a rectangle fill in widget coordinates.
+    void
+    recordFill(int x, int y, int width, int height, const DFBSurfaceDrawingFlags& flags);
+
+    //! Records text at (x, y) in widget coordinates.
+    void
+    recordText(const std::string& text, int x, int y, const DFBSurfaceDrawingFlags& flags);
+
+    //! Records lines of layout at (x, y) in surface coordinates.
+    void
+    recordLayout(const TextLayout& layout, int x, int y, const DFBSurfaceDrawingFlags& flags);
 };
 }
 
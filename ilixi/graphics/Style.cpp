@@ -112,6 +112,7 @@ Style::parseStyle(const char* style)
         }
 
         _pack = new Image(file);
+        _pack->setShared(true);
         xmlFree(imgFile);
         parseTheme(group);
 
@@ -682,6 +683,7 @@ operator>>(std::istream& is, Style& obj)
     obj.release();
 
     obj._pack = new Image();
+    obj._pack->setShared(true);
     is >> *obj._pack;
 
     is >> obj.pb.def;
@@ -32,8 +32,63 @@ namespace ilixi
 
 D_DEBUG_DOMAIN(ILX_STYLIST, "ilixi/graphics/Stylist", "Stylist");
 
+//! Maximum number of frames whose geometry is cached.
+static const unsigned int __maxFrames = 256;
+//! Maximum number of rendered frames.
+static const unsigned int __maxFrameImages = 32;
+//! Maximum number of pixels a rendered frame can have.
+static const int __maxFrameImageArea = 32768;
+//! A frame is rendered into an image when it is drawn this many times.
+static const unsigned int __frameImageHits = 2;
+//! FNV-1a offset basis used for hashing style rectangles.
+static const u64 __hashSeed = 14695981039346656037ULL;
+
+static u64
+hashRect(u64 hash, const Rectangle& rect)
+{
+    int values[4] = { rect.x(), rect.y(), rect.width(), rect.height() };
+    for (int i = 0; i < 4; ++i)
+    {
+        hash ^= (u32) values[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static u64
+hashRect(u64 hash, const r9& rect)
+{
+    hash = hashRect(hash, rect.tl);
+    hash = hashRect(hash, rect.tm);
+    hash = hashRect(hash, rect.tr);
+    hash = hashRect(hash, rect.l);
+    hash = hashRect(hash, rect.m);
+    hash = hashRect(hash, rect.r);
+    hash = hashRect(hash, rect.bl);
+    hash = hashRect(hash, rect.bm);
+    return hashRect(hash, rect.br);
+}
+
+static inline void
+setPoint(DFBPoint& point, int x, int y)
+{
+    point.x = x;
+    point.y = y;
+}
+
+static inline void
+setRect(DFBRectangle& rect, int x, int y, int w, int h)
+{
+    rect.x = x;
+    rect.y = y;
+    rect.w = w;
+    rect.h = h;
+}
+
 Stylist::Stylist()
-        : StylistBase()
+        : StylistBase(),
+          _frameTick(0),
+          _frameImages(0)
 {
     ILOG_TRACE(ILX_STYLIST);
 }
@@ -41,6 +96,7 @@ Stylist::Stylist()
 Stylist::~Stylist()
 {
     ILOG_TRACE(ILX_STYLIST);
+    clearFrameCache();
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -724,56 +780,53 @@ Stylist::draw3Frame(Painter* p, int x, int y, int w, int h, const r3& rect, bool
         if (h < rect.r.dfbRect().h)
             return;
         else if (h < rect.l.dfbRect().h + rect.r.dfbRect().h)
-            p->blitImage(_style->_pack, rect.r, x, y + h - rect.r.height());
-        else
         {
-#if ILIXI_DFB_VERSION >= VERSION_CODE(1,6,0)
-            DFBRectangle blitRects[2];
-
-            blitRects[0] = rect.l.dfbRect();
-            blitRects[1] = rect.r.dfbRect();
-
-            DFBPoint blitPoints[2];
-
-            blitPoints[0].x = x;
-            blitPoints[0].y = y;
-
-            blitPoints[1].x = x;
-            blitPoints[1].y = y + h - rect.r.height();
-
-            p->batchBlitImage(_style->_pack, blitRects, blitPoints, 2, flags);
-#else
-
-            p->blitImage(_style->_pack, rect.l, x, y, flags);
-            p->blitImage(_style->_pack, rect.r, x, y + h - rect.r.height(), flags);
-#endif
-            p->stretchImage(_style->_pack, Rectangle(x, y + rect.l.height(), w, h - rect.l.height() - rect.r.height()), rect.m, flags);
+            p->blitImage(_style->_pack, rect.r, x, y + h - rect.r.height());
+            return;
         }
     } else
     {
         if (w < rect.l.dfbRect().w)
             return;
-        if (w <= rect.l.dfbRect().w + rect.r.dfbRect().w)
-            p->blitImage(_style->_pack, rect.l, x, y);
-        else
+        else if (w <= rect.l.dfbRect().w + rect.r.dfbRect().w)
         {
-            DFBRectangle blitRects[2];
+            p->blitImage(_style->_pack, rect.l, x, y);
+            return;
+        }
+    }
 
-            blitRects[0] = rect.l.dfbRect();
-            blitRects[1] = rect.r.dfbRect();
+    FrameKey key;
+    key.rects = hashRect(hashRect(hashRect(__hashSeed, rect.l), rect.m), rect.r);
+    key.kind = Frame3;
+    key.width = w;
+    key.height = h;
+    key.param = vertical;
 
-            DFBPoint blitPoints[2];
+    bool created;
+    FrameCacheItem* item = frameCacheItem(key, &created);
+    if (created)
+    {
+        FrameGeometry& g = item->geometry;
 
-            blitPoints[0].x = x;
-            blitPoints[0].y = y;
+        g.numBlits = 2;
+        g.blitRects[0] = rect.l.dfbRect();
+        g.blitRects[1] = rect.r.dfbRect();
+        setPoint(g.blitPoints[0], 0, 0);
 
-            blitPoints[1].x = x + w - rect.r.width();
-            blitPoints[1].y = y;
+        g.numStretches = 1;
+        g.stretchSource[0] = rect.m.dfbRect();
 
-            p->batchBlitImage(_style->_pack, blitRects, blitPoints, 2, flags);
-            p->stretchImage(_style->_pack, Rectangle(x + rect.l.width(), y, w - rect.l.width() - rect.r.width(), h), rect.m, flags);
+        if (vertical)
+        {
+            setPoint(g.blitPoints[1], 0, h - rect.r.height());
+            setRect(g.stretchDest[0], 0, rect.l.height(), w, h - rect.l.height() - rect.r.height());
+        } else
+        {
+            setPoint(g.blitPoints[1], w - rect.r.width(), 0);
+            setRect(g.stretchDest[0], rect.l.width(), 0, w - rect.l.width() - rect.r.width(), h);
         }
     }
+    drawCachedFrame(p, x, y, key, item, flags);
 }
 
 void
@@ -785,76 +838,47 @@ Stylist::draw9Frame(Painter* p, const Rectangle& region, const r9& rect)
 void
 Stylist::draw9Frame(Painter* p, int x, int y, int w, int h, const r9& rect)
 {
-    int midWidth = w - rect.tl.width() - rect.tr.width();
-    int midHeight = h - rect.bl.height() - rect.tl.height();
-    int by = y + h - rect.bl.height();
-
-    DFBRectangle blitRects[4];
-
-    blitRects[0] = rect.tl.dfbRect();
-    blitRects[1] = rect.tr.dfbRect();
-    blitRects[2] = rect.bl.dfbRect();
-    blitRects[3] = rect.br.dfbRect();
-
-    DFBPoint blitPoints[4];
-
-    blitPoints[0].x = x;
-    blitPoints[0].y = y;
-
-    blitPoints[1].x = x + w - rect.tr.width();
-    blitPoints[1].y = y;
-
-    blitPoints[2].x = x;
-    blitPoints[2].y = by;
-
-    blitPoints[3].x = x + w - rect.br.width();
-    blitPoints[3].y = by;
-
-    p->batchBlitImage(_style->_pack, blitRects, blitPoints, 4);
-
-#if ILIXI_DFB_VERSION >= VERSION_CODE(1,6,0)
-    DFBRectangle stretchDestRects[5];
-
-    stretchDestRects[0].x = x + rect.tl.width();
-    stretchDestRects[0].y = y;
-    stretchDestRects[0].w = midWidth;
-    stretchDestRects[0].h = rect.tm.height();
-
-    stretchDestRects[1].x = x;
-    stretchDestRects[1].y = y + rect.tl.height();
-    stretchDestRects[1].w = rect.tm.height();
-    stretchDestRects[1].h = midHeight;
-
-    stretchDestRects[2].x = x + w - rect.r.width();
-    stretchDestRects[2].y = y + rect.tl.height();
-    stretchDestRects[2].w = rect.r.width();
-    stretchDestRects[2].h = midHeight;
-
-    stretchDestRects[3].x = x + rect.l.width();
-    stretchDestRects[3].y = y + rect.tl.height();
-    stretchDestRects[3].w = midWidth;
-    stretchDestRects[3].h = midHeight;
-
-    stretchDestRects[4].x = x + rect.bl.width();
-    stretchDestRects[4].y = by;
-    stretchDestRects[4].w = midWidth;
-    stretchDestRects[4].h = rect.bm.height();
-
-    DFBRectangle stretchSourceRects[5];
-    stretchSourceRects[0] = rect.tm.dfbRect();
-    stretchSourceRects[1] = rect.l.dfbRect();
-    stretchSourceRects[2] = rect.r.dfbRect();
-    stretchSourceRects[3] = rect.m.dfbRect();
-    stretchSourceRects[4] = rect.bm.dfbRect();
-
-    p->batchStretchBlitImage(_style->_pack, stretchSourceRects, stretchDestRects, 5);
-#else
-    p->stretchImage(_style->_pack, Rectangle(x + rect.tl.width(), y, midWidth, rect.tm.height()), rect.tm);
-    p->stretchImage(_style->_pack, Rectangle(x, y + rect.tl.height(), rect.tm.height(), midHeight), rect.l);
-    p->stretchImage(_style->_pack, Rectangle(x + w - rect.r.width(), y + rect.tl.height(), rect.r.width(), midHeight), rect.r);
-    p->stretchImage(_style->_pack, Rectangle(x + rect.l.width(), y + rect.tl.height(), midWidth, midHeight), rect.m);
-    p->stretchImage(_style->_pack, Rectangle(x + rect.bl.width(), by, midWidth, rect.bm.height()), rect.bm);
-#endif
+    FrameKey key;
+    key.rects = hashRect(__hashSeed, rect);
+    key.kind = Frame9;
+    key.width = w;
+    key.height = h;
+    key.param = 0;
+
+    bool created;
+    FrameCacheItem* item = frameCacheItem(key, &created);
+    if (created)
+    {
+        FrameGeometry& g = item->geometry;
+        int midWidth = w - rect.tl.width() - rect.tr.width();
+        int midHeight = h - rect.bl.height() - rect.tl.height();
+        int by = h - rect.bl.height();
+
+        g.numBlits = 4;
+        g.blitRects[0] = rect.tl.dfbRect();
+        g.blitRects[1] = rect.tr.dfbRect();
+        g.blitRects[2] = rect.bl.dfbRect();
+        g.blitRects[3] = rect.br.dfbRect();
+
+        setPoint(g.blitPoints[0], 0, 0);
+        setPoint(g.blitPoints[1], w - rect.tr.width(), 0);
+        setPoint(g.blitPoints[2], 0, by);
+        setPoint(g.blitPoints[3], w - rect.br.width(), by);
+
+        g.numStretches = 5;
+        g.stretchSource[0] = rect.tm.dfbRect();
+        g.stretchSource[1] = rect.l.dfbRect();
+        g.stretchSource[2] = rect.r.dfbRect();
+        g.stretchSource[3] = rect.m.dfbRect();
+        g.stretchSource[4] = rect.bm.dfbRect();
+
+        setRect(g.stretchDest[0], rect.tl.width(), 0, midWidth, rect.tm.height());
+        setRect(g.stretchDest[1], 0, rect.tl.height(), rect.tm.height(), midHeight);
+        setRect(g.stretchDest[2], w - rect.r.width(), rect.tl.height(), rect.r.width(), midHeight);
+        setRect(g.stretchDest[3], rect.l.width(), rect.tl.height(), midWidth, midHeight);
+        setRect(g.stretchDest[4], rect.bl.width(), by, midWidth, rect.bm.height());
+    }
+    drawCachedFrame(p, x, y, key, item, DSBLIT_BLEND_ALPHACHANNEL);
 }
 
 void
@@ -896,140 +920,133 @@ Stylist::draw9FrameMid(Painter* p, int x, int y, int w, int h, const r9& rect)
 void
 Stylist::draw9CFrame(Painter* p, int x, int y, int w, int h, const r9& rect1, const r9& rect2, Corners corners)
 {
-    int midWidth = w - rect1.tl.width() - rect1.tr.width();
-    int midHeight = h - rect1.bl.height() - rect1.tl.height();
-    int by = y + h - rect1.bl.height();
-
-    DFBRectangle blitRects[4];
-
-    if (corners & TopLeft)
-        blitRects[0] = rect1.tl.dfbRect();
-    else
-        blitRects[0] = rect2.tl.dfbRect();
-
-    if (corners & TopRight)
-        blitRects[1] = rect1.tr.dfbRect();
-    else
-        blitRects[1] = rect2.tr.dfbRect();
-
-    if (corners & BottomLeft)
-        blitRects[2] = rect1.bl.dfbRect();
-    else
-        blitRects[2] = rect2.bl.dfbRect();
-
-    if (corners & BottomRight)
-        blitRects[3] = rect1.br.dfbRect();
-    else
-        blitRects[3] = rect2.br.dfbRect();
-
-    DFBPoint blitPoints[4];
-
-    blitPoints[0].x = x;
-    blitPoints[0].y = y;
-
-    blitPoints[1].x = x + w - rect1.tr.width();
-    blitPoints[1].y = y;
-
-    blitPoints[2].x = x;
-    blitPoints[2].y = by;
-
-    blitPoints[3].x = x + w - rect1.br.width();
-    blitPoints[3].y = by;
-
-    p->batchBlitImage(_style->_pack, blitRects, blitPoints, 4);
-
-#if ILIXI_DFB_VERSION >= VERSION_CODE(1,6,0)
-    DFBRectangle stretchDestRects[5];
-
-    stretchDestRects[0].x = x + rect1.tl.width();
-    stretchDestRects[0].y = y;
-    stretchDestRects[0].w = midWidth;
-    stretchDestRects[0].h = rect1.tm.height();
-
-    stretchDestRects[1].x = x;
-    stretchDestRects[1].y = y + rect1.tl.height();
-    stretchDestRects[1].w = rect1.tm.height();
-    stretchDestRects[1].h = midHeight;
-
-    stretchDestRects[2].x = x + w - rect1.r.width();
-    stretchDestRects[2].y = y + rect1.tl.height();
-    stretchDestRects[2].w = rect1.r.width();
-    stretchDestRects[2].h = midHeight;
-
-    stretchDestRects[3].x = x + rect1.l.width();
-    stretchDestRects[3].y = y + rect1.tl.height();
-    stretchDestRects[3].w = midWidth;
-    stretchDestRects[3].h = midHeight;
-
-    stretchDestRects[4].x = x + rect1.bl.width();
-    stretchDestRects[4].y = by;
-    stretchDestRects[4].w = midWidth;
-    stretchDestRects[4].h = rect1.bm.height();
-
-    DFBRectangle stretchSourceRects[5];
-    stretchSourceRects[0] = rect1.tm.dfbRect();
-    stretchSourceRects[1] = rect1.l.dfbRect();
-    stretchSourceRects[2] = rect1.r.dfbRect();
-    stretchSourceRects[3] = rect1.m.dfbRect();
-    stretchSourceRects[4] = rect1.bm.dfbRect();
-
-    p->batchStretchBlitImage(_style->_pack, stretchSourceRects, stretchDestRects, 5);
-#else
-    p->stretchImage(_style->_pack, Rectangle(x + rect1.tl.width(), y, midWidth, rect1.tm.height()), rect1.tm);
-    p->stretchImage(_style->_pack, Rectangle(x, y + rect1.tl.height(), rect1.tm.height(), midHeight), rect1.l);
-    p->stretchImage(_style->_pack, Rectangle(x + w - rect1.r.width(), y + rect1.tl.height(), rect1.r.width(), midHeight), rect1.r);
-    p->stretchImage(_style->_pack, Rectangle(x + rect1.l.width(), y + rect1.tl.height(), midWidth, midHeight), rect1.m);
-    p->stretchImage(_style->_pack, Rectangle(x + rect1.bl.width(), by, midWidth, rect1.bm.height()), rect1.bm);
-#endif
+    FrameKey key;
+    key.rects = hashRect(hashRect(__hashSeed, rect1), rect2);
+    key.kind = Frame9C;
+    key.width = w;
+    key.height = h;
+    key.param = corners;
+
+    bool created;
+    FrameCacheItem* item = frameCacheItem(key, &created);
+    if (created)
+    {
+        FrameGeometry& g = item->geometry;
+        int midWidth = w - rect1.tl.width() - rect1.tr.width();
+        int midHeight = h - rect1.bl.height() - rect1.tl.height();
+        int by = h - rect1.bl.height();
+
+        g.numBlits = 4;
+        g.blitRects[0] = (corners & TopLeft) ? rect1.tl.dfbRect() : rect2.tl.dfbRect();
+        g.blitRects[1] = (corners & TopRight) ? rect1.tr.dfbRect() : rect2.tr.dfbRect();
+        g.blitRects[2] = (corners & BottomLeft) ? rect1.bl.dfbRect() : rect2.bl.dfbRect();
+        g.blitRects[3] = (corners & BottomRight) ? rect1.br.dfbRect() : rect2.br.dfbRect();
+
+        setPoint(g.blitPoints[0], 0, 0);
+        setPoint(g.blitPoints[1], w - rect1.tr.width(), 0);
+        setPoint(g.blitPoints[2], 0, by);
+        setPoint(g.blitPoints[3], w - rect1.br.width(), by);
+
+        g.numStretches = 5;
+        g.stretchSource[0] = rect1.tm.dfbRect();
+        g.stretchSource[1] = rect1.l.dfbRect();
+        g.stretchSource[2] = rect1.r.dfbRect();
+        g.stretchSource[3] = rect1.m.dfbRect();
+        g.stretchSource[4] = rect1.bm.dfbRect();
+
+        setRect(g.stretchDest[0], rect1.tl.width(), 0, midWidth, rect1.tm.height());
+        setRect(g.stretchDest[1], 0, rect1.tl.height(), rect1.tm.height(), midHeight);
+        setRect(g.stretchDest[2], w - rect1.r.width(), rect1.tl.height(), rect1.r.width(), midHeight);
+        setRect(g.stretchDest[3], rect1.l.width(), rect1.tl.height(), midWidth, midHeight);
+        setRect(g.stretchDest[4], rect1.bl.width(), by, midWidth, rect1.bm.height());
+    }
+    drawCachedFrame(p, x, y, key, item, DSBLIT_BLEND_ALPHACHANNEL);
 }
 
 void
 Stylist::drawTabFrame(Painter* p, int x, int y, int w, int h, const r9& rect, const Style::r1_View_Panel& rect2)
+{
+    int overlap = defaultParameter(StyleHint::PanelInvOverlap);
+
+    FrameKey key;
+    key.rects = hashRect(hashRect(hashRect(__hashSeed, rect), rect2.bl), rect2.br);
+    key.kind = FrameTab;
+    key.width = w;
+    key.height = h;
+    key.param = overlap;
+
+    bool created;
+    FrameCacheItem* item = frameCacheItem(key, &created);
+    if (created)
+    {
+        FrameGeometry& g = item->geometry;
+        int midWidth = w - rect.tl.width() - rect.tr.width();
+        int midHeight = h - rect.tl.height();
+
+        g.numBlits = 4;
+        g.blitRects[0] = rect.tl.dfbRect();
+        g.blitRects[1] = rect.tr.dfbRect();
+        g.blitRects[2] = rect2.br.dfbRect();
+        g.blitRects[3] = rect2.bl.dfbRect();
+
+        setPoint(g.blitPoints[0], rect2.br.width() - overlap, 0);
+        setPoint(g.blitPoints[1], w - rect.tr.width() - rect2.br.width() + overlap, 0);
+        setPoint(g.blitPoints[2], 0, h - rect2.br.height());
+        setPoint(g.blitPoints[3], w - rect2.bl.width(), h - rect2.bl.height());
+
+        g.numStretches = 4;
+        g.stretchSource[0] = rect.tm.dfbRect();
+        g.stretchSource[1] = rect.l.dfbRect();
+        g.stretchSource[2] = rect.r.dfbRect();
+        g.stretchSource[3] = rect.m.dfbRect();
+
+        setRect(g.stretchDest[0], rect.tl.width() + rect2.br.width() - overlap, 0, midWidth - rect2.br.width(), rect.tm.height());
+        setRect(g.stretchDest[1], rect2.br.width() - overlap, rect.tl.height(), rect.tm.height(), midHeight - rect2.br.height());
+        setRect(g.stretchDest[2], w - rect.tr.width() - rect2.br.width() + overlap, rect.tl.height(), rect.tm.height(), midHeight - rect2.br.height());
+        setRect(g.stretchDest[3], rect.l.width(), rect.tl.height(), midWidth, midHeight);
+    }
+    drawCachedFrame(p, x, y, key, item, DSBLIT_BLEND_ALPHACHANNEL);
+}
+
+void
+Stylist::drawTabFramePassive(Painter* p, int x, int y, int w, int h, const r9& rect)
 {
     int midWidth = w - rect.tl.width() - rect.tr.width();
-    int midHeight = h - rect.tl.height();
+    int midHeight = h - rect.tl.height() - defaultParameter(StyleHint::PanelInvOverlap);
     int by = y + h - rect.bl.height();
 
-    DFBRectangle blitRects[4];
+    DFBRectangle blitRects[2];
 
     blitRects[0] = rect.tl.dfbRect();
     blitRects[1] = rect.tr.dfbRect();
-    blitRects[2] = rect2.br.dfbRect();
-    blitRects[3] = rect2.bl.dfbRect();
 
-    DFBPoint blitPoints[4];
+    DFBPoint blitPoints[2];
 
-    blitPoints[0].x = x + rect2.br.width() - defaultParameter(StyleHint::PanelInvOverlap);
+    blitPoints[0].x = x;
     blitPoints[0].y = y;
 
-    blitPoints[1].x = x + w - rect.tr.width() - rect2.br.width() + defaultParameter(StyleHint::PanelInvOverlap);
+    blitPoints[1].x = x + w - rect.tr.width();
     blitPoints[1].y = y;
 
-    blitPoints[2].x = x;
-    blitPoints[2].y = h - rect2.br.height();
-
-    blitPoints[3].x = x + w - rect2.bl.width();
-    blitPoints[3].y = h - rect2.bl.height();
-
-    p->batchBlitImage(_style->_pack, blitRects, blitPoints, 4);
+    p->batchBlitImage(_style->_pack, blitRects, blitPoints, 2);
 
 #if ILIXI_DFB_VERSION >= VERSION_CODE(1,6,0)
     DFBRectangle stretchDestRects[4];
 
-    stretchDestRects[0].x = x + rect.tl.width() + rect2.br.width() - defaultParameter(StyleHint::PanelInvOverlap);
+    stretchDestRects[0].x = x + rect.tl.width();
     stretchDestRects[0].y = y;
-    stretchDestRects[0].w = midWidth - rect2.br.width();
+    stretchDestRects[0].w = midWidth;
     stretchDestRects[0].h = rect.tm.height();
 
-    stretchDestRects[1].x = x + rect2.br.width() - defaultParameter(StyleHint::PanelInvOverlap);
+    stretchDestRects[1].x = x;
     stretchDestRects[1].y = y + rect.tl.height();
     stretchDestRects[1].w = rect.tm.height();
-    stretchDestRects[1].h = midHeight - rect2.br.height();
+    stretchDestRects[1].h = midHeight;
 
-    stretchDestRects[2].x = x + w - rect.tr.width() - rect2.br.width() + defaultParameter(StyleHint::PanelInvOverlap);
+    stretchDestRects[2].x = x + w - rect.tr.width();
     stretchDestRects[2].y = y + rect.tl.height();
     stretchDestRects[2].w = rect.tm.height();
-    stretchDestRects[2].h = midHeight - rect2.br.height();
+    stretchDestRects[2].h = midHeight;
 
     stretchDestRects[3].x = x + rect.l.width();
     stretchDestRects[3].y = y + rect.tl.height();
@@ -1053,64 +1070,160 @@ Stylist::drawTabFrame(Painter* p, int x, int y, int w, int h, const r9& rect, co
 }
 
 void
-Stylist::drawTabFramePassive(Painter* p, int x, int y, int w, int h, const r9& rect)
+Stylist::clearFrameCache()
 {
-    int midWidth = w - rect.tl.width() - rect.tr.width();
-    int midHeight = h - rect.tl.height() - defaultParameter(StyleHint::PanelInvOverlap);
-    int by = y + h - rect.bl.height();
-
-    DFBRectangle blitRects[2];
-
-    blitRects[0] = rect.tl.dfbRect();
-    blitRects[1] = rect.tr.dfbRect();
+    ILOG_TRACE(ILX_STYLIST);
+    for (FrameCache::iterator it = _frameCache.begin(); it != _frameCache.end(); ++it)
+        delete it->second.image;
+    _frameCache.clear();
+    _frameImages = 0;
+}
 
-    DFBPoint blitPoints[2];
+bool
+Stylist::setStyleFromFile(const char* style)
+{
+    clearFrameCache();
+    return StylistBase::setStyleFromFile(style);
+}
 
-    blitPoints[0].x = x;
-    blitPoints[0].y = y;
+bool
+Stylist::FrameKey::operator<(const FrameKey& other) const
+{
+    if (rects != other.rects)
+        return rects < other.rects;
+    if (kind != other.kind)
+        return kind < other.kind;
+    if (width != other.width)
+        return width < other.width;
+    if (height != other.height)
+        return height < other.height;
+    return param < other.param;
+}
 
-    blitPoints[1].x = x + w - rect.tr.width();
-    blitPoints[1].y = y;
+Stylist::FrameCacheItem*
+Stylist::frameCacheItem(const FrameKey& key, bool* created)
+{
+    FrameCache::iterator it = _frameCache.find(key);
+    if (it != _frameCache.end())
+    {
+        *created = false;
+        return &it->second;
+    }
 
-    p->batchBlitImage(_style->_pack, blitRects, blitPoints, 2);
+    if (_frameCache.size() >= __maxFrames)
+    {
+        ILOG_DEBUG(ILX_STYLIST, " -> Frame cache is full, clearing.\n");
+        clearFrameCache();
+    }
 
-#if ILIXI_DFB_VERSION >= VERSION_CODE(1,6,0)
-    DFBRectangle stretchDestRects[4];
+    FrameCacheItem& item = _frameCache[key];
+    item.geometry.numBlits = 0;
+    item.geometry.numStretches = 0;
+    item.hits = 0;
+    item.used = 0;
+    item.image = NULL;
+    *created = true;
+    return &item;
+}
 
-    stretchDestRects[0].x = x + rect.tl.width();
-    stretchDestRects[0].y = y;
-    stretchDestRects[0].w = midWidth;
-    stretchDestRects[0].h = rect.tm.height();
+void
+Stylist::drawCachedFrame(Painter* p, int x, int y, const FrameKey& key, FrameCacheItem* item, const DFBSurfaceBlittingFlags& flags)
+{
+    item->used = ++_frameTick;
+    if (++item->hits == __frameImageHits)
+        renderCachedFrame(key, item);
 
-    stretchDestRects[1].x = x;
-    stretchDestRects[1].y = y + rect.tl.height();
-    stretchDestRects[1].w = rect.tm.height();
-    stretchDestRects[1].h = midHeight;
+    if (item->image)
+    {
+        p->drawImage(item->image, x, y, flags);
+        return;
+    }
 
-    stretchDestRects[2].x = x + w - rect.tr.width();
-    stretchDestRects[2].y = y + rect.tl.height();
-    stretchDestRects[2].w = rect.tm.height();
-    stretchDestRects[2].h = midHeight;
+    const FrameGeometry& g = item->geometry;
 
-    stretchDestRects[3].x = x + rect.l.width();
-    stretchDestRects[3].y = y + rect.tl.height();
-    stretchDestRects[3].w = midWidth;
-    stretchDestRects[3].h = midHeight;
+    DFBPoint blitPoints[4];
+    for (int i = 0; i < g.numBlits; ++i)
+        setPoint(blitPoints[i], x + g.blitPoints[i].x, y + g.blitPoints[i].y);
 
-    DFBRectangle stretchSourceRects[4];
+    if (g.numBlits)
+        p->batchBlitImage(_style->_pack, g.blitRects, blitPoints, g.numBlits, flags);
 
-    stretchSourceRects[0] = rect.tm.dfbRect();
-    stretchSourceRects[1] = rect.l.dfbRect();
-    stretchSourceRects[2] = rect.r.dfbRect();
-    stretchSourceRects[3] = rect.m.dfbRect();
+    DFBRectangle stretchDestRects[5];
+    for (int i = 0; i < g.numStretches; ++i)
+        setRect(stretchDestRects[i], x + g.stretchDest[i].x, y + g.stretchDest[i].y, g.stretchDest[i].w, g.stretchDest[i].h);
 
-    p->batchStretchBlitImage(_style->_pack, stretchSourceRects, stretchDestRects, 4);
+#if ILIXI_DFB_VERSION >= VERSION_CODE(1,6,0)
+    if (g.numStretches)
+        p->batchStretchBlitImage(_style->_pack, g.stretchSource, stretchDestRects, g.numStretches, flags);
 #else
-    p->stretchImage(_style->_pack, Rectangle(x + rect.tl.width(), y, midWidth, rect.tm.height()), rect.tm);
-    p->stretchImage(_style->_pack, Rectangle(x, y + rect.tl.height(), rect.tm.height(), midHeight), rect.l);
-    p->stretchImage(_style->_pack, Rectangle(x + w - rect.tr.width(), y + rect.tl.height(), rect.tm.height(), midHeight), rect.r);
-    p->stretchImage(_style->_pack, Rectangle(x + rect.l.width(), y + rect.tl.height(), midWidth, midHeight), rect.m);
+    for (int i = 0; i < g.numStretches; ++i)
+        p->stretchImage(_style->_pack, Rectangle(stretchDestRects[i].x, stretchDestRects[i].y, stretchDestRects[i].w, stretchDestRects[i].h),
+                        Rectangle(g.stretchSource[i].x, g.stretchSource[i].y, g.stretchSource[i].w, g.stretchSource[i].h), flags);
 #endif
 }
 
+void
+Stylist::renderCachedFrame(const FrameKey& key, FrameCacheItem* item)
+{
+    ILOG_TRACE(ILX_STYLIST);
+    if (key.width <= 0 || key.height <= 0 || key.width * key.height > __maxFrameImageArea)
+        return;
+
+    // Slices are copied without blending, so they must not overlap and must fit inside frame.
+    const FrameGeometry& g = item->geometry;
+    DFBRectangle slices[9];
+    int num = 0;
+    for (int i = 0; i < g.numBlits; ++i)
+        if (g.blitRects[i].w > 0 && g.blitRects[i].h > 0)
+            setRect(slices[num++], g.blitPoints[i].x, g.blitPoints[i].y, g.blitRects[i].w, g.blitRects[i].h);
+    for (int i = 0; i < g.numStretches; ++i)
+        if (g.stretchDest[i].w > 0 && g.stretchDest[i].h > 0)
+            slices[num++] = g.stretchDest[i];
+
+    for (int i = 0; i < num; ++i)
+    {
+        if (slices[i].x < 0 || slices[i].y < 0 || slices[i].x + slices[i].w > key.width || slices[i].y + slices[i].h > key.height)
+            return;
+        for (int j = 0; j < i; ++j)
+            if (slices[i].x < slices[j].x + slices[j].w && slices[j].x < slices[i].x + slices[i].w && slices[i].y < slices[j].y + slices[j].h && slices[j].y < slices[i].y + slices[i].h)
+                return;
+    }
+
+    if (_frameImages >= __maxFrameImages)
+    {
+        FrameCache::iterator lru = _frameCache.end();
+        for (FrameCache::iterator it = _frameCache.begin(); it != _frameCache.end(); ++it)
+            if (it->second.image && (lru == _frameCache.end() || it->second.used < lru->second.used))
+                lru = it;
+        if (lru != _frameCache.end())
+        {
+            delete lru->second.image;
+            lru->second.image = NULL;
+            lru->second.hits = 0;
+            --_frameImages;
+        }
+    }
+
+    Image* image = new Image(_style->_pack, key.width, key.height);
+    if (!image->preferredSize().isValid())
+    {
+        delete image;
+        return;
+    }
+
+    IDirectFBSurface* dst = image->getDFBSurface();
+    IDirectFBSurface* src = _style->_pack->getDFBSurface();
+    dst->SetBlittingFlags(dst, DSBLIT_NOFX);
+    for (int i = 0; i < g.numBlits; ++i)
+        if (g.blitRects[i].w > 0 && g.blitRects[i].h > 0)
+            dst->Blit(dst, src, &g.blitRects[i], g.blitPoints[i].x, g.blitPoints[i].y);
+    for (int i = 0; i < g.numStretches; ++i)
+        if (g.stretchDest[i].w > 0 && g.stretchDest[i].h > 0)
+            dst->StretchBlit(dst, src, &g.stretchSource[i], &g.stretchDest[i]);
+
+    item->image = image;
+    ++_frameImages;
+    ILOG_DEBUG(ILX_STYLIST, " -> Rendered frame %d (%d, %d), %u images.\n", key.kind, key.width, key.height, _frameImages);
+}
+
 } /* namespace ilixi */
@@ -25,6 +25,7 @@
 #define ILIXI_STYLIST_H_
 
 #include <graphics/StylistBase.h>
+#include <map>
 
 namespace ilixi
 {
@@ -204,6 +205,9 @@ public:
     virtual void
     drawHeader(Painter* painter, int x, int y, int w, int h);
 
+    virtual bool
+    setStyleFromFile(const char* style);
+
 protected:
     virtual void
     draw3Frame(Painter* painter, int x, int y, int w, int h, const r3& rect, bool vertical = false, const DFBSurfaceBlittingFlags& flags = DSBLIT_BLEND_ALPHACHANNEL);
@@ -226,6 +230,84 @@ protected:
     void
     drawTabFramePassive(Painter* p, int x, int y, int w, int h, const r9& rect);
 
+    /*!
+     * Releases cached frame geometry and images.
+     *
+     * You should call this method if style images are modified.
+     */
+    void
+    clearFrameCache();
+
+private:
+    enum FrameKind
+    {
+        Frame3,         //!< draw3Frame()
+        Frame9,         //!< draw9Frame()
+        Frame9C,        //!< draw9CFrame()
+        FrameTab        //!< drawTabFrame()
+    };
+
+    //! Blits which compose a frame, relative to frame origin.
+    struct FrameGeometry
+    {
+        int numBlits;
+        DFBRectangle blitRects[4];
+        DFBPoint blitPoints[4];
+        int numStretches;
+        DFBRectangle stretchSource[5];
+        DFBRectangle stretchDest[5];
+    };
+
+    struct FrameKey
+    {
+        //! Hash of style rectangles used by frame.
+        u64 rects;
+        FrameKind kind;
+        int width;
+        int height;
+        //! Orientation, corners or overlap depending on kind.
+        int param;
+
+        bool
+        operator<(const FrameKey& other) const;
+    };
+
+    struct FrameCacheItem
+    {
+        FrameGeometry geometry;
+        //! Number of times frame is drawn.
+        unsigned int hits;
+        //! Frame tick when frame was last drawn.
+        unsigned int used;
+        //! Rendered frame or NULL.
+        Image* image;
+    };
+
+    typedef std::map<FrameKey, FrameCacheItem> FrameCache;
+    //! This property stores computed frames.
+    FrameCache _frameCache;
+    //! This property is incremented each time a cached frame is drawn.
+    unsigned int _frameTick;
+    //! This property stores the number of rendered frames.
+    unsigned int _frameImages;
+
+    /*!
+     * Returns cache item for given key, or a new item if created is set.
+     */
+    FrameCacheItem*
+    frameCacheItem(const FrameKey& key, bool* created);
+
+    /*!
+     * Draws frame at x, y either using its rendered image or slices of style image.
+     */
+    void
+    drawCachedFrame(Painter* p, int x, int y, const FrameKey& key, FrameCacheItem* item, const DFBSurfaceBlittingFlags& flags);
+
+    /*!
+     * Renders frame slices into an image with the size of frame.
+     */
+    void
+    renderCachedFrame(const FrameKey& key, FrameCacheItem* item);
 };
 }
 
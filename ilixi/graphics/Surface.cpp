@@ -22,9 +22,11 @@
  */
 
 #include <graphics/Surface.h>
+#include <graphics/PaintRecorder.h>
 #include <ui/Widget.h>
 #include <core/PlatformManager.h>
 #include <core/Logger.h>
+#include <core/Profiler.h>
 #include <ui/WindowWidget.h>
 
 namespace ilixi
@@ -48,9 +50,10 @@ Surface::Surface(Widget* owner)
           _parentSurface(NULL),
           _flags((SurfaceFlags) DefaultDescription),
           _xOffset(0),
-          _yOffset(0)
+          _yOffset(0),
           _rightSurface(NULL),
-          _eye(PaintEvent::LeftEye)
+          _eye(PaintEvent::LeftEye),
+          _recorder(NULL)
 #ifdef ILIXI_HAVE_CAIRO
           ,_cairoSurface(NULL),
           _cairoContext(NULL)
@@ -67,7 +70,8 @@ Surface::Surface(Widget* owner)
           _parentSurface(NULL),
           _flags((SurfaceFlags) DefaultDescription),
           _xOffset(0),
-          _yOffset(0)
+          _yOffset(0),
+          _recorder(NULL)
 #ifdef ILIXI_HAVE_CAIRO
           ,_cairoSurface(NULL),
           _cairoContext(NULL)
@@ -86,6 +90,7 @@ Surface::~Surface()
 {
     ILOG_TRACE(ILX_SURFACE);
     release();
+    delete _recorder;
     pthread_mutex_destroy(&_surfaceLock);
 }
 
@@ -158,6 +163,14 @@ Surface::dfbSurface()
 #endif
 }
 
+SurfaceState*
+Surface::dfbState()
+{
+    if ((_flags & SharedSurface) && _surfaceOwner && _surfaceOwner->surface() != this)
+        return _surfaceOwner->surface()->dfbState();
+    return &_dfbState;
+}
+
 DFBSurfaceID
 Surface::dfbSurfaceId() const
 {
@@ -216,14 +229,62 @@ Surface::setGeometry(int x, int y, int width, int height)
 void
 Surface::setBlittingFlags(DFBSurfaceBlittingFlags flags)
 {
+    flushRecording();
     if (_dfbSurface)
-        _dfbSurface->SetBlittingFlags(_dfbSurface, flags);
+    {
+        SurfaceState* state = dfbState();
+        state->bind(_dfbSurface);
+        state->setBlittingFlags(flags);
+    }
+}
+
+void
+Surface::beginRecording()
+{
+    ILOG_TRACE(ILX_SURFACE);
+    if ((_flags & RootSurface) && _dfbSurface)
+    {
+        if (!_recorder)
+            _recorder = new PaintRecorder();
+        _recorder->begin(_dfbSurface, &_dfbState);
+    }
+}
+
+void
+Surface::endRecording()
+{
+    ILOG_TRACE(ILX_SURFACE);
+    if (_recorder)
+        _recorder->end();
+}
+
+PaintRecorder*
+Surface::recorder() const
+{
+    if (_flags & RootSurface)
+        return _recorder;
+    if ((_flags & SharedSurface) && _surfaceOwner && _surfaceOwner->surface() != this)
+        return _surfaceOwner->surface()->recorder();
+    return NULL;
+}
+
+void
+Surface::flushRecording()
+{
+    PaintRecorder* rec = recorder();
+    // Sub-surfaces write to pixels of window surface.
+    if (!rec && (_flags & SubSurface) && _owner->_rootWindow)
+        rec = _owner->_rootWindow->surface()->recorder();
+    if (rec)
+        rec->flush();
 }
 
 void
 Surface::flip()
 {
     ILOG_TRACE(ILX_SURFACE);
+    ILIXI_PROFILE("Surface::flip");
+    flushRecording();
     DFBResult ret;
     switch (PlatformManager::instance().getLayerFlipMode(_owner->_rootWindow->layerName()))
     {
@@ -258,6 +319,8 @@ void
 Surface::flip(const Rectangle& rect)
 {
     ILOG_TRACE(ILX_SURFACE);
+    ILIXI_PROFILE("Surface::flip");
+    flushRecording();
     DFBResult ret;
     DFBRegion r = rect.dfbRegion();
     switch (PlatformManager::instance().getLayerFlipMode(_owner->_rootWindow->layerName()))
@@ -276,8 +339,11 @@ Surface::flip(const Rectangle& rect)
         {
             int w, h;
             _dfbSurface->GetSize(_dfbSurface, &w, &h);
-            _dfbSurface->SetClip(_dfbSurface, NULL);
-            _dfbSurface->SetBlittingFlags(_dfbSurface, DSBLIT_NOFX);
+            SurfaceState* state = dfbState();
+            state->bind(_dfbSurface);
+            state->setClip(NULL);
+            state->setBlittingFlags(DSBLIT_NOFX);
+            state->useSource();
 
             if (r.y1)
             {
@@ -357,6 +423,7 @@ void
 Surface::clear()
 {
     ILOG_TRACE(ILX_SURFACE);
+    flushRecording();
     DFBResult ret = _dfbSurface->Clear(_dfbSurface, 0, 0, 0, 0);
     if (ret)
         ILOG_ERROR(ILX_SURFACE, "Clear error: %s\n", DirectFBErrorString(ret));
@@ -368,12 +435,15 @@ void
 Surface::clear(const Rectangle& rect)
 {
     ILOG_TRACE(ILX_SURFACE);
+    flushRecording();
 #ifdef ILIXI_STEREO_OUTPUT
     if (_eye == PaintEvent::LeftEye)
     {
 #endif
-        _dfbSurface->SetDrawingFlags(_dfbSurface, DSDRAW_NOFX);
-        _dfbSurface->SetColor(_dfbSurface, 0, 0, 0, 0);
+        SurfaceState* state = dfbState();
+        state->bind(_dfbSurface);
+        state->setDrawingFlags(DSDRAW_NOFX);
+        state->setColor(0, 0, 0, 0);
         _dfbSurface->FillRectangle(_dfbSurface, rect.x(), rect.y(), rect.width(), rect.height());
         ILOG_DEBUG(ILX_SURFACE, " -> left (%d, %d, %d, %d)\n", rect.x(), rect.y(), rect.width(), rect.height());
 #ifdef ILIXI_STEREO_OUTPUT
@@ -398,7 +468,9 @@ Surface::clip(const Rectangle& rect)
 #endif
         int x, y;
         _dfbSurface->GetPosition(_dfbSurface, &x, &y);
-        _dfbSurface->SetClip(_dfbSurface, &r);
+        SurfaceState* state = dfbState();
+        state->bind(_dfbSurface);
+        state->setClip(&r);
         ILOG_DEBUG(ILX_SURFACE, " -> LEFT at (%d, %d) left Rect(%d, %d, %d, %d)\n", x, y, rect.x(), rect.y(), rect.width(), rect.height());
 #ifdef ILIXI_STEREO_OUTPUT
     } else
@@ -417,10 +489,13 @@ Surface::resetClip()
     ILOG_TRACE(ILX_SURFACE);
 #ifdef ILIXI_STEREO_OUTPUT
     if (_eye == PaintEvent::LeftEye)
+    {
 #endif
-        _dfbSurface->SetClip(_dfbSurface, NULL);
+        SurfaceState* state = dfbState();
+        state->bind(_dfbSurface);
+        state->setClip(NULL);
 #ifdef ILIXI_STEREO_OUTPUT
-    else
+    } else
         _rightSurface->SetClip(_rightSurface, NULL);
 #endif
 }
@@ -428,16 +503,19 @@ Surface::resetClip()
 void
 Surface::blit(IDirectFBSurface* source, const Rectangle& crop, int x, int y)
 {
+    flushRecording();
     if (source && _dfbSurface)
     {
         DFBRectangle r = crop.dfbRect();
         DFBResult ret;
 #ifdef ILIXI_STEREO_OUTPUT
         if (_eye == PaintEvent::LeftEye)
+        {
 #endif
+            dfbState()->useSource();
             ret = _dfbSurface->Blit(_dfbSurface, source, &r, x, y);
 #ifdef ILIXI_STEREO_OUTPUT
-        else
+        } else
             ret = _rightSurface->Blit(_rightSurface, source, &r, x, y);
 #endif
         if (ret)
@@ -450,15 +528,18 @@ Surface::blit(IDirectFBSurface* source, const Rectangle& crop, int x, int y)
 void
 Surface::blit(IDirectFBSurface* source, int x, int y)
 {
+    flushRecording();
     if (source && _dfbSurface)
     {
         DFBResult ret;
 #ifdef ILIXI_STEREO_OUTPUT
         if (_eye == PaintEvent::LeftEye)
+        {
 #endif
+            dfbState()->useSource();
             ret = _dfbSurface->Blit(_dfbSurface, source, NULL, x, y);
 #ifdef ILIXI_STEREO_OUTPUT
-        else
+        } else
             ret = _rightSurface->Blit(_rightSurface, source, NULL, x, y);
 #endif
         if (ret)
@@ -485,14 +566,17 @@ Surface::blit(Surface* source, int x, int y)
 void
 Surface::setOpacity(u8 opacity)
 {
+    flushRecording();
 #ifdef ILIXI_STEREO_OUTPUT
     if (_eye == PaintEvent::LeftEye)
     {
 #endif
         if (_dfbSurface && opacity != 255)
         {
-            _dfbSurface->SetBlittingFlags(_dfbSurface, (DFBSurfaceBlittingFlags) (DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_BLEND_COLORALPHA));
-            _dfbSurface->SetColor(_dfbSurface, 0, 0, 0, opacity);
+            SurfaceState* state = dfbState();
+            state->bind(_dfbSurface);
+            state->setBlittingFlags((DFBSurfaceBlittingFlags) (DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_BLEND_COLORALPHA));
+            state->setColor(0, 0, 0, opacity);
             ILOG_DEBUG(ILX_SURFACE, "[%p] %s %u\n", this, __FUNCTION__, opacity);
         }
 #ifdef ILIXI_STEREO_OUTPUT
@@ -601,6 +685,7 @@ Surface::getStereoSurface(PaintEvent::PaintEventEye eye)
 void
 Surface::flipStereo(const Rectangle& left, const Rectangle& right)
 {
+    ILIXI_PROFILE("Surface::flipStereo");
     DFBRegion l = left.dfbRegion();
     DFBRegion r = right.dfbRegion();
     ILOG_DEBUG(ILX_SURFACE, "[%p] %s Left(%d,%d,%d,%d) Right(%d,%d,%d,%d)\n", this, __FUNCTION__, left.x(), left.y(), left.width(), left.height(), right.x(), right.y(), right.width(), right.height());
@@ -615,7 +700,9 @@ Surface::flipStereo(const Rectangle& left, const Rectangle& right)
 cairo_surface_t*
 Surface::cairoSurface()
 {
-    if (!_cairoSurface)
+    if ((_flags & SharedSurface) && _surfaceOwner && _surfaceOwner->surface() != this)
+        return _surfaceOwner->surface()->cairoSurface();
+    if (!_cairoSurface && _dfbSurface)
         _cairoSurface = cairo_directfb_surface_create(PlatformManager::instance().getDFB(), _dfbSurface);
     return _cairoSurface;
 }
@@ -623,8 +710,13 @@ Surface::cairoSurface()
 cairo_t*
 Surface::cairoContext()
 {
+    // Shared surfaces are bound to context of surface owner, so it survives their geometry changes.
+    if ((_flags & SharedSurface) && _surfaceOwner && _surfaceOwner->surface() != this)
+        return _surfaceOwner->surface()->cairoContext();
     if (!_cairoContext)
     {
+        if (!_dfbSurface)
+            return NULL;
 #ifdef ILIXI_HAVE_CAIROGLES
         if (_surfaceGL)
             _cairoContext = cairo_create(_surfaceGL);
@@ -837,6 +929,9 @@ Surface::release()
 
     if (_dfbSurface)
     {
+        if (_recorder)
+            _recorder->end();
+        _dfbState.bind(NULL);
         _dfbSurface->Release(_dfbSurface);
         _dfbSurface = NULL;
     }
@@ -25,6 +25,7 @@
 #define ILIXI_SURFACE_H_
 
 #include <types/Event.h>
+#include <graphics/SurfaceState.h>
 #include <ilixiConfig.h>
 
 #ifdef ILIXI_HAVE_CAIRO
@@ -34,6 +35,7 @@
 namespace ilixi
 {
 class Widget;
+class PaintRecorder;
 //! Stores surface pixel data.
 class Surface
 {
@@ -93,6 +95,14 @@ public:
     DFBSurfaceID
     dfbSurfaceId() const;
 
+    /*!
+     * Returns the shadowed state of underlying DirectFB surface.
+     *
+     * Widgets with a SharedSurface use the state of their surface owner.
+     */
+    SurfaceState*
+    dfbState();
+
     /*!
      * Returns position of surface on x-axis relative to its root.
      */
@@ -238,6 +248,34 @@ public:
     void
     setBlittingFlags(DFBSurfaceBlittingFlags flags);
 
+    /*!
+     * Starts recording Painter commands on this surface. Only a RootSurface can record.
+     *
+     * @sa PaintRecorder
+     */
+    void
+    beginRecording();
+
+    /*!
+     * Submits recorded commands and stops recording.
+     */
+    void
+    endRecording();
+
+    /*!
+     * Returns the recorder which stores commands drawn on this surface, or NULL.
+     */
+    PaintRecorder*
+    recorder() const;
+
+    /*!
+     * Submits recorded commands which this surface depends on.
+     *
+     * This should be called before drawing on this surface without a Painter.
+     */
+    void
+    flushRecording();
+
 #ifdef ILIXI_STEREO_OUTPUT
     bool
     createDFBSubSurfaceStereo(const Rectangle& geometry, IDirectFBSurface* parent, int zIndex);
@@ -265,7 +303,8 @@ public:
     /*!
      * Returns the cairo-directfb surface.
      *
-     * If cairo-directfb surface does not exist it is created.
+     * If cairo-directfb surface does not exist it is created. Shared surfaces return
+     * cairo surface of their surface owner.
      */
     cairo_surface_t*
     cairoSurface();
@@ -273,7 +312,8 @@ public:
     /*!
      * Returns the context of cairo-directfb surface.
      *
-     * If context does not exist it is created.
+     * If context does not exist it is created. Shared surfaces return context of their
+     * surface owner, which is kept until owner's DirectFB surface is released.
      */
     cairo_t*
     cairoContext();
@@ -365,6 +405,10 @@ private:
 #endif
     //! This mutex is used for serialising writes to surface by Painter.
     pthread_mutex_t _surfaceLock;
+    //! Records commands while window is repainted.
+    PaintRecorder* _recorder;
+    //! Shadowed state of _dfbSurface.
+    SurfaceState _dfbState;
 
 #ifdef ILIXI_HAVE_CAIRO
     //! Interface to cairo surface.
@@ -0,0 +1,236 @@
+/*
+ Copyright 2010-2015 Tarik Sekmen.
+
+ All Rights Reserved.
+
+ Written by Tarik Sekmen <tarik@ilixi.org>.
+
+ This file is part of ilixi.
+
+ ilixi is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ ilixi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphics/SurfaceState.h>
+#include <core/Logger.h>
+
+namespace ilixi
+{
+
+D_DEBUG_DOMAIN( ILX_SURFACESTATE, "ilixi/graphics/SurfaceState", "SurfaceState");
+
+unsigned int SurfaceState::__issued = 0;
+unsigned int SurfaceState::__skipped = 0;
+
+SurfaceState::SurfaceState()
+        : _surface(NULL),
+          _valid(SSNone),
+          _drawingFlags(DSDRAW_NOFX),
+          _blittingFlags(DSBLIT_NOFX),
+          _rule(DSPD_NONE),
+          _font(NULL),
+          _clipped(false)
+{
+    ILOG_TRACE(ILX_SURFACESTATE);
+}
+
+SurfaceState::~SurfaceState()
+{
+    ILOG_TRACE(ILX_SURFACESTATE);
+}
+
+IDirectFBSurface*
+SurfaceState::surface() const
+{
+    return _surface;
+}
+
+void
+SurfaceState::bind(IDirectFBSurface* surface)
+{
+    if (_surface != surface)
+    {
+        _surface = surface;
+        _valid = SSNone;
+    }
+}
+
+void
+SurfaceState::invalidate()
+{
+    // Keep source flag so that a held source is still released.
+    _valid &= SSSource;
+}
+
+void
+SurfaceState::setColor(u8 r, u8 g, u8 b, u8 a)
+{
+    if (!_surface)
+        return;
+
+    if ((_valid & SSColor) && _color.r == r && _color.g == g && _color.b == b && _color.a == a)
+    {
+        ++__skipped;
+        return;
+    }
+
+    _surface->SetColor(_surface, r, g, b, a);
+    _color.r = r;
+    _color.g = g;
+    _color.b = b;
+    _color.a = a;
+    _valid |= SSColor;
+    ++__issued;
+}
+
+void
+SurfaceState::setDrawingFlags(DFBSurfaceDrawingFlags flags)
+{
+    if (!_surface)
+        return;
+
+    if ((_valid & SSDrawingFlags) && _drawingFlags == flags)
+    {
+        ++__skipped;
+        return;
+    }
+
+    _surface->SetDrawingFlags(_surface, flags);
+    _drawingFlags = flags;
+    _valid |= SSDrawingFlags;
+    ++__issued;
+}
+
+void
+SurfaceState::setBlittingFlags(DFBSurfaceBlittingFlags flags)
+{
+    if (!_surface)
+        return;
+
+    if ((_valid & SSBlittingFlags) && _blittingFlags == flags)
+    {
+        ++__skipped;
+        return;
+    }
+
+    _surface->SetBlittingFlags(_surface, flags);
+    _blittingFlags = flags;
+    _valid |= SSBlittingFlags;
+    ++__issued;
+}
+
+void
+SurfaceState::setPorterDuff(DFBSurfacePorterDuffRule rule)
+{
+    if (!_surface)
+        return;
+
+    if ((_valid & SSPorterDuff) && _rule == rule)
+    {
+        ++__skipped;
+        return;
+    }
+
+    _surface->SetPorterDuff(_surface, rule);
+    _rule = rule;
+    _valid |= SSPorterDuff;
+    ++__issued;
+}
+
+void
+SurfaceState::setFont(IDirectFBFont* font)
+{
+    if (!_surface || !font)
+        return;
+
+    if ((_valid & SSFont) && _font == font)
+    {
+        ++__skipped;
+        return;
+    }
+
+    if (_surface->SetFont(_surface, font) != DFB_OK)
+    {
+        ILOG_ERROR(ILX_SURFACESTATE, "Error while setting font!\n");
+        _valid &= ~SSFont;
+        return;
+    }
+    _font = font;
+    _valid |= SSFont;
+    ++__issued;
+}
+
+void
+SurfaceState::setClip(const DFBRegion* clip)
+{
+    if (!_surface)
+        return;
+
+    if (_valid & SSClip)
+    {
+        if (!clip && !_clipped)
+        {
+            ++__skipped;
+            return;
+        }
+        if (clip && _clipped && clip->x1 == _clip.x1 && clip->y1 == _clip.y1 && clip->x2 == _clip.x2 && clip->y2 == _clip.y2)
+        {
+            ++__skipped;
+            return;
+        }
+    }
+
+    _surface->SetClip(_surface, clip);
+    _clipped = (clip != NULL);
+    if (clip)
+        _clip = *clip;
+    _valid |= SSClip;
+    ++__issued;
+}
+
+void
+SurfaceState::useSource()
+{
+    _valid |= SSSource;
+}
+
+void
+SurfaceState::releaseSource()
+{
+    if (!_surface)
+        return;
+
+    if (!(_valid & SSSource))
+    {
+        ++__skipped;
+        return;
+    }
+
+    _surface->ReleaseSource(_surface);
+    _valid &= ~SSSource;
+    ++__issued;
+}
+
+unsigned int
+SurfaceState::issued()
+{
+    return __issued;
+}
+
+unsigned int
+SurfaceState::skipped()
+{
+    return __skipped;
+}
+
+} /* namespace ilixi */
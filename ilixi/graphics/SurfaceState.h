@@ -0,0 +1,160 @@
+/*
+ Copyright 2010-2015 Tarik Sekmen.
+
+ All Rights Reserved.
+
+ Written by Tarik Sekmen <tarik@ilixi.org>.
+
+ This file is part of ilixi.
+
+ ilixi is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ ilixi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ILIXI_SURFACESTATE_H_
+#define ILIXI_SURFACESTATE_H_
+
+#include <directfb.h>
+
+namespace ilixi
+{
+
+//! Shadows the state of a DirectFB surface interface.
+/*!
+ * Each setter compares the requested value with the last value set through this
+ * object and calls DirectFB only if it differs. Code which changes the state of the
+ * interface directly should call invalidate() afterwards.
+ */
+class SurfaceState
+{
+public:
+    /*!
+     * Constructor.
+     */
+    SurfaceState();
+
+    /*!
+     * Destructor.
+     */
+    ~SurfaceState();
+
+    /*!
+     * Returns the interface state is kept for.
+     */
+    IDirectFBSurface*
+    surface() const;
+
+    /*!
+     * Uses given interface. Shadowed state is dropped if interface is changed.
+     */
+    void
+    bind(IDirectFBSurface* surface);
+
+    /*!
+     * Drops shadowed state, next setters will call DirectFB.
+     */
+    void
+    invalidate();
+
+    /*!
+     * Sets color used for drawing, text and colorizing blits.
+     */
+    void
+    setColor(u8 r, u8 g, u8 b, u8 a);
+
+    /*!
+     * Sets drawing flags.
+     */
+    void
+    setDrawingFlags(DFBSurfaceDrawingFlags flags);
+
+    /*!
+     * Sets blitting flags.
+     */
+    void
+    setBlittingFlags(DFBSurfaceBlittingFlags flags);
+
+    /*!
+     * Sets Porter/Duff rule.
+     */
+    void
+    setPorterDuff(DFBSurfacePorterDuffRule rule);
+
+    /*!
+     * Sets font used for text.
+     */
+    void
+    setFont(IDirectFBFont* font);
+
+    /*!
+     * Sets clipping region, NULL disables clipping.
+     */
+    void
+    setClip(const DFBRegion* clip);
+
+    /*!
+     * Marks that a blit referenced a source surface.
+     */
+    void
+    useSource();
+
+    /*!
+     * Releases source surface if a blit referenced one.
+     */
+    void
+    releaseSource();
+
+    /*!
+     * Returns the number of state changes passed to DirectFB.
+     */
+    static unsigned int
+    issued();
+
+    /*!
+     * Returns the number of state changes which were skipped as redundant.
+     */
+    static unsigned int
+    skipped();
+
+private:
+    enum StateFlags
+    {
+        SSNone = 0x000,
+        SSColor = 0x001,
+        SSDrawingFlags = 0x002,
+        SSBlittingFlags = 0x004,
+        SSPorterDuff = 0x008,
+        SSFont = 0x010,
+        SSClip = 0x020,
+        SSSource = 0x040
+    };
+
+    //! Interface state is kept for.
+    IDirectFBSurface* _surface;
+    //! Set if corresponding value is known.
+    int _valid;
+
+    DFBColor _color;
+    DFBSurfaceDrawingFlags _drawingFlags;
+    DFBSurfaceBlittingFlags _blittingFlags;
+    DFBSurfacePorterDuffRule _rule;
+    IDirectFBFont* _font;
+    bool _clipped;
+    DFBRegion _clip;
+
+    static unsigned int __issued;
+    static unsigned int __skipped;
+};
+
+} /* namespace ilixi */
+#endif /* ILIXI_SURFACESTATE_H_ */
@@ -0,0 +1,242 @@
+/*
+ Copyright 2010-2015 Tarik Sekmen.
+
+ All Rights Reserved.
+
+ Written by Tarik Sekmen <tarik@ilixi.org>.
+
+ This file is part of ilixi.
+
+ ilixi is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ ilixi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <lib/DirectoryScanner.h>
+#include <core/Engine.h>
+#include <core/Logger.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <direct/clock.h>
+
+namespace ilixi
+{
+
+D_DEBUG_DOMAIN( ILX_DIRECTORYSCANNER, "ilixi/lib/DirectoryScanner", "DirectoryScanner");
+
+//! Size of first batch, following batches are doubled up to __batchMax.
+static const unsigned int __batchMin = 32;
+static const unsigned int __batchMax = 512;
+//! Pending entries are passed to main thread at least this often (ms).
+static const long long __batchInterval = 100;
+
+DirectoryScanner::DirectoryScanner()
+        : Thread(),
+          _showHidden(false),
+          _cancel(false),
+          _done(false),
+          _started(false),
+          _scanning(false)
+{
+    ILOG_TRACE_F(ILX_DIRECTORYSCANNER);
+    pthread_mutex_init(&_pendingLock, NULL);
+}
+
+DirectoryScanner::~DirectoryScanner()
+{
+    ILOG_TRACE_F(ILX_DIRECTORYSCANNER);
+    stop();
+    pthread_mutex_destroy(&_pendingLock);
+}
+
+const std::string&
+DirectoryScanner::path() const
+{
+    return _path;
+}
+
+bool
+DirectoryScanner::scanning() const
+{
+    return _scanning;
+}
+
+void
+DirectoryScanner::scan(const std::string& path, const std::string& filter, bool showHidden)
+{
+    ILOG_TRACE_F(ILX_DIRECTORYSCANNER);
+    stop();
+    _path = path;
+    _filter = filter;
+    _showHidden = showHidden;
+    _cancel = false;
+    _done = false;
+    _scanning = true;
+    _workConnection = Engine::instance().sigPerformWork.connect(sigc::mem_fun(this, &DirectoryScanner::deliver));
+    _started = start();
+    if (!_started)
+    {
+        ILOG_ERROR(ILX_DIRECTORYSCANNER, "Cannot start scanning %s\n", _path.c_str());
+        _done = true;
+    }
+}
+
+void
+DirectoryScanner::stop()
+{
+    ILOG_TRACE_F(ILX_DIRECTORYSCANNER);
+    _cancel = true;
+    if (_started)
+    {
+        join();
+        _started = false;
+    }
+    _workConnection.disconnect();
+    pthread_mutex_lock(&_pendingLock);
+    _pending.clear();
+    pthread_mutex_unlock(&_pendingLock);
+    _scanning = false;
+}
+
+int
+DirectoryScanner::run()
+{
+    ILOG_TRACE_F(ILX_DIRECTORYSCANNER);
+    EntryList entries;
+    int fd = open(_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    DIR* dp = fd < 0 ? NULL : fdopendir(fd);
+    if (!dp)
+    {
+        ILOG_ERROR(ILX_DIRECTORYSCANNER, "Error opening %s: %s\n", _path.c_str(), strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        push(&entries, true);
+        return 1;
+    }
+
+    unsigned int batch = __batchMin;
+    long long flushed = direct_clock_get_millis();
+    struct dirent* dirp;
+    struct stat st;
+    Entry entry;
+    while (!_cancel && (dirp = readdir(dp)) != NULL)
+    {
+        const char* name = dirp->d_name;
+        if (name[0] == '.' && name[1] == 0)
+            continue;
+        // keep ".." so that browser can go up.
+        if (!_showHidden && name[0] == '.' && strcmp(name, ".."))
+            continue;
+
+        entry.dir = false;
+        entry.size = 0;
+        entry.modified = 0;
+
+        unsigned char type = dirp->d_type;
+        if (type == DT_LNK || type == DT_UNKNOWN)
+        {
+            // type of link target or unknown type requires stat.
+            if (fstatat(fd, name, &st, 0))
+                continue;
+            if (S_ISDIR(st.st_mode))
+                type = DT_DIR;
+            else if (S_ISREG(st.st_mode))
+                type = DT_REG;
+            else
+                continue;
+        } else if (type != DT_DIR && type != DT_REG)
+            continue;
+
+        if (type == DT_DIR)
+            entry.dir = true;
+        else
+        {
+            if (!_filter.empty())
+            {
+                const char* suffix = strrchr(name, '.');
+                if (!suffix || suffix == name || !suffix[1] || _filter.find(suffix + 1) == std::string::npos)
+                    continue;
+            }
+            if (dirp->d_type != DT_LNK && dirp->d_type != DT_UNKNOWN && fstatat(fd, name, &st, 0))
+                continue;
+            entry.size = st.st_size;
+            entry.modified = st.st_mtime;
+        }
+
+        entry.name = name;
+        entries.push_back(entry);
+
+        long long now = direct_clock_get_millis();
+        if (entries.size() >= batch || now - flushed >= __batchInterval)
+        {
+            push(&entries, false);
+            flushed = now;
+            if (batch < __batchMax)
+                batch *= 2;
+        }
+    }
+    closedir(dp);
+    ILOG_DEBUG(ILX_DIRECTORYSCANNER, " -> %s scanned%s.\n", _path.c_str(), _cancel ? " (cancelled)" : "");
+    push(&entries, true);
+    return 0;
+}
+
+void
+DirectoryScanner::push(EntryList* entries, bool last)
+{
+    pthread_mutex_lock(&_pendingLock);
+    if (_pending.empty())
+        _pending.swap(*entries);
+    else
+        _pending.insert(_pending.end(), entries->begin(), entries->end());
+    if (last)
+        _done = true;
+    pthread_mutex_unlock(&_pendingLock);
+    entries->clear();
+    Engine::instance().wakeUp();
+}
+
+void
+DirectoryScanner::deliver()
+{
+    EntryList entries;
+    pthread_mutex_lock(&_pendingLock);
+    entries.swap(_pending);
+    bool done = _done;
+    pthread_mutex_unlock(&_pendingLock);
+
+    if (done)
+    {
+        if (_started)
+            join();
+        _started = false;
+        _scanning = false;
+        _workConnection.disconnect();
+    }
+
+    if (!entries.empty())
+    {
+        ILOG_DEBUG(ILX_DIRECTORYSCANNER, " -> %lu entries from %s\n", (unsigned long) entries.size(), _path.c_str());
+        sigEntriesFound(entries);
+    }
+
+    // a slot might have started another scan.
+    if (done && !_scanning)
+        sigScanFinished();
+}
+
+} /* namespace ilixi */
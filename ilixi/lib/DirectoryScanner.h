@@ -0,0 +1,147 @@
+/*
+ Copyright 2010-2015 Tarik Sekmen.
+
+ All Rights Reserved.
+
+ Written by Tarik Sekmen <tarik@ilixi.org>.
+
+ This file is part of ilixi.
+
+ ilixi is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ ilixi is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ILIXI_DIRECTORYSCANNER_H_
+#define ILIXI_DIRECTORYSCANNER_H_
+
+#include <lib/Thread.h>
+#include <string>
+#include <vector>
+#include <time.h>
+
+namespace ilixi
+{
+//! Lists a directory in background.
+/*!
+ * Scanner reads directory entries in its own thread and passes them to main thread in batches,
+ * so that large directories, e.g. on USB storage, can be shown while they are read.
+ *
+ * Entry types are taken from directory entries where possible, files are stat'ed only if
+ * they pass filter.
+ */
+class DirectoryScanner : public Thread
+{
+public:
+    //! This struct stores a directory or regular file found by scanner.
+    struct Entry
+    {
+        //! Name of file without path.
+        std::string name;
+        //! True if entry is a directory.
+        bool dir;
+        //! Size in bytes, 0 for directories.
+        long long size;
+        //! Last modification time, 0 for directories.
+        time_t modified;
+    };
+
+    typedef std::vector<Entry> EntryList;
+
+    /*!
+     * Constructor.
+     */
+    DirectoryScanner();
+
+    /*!
+     * Destructor.
+     *
+     * Stops scanning.
+     */
+    virtual
+    ~DirectoryScanner();
+
+    /*!
+     * Returns path of current or last scan.
+     */
+    const std::string&
+    path() const;
+
+    /*!
+     * Returns true until all entries of current scan are passed to main thread.
+     */
+    bool
+    scanning() const;
+
+    /*!
+     * Stops current scan and starts scanning given path.
+     *
+     * Files are listed only if their suffix is found in filter, see FileBrowser::setFilter().
+     * Directories are always listed. Hidden files are listed only if showHidden is true.
+     */
+    void
+    scan(const std::string& path, const std::string& filter = "", bool showHidden = false);
+
+    /*!
+     * Stops current scan and discards entries which are not passed to main thread yet.
+     */
+    void
+    stop();
+
+    /*!
+     * This signal is emitted on main thread with each batch of entries.
+     */
+    sigc::signal<void, const EntryList&> sigEntriesFound;
+
+    /*!
+     * This signal is emitted on main thread after last batch of a scan.
+     */
+    sigc::signal<void> sigScanFinished;
+
+protected:
+    virtual int
+    run();
+
+private:
+    //! This property stores scanned path.
+    std::string _path;
+    //! This property stores file filter.
+    std::string _filter;
+    //! This property specifies whether hidden files are listed.
+    bool _showHidden;
+    //! Set to stop scanning thread.
+    volatile bool _cancel;
+    //! Set by scanning thread after last batch.
+    volatile bool _done;
+    //! This property is true if thread is started and not joined yet.
+    bool _started;
+    //! This property is true until sigScanFinished is emitted.
+    bool _scanning;
+    //! Entries waiting for main thread.
+    EntryList _pending;
+    //! Serialises access to pending entries.
+    pthread_mutex_t _pendingLock;
+    //! Connection to Engine's sigPerformWork while scanning.
+    sigc::connection _workConnection;
+
+    //! Passes entries to pending list and wakes main thread.
+    void
+    push(EntryList* entries, bool last);
+
+    //! Emits pending entries, executed by main thread.
+    void
+    deliver();
+};
+
+} /* namespace ilixi */
+#endif /* ILIXI_DIRECTORYSCANNER_H_ */
@@ -25,6 +25,7 @@
 
 #include <lib/Gesture.h>
 #include <core/Logger.h>
+#include <algorithm>
 #include <cmath>
 
 namespace ilixi
@@ -34,6 +35,144 @@ static const double RAD_2_DIRECTION = 1.27323954474;
 
 D_DEBUG_DOMAIN(ILX_GESTURE, "ilixi/lib/GestureRecognizer", "GestureRecognizer");
 
+//! Number of points in a resampled path.
+static const unsigned int __pathPoints = 32;
+//! Rotation range and precision used while matching paths.
+static const float __pathAngle = 0.785398163f;
+static const float __pathAnglePrecision = 0.034906585f;
+//! Golden ratio, used for searching best rotation.
+static const float __phi = 0.618033989f;
+
+static int
+moveDirection(int dx, int dy)
+{
+    int dir = round(atan2f(dy, dx) * RAD_2_DIRECTION);
+    if (dir < 0)
+        dir += 8;
+    return dir;
+}
+
+//! Resamples path to equidistant points, scales it to unit size and moves its centroid to origin.
+static std::vector<float>
+normalisePath(const std::vector<float>& path)
+{
+    std::vector<float> points;
+    size_t count = path.size() / 2;
+    if (count < 2)
+        return points;
+
+    float length = 0;
+    for (size_t i = 1; i < count; ++i)
+        length += hypotf(path[2 * i] - path[2 * i - 2], path[2 * i + 1] - path[2 * i - 1]);
+    if (length <= 0)
+        return points;
+
+    float interval = length / (__pathPoints - 1);
+    float d = 0;
+    float px = path[0];
+    float py = path[1];
+    points.reserve(2 * __pathPoints);
+    points.push_back(px);
+    points.push_back(py);
+    for (size_t i = 1; i < count && points.size() < 2 * __pathPoints; ++i)
+    {
+        float x = path[2 * i];
+        float y = path[2 * i + 1];
+        float segment = hypotf(x - px, y - py);
+        while (d + segment >= interval && points.size() < 2 * __pathPoints)
+        {
+            float t = (interval - d) / segment;
+            px += t * (x - px);
+            py += t * (y - py);
+            points.push_back(px);
+            points.push_back(py);
+            segment = hypotf(x - px, y - py);
+            d = 0;
+        }
+        d += segment;
+        px = x;
+        py = y;
+    }
+    while (points.size() < 2 * __pathPoints)
+    {
+        points.push_back(path[2 * count - 2]);
+        points.push_back(path[2 * count - 1]);
+    }
+
+    // Scale uniformly, so that straight lines keep their direction.
+    float minX = points[0], maxX = points[0], minY = points[1], maxY = points[1];
+    float cx = 0, cy = 0;
+    for (size_t i = 0; i < points.size(); i += 2)
+    {
+        minX = std::min(minX, points[i]);
+        maxX = std::max(maxX, points[i]);
+        minY = std::min(minY, points[i + 1]);
+        maxY = std::max(maxY, points[i + 1]);
+        cx += points[i];
+        cy += points[i + 1];
+    }
+    float scale = std::max(maxX - minX, maxY - minY);
+    cx /= __pathPoints;
+    cy /= __pathPoints;
+    for (size_t i = 0; i < points.size(); i += 2)
+    {
+        points[i] = (points[i] - cx) / scale;
+        points[i + 1] = (points[i + 1] - cy) / scale;
+    }
+    return points;
+}
+
+//! Returns average distance between points of path rotated by angle and gesture, or a value above bound.
+static float
+pathDistance(const std::vector<float>& path, const std::vector<float>& gesture, float angle, float bound)
+{
+    float c = cosf(angle);
+    float s = sinf(angle);
+    float limit = bound * __pathPoints;
+    float sum = 0;
+    for (size_t i = 0; i < path.size(); i += 2)
+    {
+        float x = path[i] * c - path[i + 1] * s;
+        float y = path[i] * s + path[i + 1] * c;
+        sum += hypotf(x - gesture[i], y - gesture[i + 1]);
+        if (sum > limit)
+            break;
+    }
+    return sum / __pathPoints;
+}
+
+//! Searches rotation with smallest distance using golden section search.
+static float
+pathDistanceAtBestAngle(const std::vector<float>& path, const std::vector<float>& gesture, float bound)
+{
+    float a = -__pathAngle;
+    float b = __pathAngle;
+    float x1 = __phi * a + (1 - __phi) * b;
+    float x2 = (1 - __phi) * a + __phi * b;
+    float f1 = pathDistance(path, gesture, x1, bound);
+    float f2 = pathDistance(path, gesture, x2, bound);
+    while (fabsf(b - a) > __pathAnglePrecision)
+    {
+        if (f1 < f2)
+        {
+            b = x2;
+            x2 = x1;
+            f2 = f1;
+            x1 = __phi * a + (1 - __phi) * b;
+            f1 = pathDistance(path, gesture, x1, bound);
+        } else
+        {
+            a = x1;
+            x1 = x2;
+            f1 = f2;
+            x2 = (1 - __phi) * a + __phi * b;
+            f2 = pathDistance(path, gesture, x2, bound);
+        }
+    }
+    return std::min(f1, f2);
+}
+
+
 GestureRecognizer::GestureRecognizer()
         : _preX(-1),
           _preY(-1),
@@ -41,7 +180,10 @@ GestureRecognizer::GestureRecognizer()
           _lastMoveTS(0),
           _frequency(40),
           _minDistance(900),
-          _sensitivity(2)
+          _sensitivity(2),
+          _matchMethod(MoveMatch),
+          _minScore(0.8),
+          _bound(2)
 {
     ILOG_TRACE_F(ILX_GESTURE);
 }
@@ -61,15 +203,63 @@ GestureRecognizer::addGesture(const std::string& gestureName, const std::string&
         return;
     }
 
-    std::vector<int> g;
+    Gesture g;
+    g.name = gestureName;
+    std::vector<float> path(2, 0.0f);
     for (unsigned int i = 0; i < moves.size(); i++)
-        g.push_back(moves[i] - '0');
+    {
+        int dir = moves[i] - '0';
+        if (dir < 0 || dir > 7)
+        {
+            ILOG_WARNING(ILX_GESTURE, "Gesture \"%s\" has invalid move '%c'!\n", gestureName.c_str(), moves[i]);
+            return;
+        }
+        g.moves.push_back((char) dir);
+        path.push_back(path[path.size() - 2] + cos(dir / RAD_2_DIRECTION));
+        path.push_back(path[path.size() - 2] + sin(dir / RAD_2_DIRECTION));
+    }
+    g.points = normalisePath(path);
+    insertGesture(g);
+}
+
+void
+GestureRecognizer::addGesture(const std::string& gestureName, const std::vector<Point>& points)
+{
+    ILOG_TRACE_F(ILX_GESTURE);
+    if (gestureName.empty())
+    {
+        ILOG_WARNING(ILX_GESTURE, "Gesture name is empty!\n");
+        return;
+    }
 
-    std::pair<GestureMap::iterator, bool> res = _gestures.insert(std::make_pair(gestureName, g));
-    if (!res.second)
-        ILOG_WARNING(ILX_GESTURE, "Gesture \"%s\" already exists!\n", gestureName.c_str());
-    else
-        ILOG_DEBUG(ILX_GESTURE, " -> Added \"%s\".\n", gestureName.c_str());
+    Gesture g;
+    g.name = gestureName;
+    std::vector<float> path;
+    int lastMove = -1;
+    for (unsigned int i = 0; i < points.size(); i++)
+    {
+        path.push_back(points[i].x());
+        path.push_back(points[i].y());
+        if (i == 0)
+            continue;
+        int dx = points[i].x() - points[i - 1].x();
+        int dy = points[i].y() - points[i - 1].y();
+        if (dx || dy)
+        {
+            // consecutive points of a drawn path are sampled more densely than moves.
+            int dir = moveDirection(dx, dy);
+            if (dir != lastMove)
+                g.moves.push_back((char) dir);
+            lastMove = dir;
+        }
+    }
+    g.points = normalisePath(path);
+    if (g.points.empty())
+    {
+        ILOG_WARNING(ILX_GESTURE, "Gesture \"%s\" needs at least two distinct points!\n", gestureName.c_str());
+        return;
+    }
+    insertGesture(g);
 }
 
 bool
@@ -128,6 +318,18 @@ GestureRecognizer::sensitivity() const
     return _sensitivity;
 }
 
+GestureRecognizer::MatchMethod
+GestureRecognizer::matchMethod() const
+{
+    return _matchMethod;
+}
+
+float
+GestureRecognizer::minScore() const
+{
+    return _minScore;
+}
+
 void
 GestureRecognizer::setFrequency(unsigned int frequency)
 {
@@ -146,6 +348,18 @@ GestureRecognizer::setSensitivity(unsigned int sensitivity)
     _sensitivity = sensitivity;
 }
 
+void
+GestureRecognizer::setMatchMethod(MatchMethod method)
+{
+    _matchMethod = method;
+}
+
+void
+GestureRecognizer::setMinScore(float score)
+{
+    _minScore = score;
+}
+
 void
 GestureRecognizer::start(int x, int y)
 {
@@ -156,6 +370,11 @@ GestureRecognizer::start(int x, int y)
     _lastMoveTS = direct_clock_get_millis();
     _preX = x;
     _preY = y;
+    _origin = Point(x, y);
+    // distances are stored in bytes.
+    _bound = std::min(_sensitivity, 254u);
+    for (GestureList::iterator i = _gestures.begin(); i != _gestures.end(); ++i)
+        resetColumn(*i);
 }
 
 void
@@ -194,14 +413,15 @@ void
 GestureRecognizer::addMove(int dx, int dy)
 {
     ILOG_TRACE_F(ILX_GESTURE);
-    int dir = round(atan2f(dy, dx) * RAD_2_DIRECTION);
-    if (dir < 0)
-        dir += 8;
+    int dir = moveDirection(dx, dy);
 
     if (_lastMove != dir)
     {
         ILOG_DEBUG(ILX_GESTURE, " -> movement direction: %d\n", dir);
         _moves.push_back(dir);
+        for (GestureList::iterator i = _gestures.begin(); i != _gestures.end(); ++i)
+            if (i->alive)
+                advanceColumn(*i, dir, _moves.size());
         sigMovement();
     }
 }
@@ -209,41 +429,139 @@ GestureRecognizer::addMove(int dx, int dy)
 std::string
 GestureRecognizer::matchGesture()
 {
+    if (_matchMethod == PathMatch)
+        return matchPath();
+
     if (_moves.empty())
         return "";
 
-    int distance = INT_MAX;
+    // Columns are up to date, only last distance of each gesture is checked.
+    unsigned int distance = _bound + 1;
     std::string match = "";
-
-    for (GestureMap::iterator i = _gestures.begin(); i != _gestures.end(); ++i)
+    for (GestureList::const_iterator i = _gestures.begin(); i != _gestures.end(); ++i)
     {
-        int temp = levenshteinDistance(i->second, _moves);
-        if (temp <= _sensitivity && temp < distance)
+        if (!i->alive)
+            continue;
+        unsigned int temp = _columns[i->column + i->moves.size()];
+        if (temp < distance)
         {
             distance = temp;
-            match = i->first;
+            match = i->name;
         }
     }
     return match;
 }
 
-unsigned int
-GestureRecognizer::levenshteinDistance(const std::vector<int>& a, const std::vector<int>& b)
+std::string
+GestureRecognizer::matchPath()
+{
+    if (_path.empty())
+        return "";
+
+    std::vector<float> path;
+    path.reserve(2 * _path.size() + 2);
+    path.push_back(_origin.x());
+    path.push_back(_origin.y());
+    for (unsigned int i = 0; i < _path.size(); ++i)
+    {
+        path.push_back(_path[i].x());
+        path.push_back(_path[i].y());
+    }
+    path = normalisePath(path);
+    if (path.empty())
+        return "";
+
+    // Half diagonal of unit square, average distances are scored relative to this.
+    const float halfDiagonal = 0.707106781f;
+    float best = (1 - _minScore) * halfDiagonal;
+    std::string match = "";
+    for (GestureList::const_iterator i = _gestures.begin(); i != _gestures.end(); ++i)
+    {
+        if (i->points.empty())
+            continue;
+        float d = pathDistanceAtBestAngle(path, i->points, best);
+        if (d <= best)
+        {
+            best = d;
+            match = i->name;
+        }
+    }
+    ILOG_DEBUG(ILX_GESTURE, " -> path score: %f\n", 1 - best / halfDiagonal);
+    return match;
+}
+
+void
+GestureRecognizer::insertGesture(Gesture& gesture)
+{
+    GestureList::iterator it = _gestures.begin();
+    while (it != _gestures.end() && it->name < gesture.name)
+        ++it;
+    if (it != _gestures.end() && it->name == gesture.name)
+    {
+        ILOG_WARNING(ILX_GESTURE, "Gesture \"%s\" already exists!\n", gesture.name.c_str());
+        return;
+    }
+
+    gesture.column = _columns.size();
+    _columns.resize(_columns.size() + gesture.moves.size() + 1);
+    resetColumn(gesture);
+    // catch up if a recording is in progress.
+    for (unsigned int i = 0; i < _moves.size() && gesture.alive; ++i)
+        advanceColumn(gesture, _moves[i], i + 1);
+    _gestures.insert(it, gesture);
+    ILOG_DEBUG(ILX_GESTURE, " -> Added \"%s\".\n", gesture.name.c_str());
+}
+
+void
+GestureRecognizer::resetColumn(Gesture& gesture)
+{
+    unsigned char* col = &_columns[gesture.column];
+    unsigned int cap = _bound + 1;
+    for (unsigned int i = 0; i <= gesture.moves.size(); ++i)
+        col[i] = std::min(i, cap);
+    gesture.alive = true;
+}
+
+void
+GestureRecognizer::advanceColumn(Gesture& gesture, unsigned char move, unsigned int length)
 {
-    const size_t len1 = a.size(), len2 = b.size();
-    std::vector<unsigned int> col(len2 + 1), prevCol(len2 + 1);
+    // Ukkonen's cut-off: a cell further than bound from diagonal can not be within bound,
+    // so only cells inside band are computed and others are kept at bound + 1.
+    unsigned char* col = &_columns[gesture.column];
+    const unsigned int n = gesture.moves.size();
+    const unsigned int j = length;
+    const unsigned int cap = _bound + 1;
+
+    if (n == 0)
+    {
+        col[0] = std::min(j, cap);
+        gesture.alive = col[0] <= _bound;
+        return;
+    }
 
-    for (unsigned int i = 0; i < prevCol.size(); i++)
-        prevCol[i] = i;
+    unsigned int lo = j > _bound + 1 ? j - _bound : 1;
+    unsigned int hi = std::min(n, j + _bound);
+    if (lo > hi)
+    {
+        gesture.alive = false;
+        return;
+    }
 
-    for (unsigned int i = 0; i < len1; i++)
+    unsigned int diag = col[lo - 1];
+    col[lo - 1] = lo == 1 ? std::min(j, cap) : cap;
+    unsigned int best = col[lo - 1];
+    for (unsigned int i = lo; i <= hi; ++i)
     {
-        col[0] = i + 1;
-        for (unsigned int j = 0; j < len2; j++)
-            col[j + 1] = std::min(std::min(1 + col[j], 1 + prevCol[1 + j]), prevCol[j] + (a[i] == b[j] ? 0 : 1));
-        col.swap(prevCol);
+        unsigned int left = col[i];
+        unsigned int value = std::min(std::min(left, (unsigned int) col[i - 1]) + 1, diag + (gesture.moves[i - 1] == move ? 0 : 1));
+        col[i] = std::min(value, cap);
+        diag = left;
+        best = std::min(best, (unsigned int) col[i]);
     }
-    return prevCol[len2];
+
+    // distances of a column never decrease in next columns.
+    if (best > _bound)
+        gesture.alive = false;
 }
 
 } /* namespace ilixi */
@@ -28,7 +28,7 @@
 
 #include <core/EventFilter.h>
 #include <sigc++/signal.h>
-#include <map>
+#include <string>
 #include <vector>
 
 namespace ilixi
@@ -49,10 +49,24 @@ namespace ilixi
  * 7 - North east
  *
  * For example a check gesture can be defined using "117777".
+ *
+ * By default, recorded moves are compared with gestures using edit distance. Distances
+ * are updated after each move, so a match is ready when pointer is released. Alternatively,
+ * PathMatch compares the shape of the pointer path with gestures after resampling and
+ * normalising scale, position and rotation (up to 45 degrees).
  */
 class GestureRecognizer : virtual public sigc::trackable, public EventFilter
 {
 public:
+    /*!
+     * This enum specifies how recorded gestures are matched.
+     */
+    enum MatchMethod
+    {
+        MoveMatch,      //!< Compare moves using edit distance, see setSensitivity().
+        PathMatch       //!< Compare resampled and normalised paths, see setMinScore().
+    };
+
     GestureRecognizer();
 
     virtual
@@ -67,6 +81,15 @@ public:
     void
     addGesture(const std::string& gestureName, const std::string& moves);
 
+    /*!
+     * Adds a new gesture definition using a pointer path, e.g. path() of a recorded gesture.
+     *
+     * @param gestureName name of gesture to store
+     * @param points at least two points
+     */
+    void
+    addGesture(const std::string& gestureName, const std::vector<Point>& points);
+
     /*!
      * This method parses pointer events for recognition.
      */
@@ -103,6 +126,18 @@ public:
     unsigned int
     sensitivity() const;
 
+    /*!
+     * Returns match method.
+     */
+    MatchMethod
+    matchMethod() const;
+
+    /*!
+     * Returns minimum score for PathMatch.
+     */
+    float
+    minScore() const;
+
     /*!
      * Sets movement detection frequency.
      *
@@ -123,6 +158,18 @@ public:
     void
     setSensitivity(unsigned int sensitivity = 2);
 
+    /*!
+     * Sets match method.
+     */
+    void
+    setMatchMethod(MatchMethod method = MoveMatch);
+
+    /*!
+     * Sets minimum score between 0 and 1 required for a PathMatch.
+     */
+    void
+    setMinScore(float score = 0.8);
+
     /*!
      * This signal is emitted each time recognizer detects a movement.
      */
@@ -153,15 +200,39 @@ private:
     unsigned int _minDistance;
     //! Recognizer sensitivity, default: 2.
     unsigned int _sensitivity;
+    //! Match method, default: MoveMatch.
+    MatchMethod _matchMethod;
+    //! Minimum score for PathMatch, default: 0.8.
+    float _minScore;
+    //! Start point of current path.
+    Point _origin;
 
     //! This vector stores points corresponding to moves.
     std::vector<Point> _path;
     //! This vector stores moves.
     std::vector<int> _moves;
 
-    typedef std::map<std::string, std::vector<int> > GestureMap;
-    //! This stores defined gestures.
-    GestureMap _gestures;
+    //! This struct stores a gesture definition.
+    struct Gesture
+    {
+        std::string name;
+        //! Directions, one byte per move.
+        std::string moves;
+        //! Resampled and normalised path, x and y are interleaved.
+        std::vector<float> points;
+        //! Offset of distance column in _columns.
+        unsigned int column;
+        //! False if distance to recorded moves exceeds bound.
+        bool alive;
+    };
+
+    typedef std::vector<Gesture> GestureList;
+    //! This stores defined gestures sorted by name.
+    GestureList _gestures;
+    //! Edit distances between gesture prefixes and recorded moves, a column per gesture.
+    std::vector<unsigned char> _columns;
+    //! Maximum distance tracked for current recording.
+    unsigned int _bound;
 
     //! Starts recognition.
     void
@@ -183,9 +254,21 @@ private:
     std::string
     matchGesture();
 
-    //! Calculates Levenshtein distance.
-    unsigned int
-    levenshteinDistance(const std::vector<int>& a, const std::vector<int>& b);
+    //! Returns closest gesture to recorded path if its score is above minimum.
+    std::string
+    matchPath();
+
+    //! Stores a gesture and its distance column.
+    void
+    insertGesture(Gesture& gesture);
+
+    //! Resets distance column of gesture for an empty recording.
+    void
+    resetColumn(Gesture& gesture);
+
+    //! Updates distance column of gesture after length moves are recorded, move being the last.
+    void
+    advanceColumn(Gesture& gesture, unsigned char move, unsigned int length);
 };
 
 } /* namespace ilixi */
@@ -32,10 +32,8 @@ D_DEBUG_DOMAIN(ILX_BRUSH, "ilixi/types/Brush", "Brush");
 Brush::Brush()
         : _modified(true),
           _color(1, 1, 1)
-#ifdef ILIXI_HAVE_CAIRO
           ,_mode(SolidColorMode),
           _gradient()
-#endif
 {
     ILOG_TRACE(ILX_BRUSH);
 }
@@ -43,10 +41,8 @@ Brush::Brush()
 Brush::Brush(const Brush& brush)
         : _modified(true),
           _color(brush._color)
-#ifdef ILIXI_HAVE_CAIRO
           ,_mode(brush.mode()),
           _gradient(brush.gradient())
-#endif
 {
     ILOG_TRACE(ILX_BRUSH);
 }
@@ -54,10 +50,8 @@ Brush::Brush(const Brush& brush)
 Brush::Brush(const Color& color)
         : _modified(true),
           _color(color)
-#ifdef ILIXI_HAVE_CAIRO
           ,_mode(SolidColorMode),
           _gradient()
-#endif
 {
     ILOG_TRACE(ILX_BRUSH);
 }
@@ -87,10 +81,8 @@ Brush::operator=(const Brush &brush)
     {
         _color = brush._color;
         _modified = true;
-#ifdef ILIXI_HAVE_CAIRO
         _mode = brush.mode();
         _gradient = brush.gradient();
-#endif
     }
     return *this;
 }
@@ -111,7 +103,6 @@ Brush::applyBrush(IDirectFBSurface* surface)
     return true;
 }
 
-#ifdef ILIXI_HAVE_CAIRO
 Brush::BrushMode
 Brush::mode() const
 {
@@ -139,6 +130,7 @@ Brush::setGradient(const Gradient& gradient)
     _modified = true;
 }
 
+#ifdef ILIXI_HAVE_CAIRO
 bool
 Brush::applyBrush(cairo_t* context)
 {
@@ -26,10 +26,7 @@
 
 #include <ilixiConfig.h>
 #include <types/Color.h>
-
-#ifdef ILIXI_HAVE_CAIRO
 #include <types/Gradient.h>
-#endif
 
 namespace ilixi
 {
@@ -82,7 +79,6 @@ public:
     Brush&
     operator=(const Brush &brush);
 
-#ifdef ILIXI_HAVE_CAIRO
     /*!
      * Available brush modes.
      */
@@ -133,7 +129,6 @@ public:
      */
     void
     setGradient(const Gradient& gradient);
-#endif
 
 private:
     //! Flag is set to true if pen is modified.
@@ -141,12 +136,12 @@ private:
     //! This property holds current brush color.
     Color _color;
 
-#ifdef ILIXI_HAVE_CAIRO
     //! This property holds current brush mode.
     BrushMode _mode;
     //! This property holds gradient used by the brush.
     Gradient _gradient;
 
+#ifdef ILIXI_HAVE_CAIRO
     //! Applies the brush to the cairo context.
     bool
     applyBrush(cairo_t* context);
@@ -350,7 +350,8 @@ enum AppOptions
     OptSound = 0x00000020,              //!< Enable FusionSound interfaces for Application.
     OptExclSoundEffect = 0x00000040,    //!< Enable playback of sound effects via compositor.
     OptNoUpdates = 0x00000080,          //!< Disables window updates for Application.
-    OptTripleAccelerated = 0x00000200
+    OptTripleAccelerated = 0x00000200,
+    OptBackgroundLowRate = 0x00000400   //!< Keep painting at a low rate while compositor hides application, e.g. for thumbnails.
 };
 
 enum LayerFlipMode
@@ -21,50 +21,118 @@
  along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 #include <types/Gradient.h>
+#include <math.h>
+#include <string.h>
 
 namespace ilixi
 {
 
+#ifndef ILX_DOXYGEN_SKIP
+struct GradientStop
+{
+    double offset;
+    Color color;
+};
+
+struct Gradient::GradientData
+{
+    int refs;
+    double coords[6];
+    GradientExtendMethod extend;
+    std::vector<GradientStop> stops;
+    //! Hash of stops used for ramp, 0 if ramp is not computed.
+    unsigned int rampHash;
+    u32 ramp[RampSize];
+#ifdef ILIXI_HAVE_CAIRO
+    cairo_pattern_t* pattern;
+#endif
+};
+#endif
+
+static inline unsigned int
+hashBytes(unsigned int seed, const void* data, size_t length)
+{
+    const unsigned char* p = (const unsigned char*) data;
+    for (size_t i = 0; i < length; ++i)
+    {
+        seed ^= p[i];
+        seed *= 16777619;
+    }
+    return seed;
+}
+
+static inline u32
+packColor(const Color& c)
+{
+    return ((u32) c.alpha() << 24) | ((u32) c.red() << 16) | ((u32) c.green() << 8) | c.blue();
+}
+
+static inline u32
+mixColor(u32 a, u32 b, int weight)
+{
+    u32 r = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int ca = (a >> shift) & 0xFF;
+        int cb = (b >> shift) & 0xFF;
+        r |= (u32) ((ca * (256 - weight) + cb * weight) >> 8) << shift;
+    }
+    return r;
+}
+
 Gradient::Gradient()
         : _type(None),
-          _pattern(0)
+          _data(new GradientData)
 {
+    _data->refs = 1;
+    memset(_data->coords, 0, sizeof(_data->coords));
+    _data->extend = ExtendPad;
+    _data->rampHash = 0;
+#ifdef ILIXI_HAVE_CAIRO
+    _data->pattern = NULL;
+#endif
 }
 
 Gradient::Gradient(GradientType type)
         : _type(type),
-          _pattern(0)
+          _data(new GradientData)
 {
+    _data->refs = 1;
+    memset(_data->coords, 0, sizeof(_data->coords));
+    _data->extend = ExtendPad;
+    _data->rampHash = 0;
+#ifdef ILIXI_HAVE_CAIRO
+    _data->pattern = NULL;
+#endif
 }
 
 Gradient::Gradient(const Gradient& gradient)
         : _type(gradient.type()),
-          _pattern(gradient.cairoGradient())
+          _data(gradient._data)
 {
-    if (_pattern)
-        cairo_pattern_reference(_pattern);
+    ++_data->refs;
 }
 
 Gradient::~Gradient()
 {
-    if (_pattern)
-        cairo_pattern_destroy(_pattern);
+    releaseData();
 }
 
 int
 Gradient::stops()
 {
-    int stops = 0;
-    cairo_pattern_get_color_stop_count(_pattern, &stops);
-    return stops;
+    return _data->stops.size();
 }
 
+#ifdef ILIXI_HAVE_CAIRO
 cairo_pattern_t*
 Gradient::cairoGradient() const
 {
-    return _pattern;
+    return _data->pattern;
 }
+#endif
 
 Gradient::GradientType
 Gradient::type() const
@@ -75,19 +143,239 @@ Gradient::type() const
 void
 Gradient::addStop(const Color& color, double offset)
 {
-    cairo_pattern_add_color_stop_rgba(_pattern, offset, color.red() / 255.0, color.green() / 255.0, color.blue() / 255.0, color.alpha() / 255.0);
+    GradientStop stop;
+    stop.offset = offset < 0 ? 0 : (offset > 1 ? 1 : offset);
+    stop.color = color;
+
+    // Keep stops sorted, a stop with an equal offset goes after existing ones.
+    std::vector<GradientStop>::iterator it = _data->stops.begin();
+    while (it != _data->stops.end() && it->offset <= stop.offset)
+        ++it;
+    _data->stops.insert(it, stop);
+    _data->rampHash = 0;
+
+#ifdef ILIXI_HAVE_CAIRO
+    if (_data->pattern)
+        cairo_pattern_add_color_stop_rgba(_data->pattern, offset, color.red() / 255.0, color.green() / 255.0, color.blue() / 255.0, color.alpha() / 255.0);
+#endif
 }
 
 void
 Gradient::addStop(double r, double g, double b, double a, double offset)
 {
-    cairo_pattern_add_color_stop_rgba(_pattern, offset, r / 255.0, g / 255.0, b / 255.0, a / 255.0);
+    addStop(Color(r, g, b, a), offset);
+}
+
+Gradient::GradientExtendMethod
+Gradient::extendMethod() const
+{
+    return _data->extend;
 }
 
 void
 Gradient::setExtendMethod(GradientExtendMethod extendType)
 {
-    cairo_pattern_set_extend(_pattern, (cairo_extend_t) extendType);
+    _data->extend = extendType;
+#ifdef ILIXI_HAVE_CAIRO
+    if (_data->pattern)
+        cairo_pattern_set_extend(_data->pattern, (cairo_extend_t) extendType);
+#endif
+}
+
+unsigned int
+Gradient::hash() const
+{
+    unsigned int h = 2166136261u;
+    h = hashBytes(h, &_type, sizeof(_type));
+    h = hashBytes(h, &_data->extend, sizeof(_data->extend));
+    h = hashBytes(h, _data->coords, sizeof(_data->coords));
+    for (unsigned int i = 0; i < _data->stops.size(); ++i)
+    {
+        u32 color = packColor(_data->stops[i].color);
+        h = hashBytes(h, &_data->stops[i].offset, sizeof(double));
+        h = hashBytes(h, &color, sizeof(color));
+    }
+    return h;
+}
+
+bool
+Gradient::hasAlpha() const
+{
+    if (_data->extend == ExtendNone || _data->stops.empty())
+        return true;
+    for (unsigned int i = 0; i < _data->stops.size(); ++i)
+        if (_data->stops[i].color.alpha() != 255)
+            return true;
+    return false;
+}
+
+const u32*
+Gradient::colorRamp() const
+{
+    unsigned int h = 2166136261u;
+    for (unsigned int i = 0; i < _data->stops.size(); ++i)
+    {
+        u32 color = packColor(_data->stops[i].color);
+        h = hashBytes(h, &_data->stops[i].offset, sizeof(double));
+        h = hashBytes(h, &color, sizeof(color));
+    }
+    if (h == 0)
+        h = 1;
+
+    if (_data->rampHash == h)
+        return _data->ramp;
+
+    const std::vector<GradientStop>& stops = _data->stops;
+    if (stops.empty())
+        memset(_data->ramp, 0, sizeof(_data->ramp));
+    else
+    {
+        unsigned int next = 0;
+        for (int i = 0; i < RampSize; ++i)
+        {
+            double t = i / (double) (RampSize - 1);
+            while (next < stops.size() && stops[next].offset < t)
+                ++next;
+
+            if (next == 0)
+                _data->ramp[i] = packColor(stops[0].color);
+            else if (next == stops.size())
+                _data->ramp[i] = packColor(stops.back().color);
+            else
+            {
+                const GradientStop& s0 = stops[next - 1];
+                const GradientStop& s1 = stops[next];
+                double span = s1.offset - s0.offset;
+                int weight = span > 0 ? (int) (256 * (t - s0.offset) / span) : 256;
+                _data->ramp[i] = mixColor(packColor(s0.color), packColor(s1.color), weight);
+            }
+        }
+    }
+    _data->rampHash = h;
+    return _data->ramp;
+}
+
+bool
+Gradient::axisAligned(bool* horizontal) const
+{
+    if (_type != Linear)
+        return false;
+
+    const double* c = _data->coords;
+    if (c[1] == c[3] && c[0] != c[2])
+    {
+        *horizontal = true;
+        return true;
+    } else if (c[0] == c[2] && c[1] != c[3])
+    {
+        *horizontal = false;
+        return true;
+    }
+    return false;
+}
+
+int
+Gradient::rampIndex(double t) const
+{
+    switch (_data->extend)
+    {
+    case ExtendNone:
+        if (t < 0 || t > 1)
+            return -1;
+        break;
+    case ExtendRepeat:
+        t -= floor(t);
+        break;
+    case ExtendReflect:
+        t = fmod(fabs(t), 2);
+        if (t > 1)
+            t = 2 - t;
+        break;
+    default:
+        t = t < 0 ? 0 : (t > 1 ? 1 : t);
+        break;
+    }
+    return (int) (t * (RampSize - 1) + 0.5);
+}
+
+void
+Gradient::render(u32* pixels, int pitch, int x, int y, int width, int height) const
+{
+    const u32* ramp = colorRamp();
+    const double* c = _data->coords;
+
+    if (_type == Linear)
+    {
+        double dx = c[2] - c[0];
+        double dy = c[3] - c[1];
+        double len = dx * dx + dy * dy;
+        if (len == 0)
+            len = 1;
+        dx /= len;
+        dy /= len;
+
+        for (int j = 0; j < height; ++j)
+        {
+            u32* dst = (u32*) ((u8*) pixels + j * pitch);
+            double t = (x + 0.5 - c[0]) * dx + (y + j + 0.5 - c[1]) * dy;
+            for (int i = 0; i < width; ++i, t += dx)
+            {
+                int index = rampIndex(t);
+                dst[i] = index < 0 ? 0 : ramp[index];
+            }
+        }
+    } else if (_type == Radial)
+    {
+        // Finds largest t where point lies on circle interpolated between start and end circles.
+        double cdx = c[3] - c[0];
+        double cdy = c[4] - c[1];
+        double dr = c[5] - c[2];
+        double a = cdx * cdx + cdy * cdy - dr * dr;
+
+        for (int j = 0; j < height; ++j)
+        {
+            u32* dst = (u32*) ((u8*) pixels + j * pitch);
+            double py = y + j + 0.5 - c[1];
+            for (int i = 0; i < width; ++i)
+            {
+                double px = x + i + 0.5 - c[0];
+                double b = px * cdx + py * cdy + c[2] * dr;
+                double cc = px * px + py * py - c[2] * c[2];
+                double t;
+                bool valid = true;
+
+                if (a == 0)
+                {
+                    if (b == 0)
+                        valid = false;
+                    else
+                        t = cc / (2 * b);
+                } else
+                {
+                    double disc = b * b - a * cc;
+                    if (disc < 0)
+                        valid = false;
+                    else
+                    {
+                        double root = sqrt(disc);
+                        t = (b + root) / a;
+                        if (c[2] + t * dr < 0)
+                            t = (b - root) / a;
+                    }
+                }
+
+                if (valid && c[2] + t * dr < 0)
+                    valid = false;
+
+                int index = valid ? rampIndex(t) : -1;
+                dst[i] = index < 0 ? 0 : ramp[index];
+            }
+        }
+    } else
+    {
+        for (int j = 0; j < height; ++j)
+            memset((u8*) pixels + j * pitch, 0, width * sizeof(u32));
+    }
 }
 
 Gradient&
@@ -95,14 +383,53 @@ Gradient::operator=(const Gradient &gradient)
 {
     if (this != &gradient)
     {
+        ++gradient._data->refs;
+        releaseData();
         _type = gradient.type();
-        if (_pattern)
-            cairo_pattern_destroy(_pattern);
-
-        _pattern = gradient.cairoGradient();
-        cairo_pattern_reference(_pattern);
+        _data = gradient._data;
     }
     return *this;
 }
 
+void
+Gradient::releaseData()
+{
+    if (--_data->refs == 0)
+    {
+#ifdef ILIXI_HAVE_CAIRO
+        if (_data->pattern)
+            cairo_pattern_destroy(_data->pattern);
+#endif
+        delete _data;
+    }
+    _data = NULL;
+}
+
+void
+Gradient::setCoordinates(double c0, double c1, double c2, double c3, double c4, double c5)
+{
+    double* c = _data->coords;
+    c[0] = c0;
+    c[1] = c1;
+    c[2] = c2;
+    c[3] = c3;
+    c[4] = c4;
+    c[5] = c5;
+
+#ifdef ILIXI_HAVE_CAIRO
+    if (_data->pattern)
+        cairo_pattern_destroy(_data->pattern);
+    if (_type == Linear)
+        _data->pattern = cairo_pattern_create_linear(c0, c1, c2, c3);
+    else
+        _data->pattern = cairo_pattern_create_radial(c0, c1, c2, c3, c4, c5);
+    cairo_pattern_set_extend(_data->pattern, (cairo_extend_t) _data->extend);
+    for (unsigned int i = 0; i < _data->stops.size(); ++i)
+    {
+        const Color& color = _data->stops[i].color;
+        cairo_pattern_add_color_stop_rgba(_data->pattern, _data->stops[i].offset, color.red() / 255.0, color.green() / 255.0, color.blue() / 255.0, color.alpha() / 255.0);
+    }
+#endif
+}
+
 } /* namespace ilixi */
@@ -21,11 +21,16 @@
  along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 #ifndef ILIXI_GRADIENT_H_
 #define ILIXI_GRADIENT_H_
 
+#include <ilixiConfig.h>
 #include <types/Color.h>
+#include <vector>
+#ifdef ILIXI_HAVE_CAIRO
 #include <cairo.h>
+#endif
 
 namespace ilixi
 {
@@ -34,6 +39,9 @@ namespace ilixi
    * Gradients are used by a Brush or Pen to interpolate colors during drawing of primitive shapes.
    * There are two types of gradients, LinearGradient and RadialGradient.
    *
+   * Copies of a gradient share their stops and geometry. Gradients are rendered by Painter
+   * without Cairo using a colour ramp which is computed once for each set of stops.
+   *
    * Note that at least one color stop should be defined using addStop().
    */
   class Gradient
@@ -63,6 +71,9 @@ namespace ilixi
       Radial    //!< A radial gradient.
     };
 
+    //! Number of entries in colour ramp.
+    static const int RampSize = 256;
+
     /*!
      * Destructor.
      */
@@ -75,11 +86,13 @@ namespace ilixi
     int
     stops();
 
+#ifdef ILIXI_HAVE_CAIRO
     /*!
      * Returns the cairo pattern of this gradient.
      */
     cairo_pattern_t*
     cairoGradient() const;
+#endif
 
     /*!
      * Returns the type of the gradient.
@@ -114,6 +127,12 @@ namespace ilixi
     void
     addStop(double red, double green, double blue, double alpha, double offset);
 
+    /*!
+     * Returns the extend method of this gradient.
+     */
+    GradientExtendMethod
+    extendMethod() const;
+
     /*!
      * Sets the extend method of this gradient.
      * @param extendType Default type is Pad.
@@ -121,10 +140,47 @@ namespace ilixi
     void
     setExtendMethod(GradientExtendMethod extendType);
 
+    /*!
+     * Returns a hash of stops, geometry and extend method.
+     */
+    unsigned int
+    hash() const;
+
+    /*!
+     * Returns true if gradient has transparent pixels.
+     */
+    bool
+    hasAlpha() const;
+
+    /*!
+     * Returns colour ramp with RampSize ARGB values sampled between offsets 0 and 1.
+     *
+     * Ramp is computed again only if stops are modified.
+     */
+    const u32*
+    colorRamp() const;
+
+    /*!
+     * Returns true if a linear gradient changes colour only in one direction.
+     *
+     * @param horizontal set to true if colour changes along x axis.
+     */
+    bool
+    axisAligned(bool* horizontal) const;
+
+    /*!
+     * Renders gradient into ARGB pixels.
+     *
+     * @param pixels first pixel of a buffer with given pitch in bytes.
+     * @param x left of rendered area in gradient coordinates.
+     * @param y top of rendered area in gradient coordinates.
+     */
+    void
+    render(u32* pixels, int pitch, int x, int y, int width, int height) const;
+
     /*!
      * Overloaded assignment operator.
-     * Calls destroy on self cairo_pattern and increases the reference count of
-     * assigned cairo_pattern by 1.
+     * Shares stops and geometry of assigned gradient.
      */
     Gradient&
     operator=(const Gradient &gradient);
@@ -146,11 +202,28 @@ namespace ilixi
      */
     Gradient(const Gradient& gradient);
 
+    /*!
+     * Sets geometry of gradient, linear gradients use start and end points (x1, y1, x2, y2)
+     * and radial gradients use start and end circles (x1, y1, r1, x2, y2, r2).
+     */
+    void
+    setCoordinates(double c0, double c1, double c2, double c3, double c4 = 0, double c5 = 0);
+
     //! This property holds the type of the gradient.
     GradientType _type;
 
-    //! Pointer to cairo pattern instance.
-    cairo_pattern_t* _pattern;
+  private:
+    struct GradientData;
+    //! Shared stops and geometry.
+    GradientData* _data;
+
+    //! Returns ramp position of given gradient offset after applying extend method, or -1.
+    int
+    rampIndex(double t) const;
+
+    //! Decrements reference count of shared data and deletes it if unused.
+    void
+    releaseData();
   };
 }
 #endif /* ILIXI_GRADIENT_H_ */
@@ -25,6 +25,9 @@
 #include <core/PlatformManager.h>
 #include <core/Logger.h>
 #include <graphics/Stylist.h>
+#if ILIXI_HAVE_COMPOSITOR
+#include <core/DaleDFB.h>
+#endif
 
 namespace ilixi
 {
@@ -87,6 +90,18 @@ Image::Image(Image* source, const Rectangle& sourceRect)
     loadSubImage(source, sourceRect);
 }
 
+Image::Image(Image* format, int width, int height)
+        : _dfbSurface(NULL),
+          _imagePath(""),
+          _size(width, height),
+          _state((ImageFlags) (Initialised | SubImage)),
+          _caps(format->getCaps())
+{
+    ILOG_TRACE(ILX_IMAGE);
+    ILOG_DEBUG(ILX_IMAGE, " -> Blank image using format of %p - size: %d, %d\n", format, width, height);
+    loadBlankImage(format);
+}
+
 Image::Image(const Image& img)
         : _dfbSurface(NULL),
           _imagePath(img._imagePath),
@@ -202,7 +217,7 @@ Image::setImagePath(const std::string& path)
     {
         ILOG_DEBUG(ILX_IMAGE, " -> Path: %s\n", path.c_str());
         _imagePath = path;
-        _state = Initialised;
+        _state = (ImageFlags) (Initialised | (_state & Shared));
         invalidateSurface();
     }
 }
@@ -226,6 +241,18 @@ Image::setSize(const Size& s)
     }
 }
 
+void
+Image::setShared(bool shared)
+{
+    if (_state & SubImage)
+        return;
+
+    if (shared)
+        _state = (ImageFlags) (_state | Shared);
+    else
+        _state = (ImageFlags) (_state & ~Shared);
+}
+
 void
 Image::invalidateSurface()
 {
@@ -237,7 +264,7 @@ Image::invalidateSurface()
         if (_state & SubImage)
             _state = (ImageFlags) (Initialised | SubImage);
         else
-            _state = Initialised;
+            _state = (ImageFlags) (Initialised | (_state & Shared));
         ILOG_DEBUG(ILX_IMAGE, " -> State: %x\n", _state);
     }
 }
@@ -262,6 +289,9 @@ Image::loadImage()
         return false;
     }
 
+    if ((_state & Shared) && !_size.isValid() && loadSharedImage())
+        return true;
+
     ILOG_DEBUG(ILX_IMAGE, " -> Loading image: %s\n", _imagePath.c_str());
     DFBSurfaceDescription desc;
 
@@ -324,6 +354,41 @@ Image::loadImage()
     }
 }
 
+bool
+Image::loadSharedImage()
+{
+#if ILIXI_HAVE_COMPOSITOR
+    ILOG_TRACE(ILX_IMAGE);
+    if (!(PlatformManager::instance().appOptions() & OptDaleAuto) || (PlatformManager::instance().appOptions() & OptExclusive))
+        return false;
+
+    DFBSurfaceID id;
+    if (DaleDFB::getSharedImage(_imagePath, &id) != DFB_OK)
+    {
+        ILOG_DEBUG(ILX_IMAGE, " -> Shared image is not available, loading locally.\n");
+        return false;
+    }
+
+    if (PlatformManager::instance().getDFB()->GetSurface(PlatformManager::instance().getDFB(), id, &_dfbSurface) != DFB_OK)
+    {
+        _dfbSurface = NULL;
+        ILOG_ERROR(ILX_IMAGE, "Cannot get shared surface (%u) for %s\n", id, _imagePath.c_str());
+        return false;
+    }
+
+    DFBSurfacePixelFormat format;
+    if (_dfbSurface->GetPixelFormat(_dfbSurface, &format) == DFB_OK && DFB_PIXELFORMAT_HAS_ALPHA(format))
+        _caps = DICAPS_ALPHACHANNEL;
+    else
+        _caps = DICAPS_NONE;
+    ILOG_DEBUG(ILX_IMAGE, " -> Using shared image: %s (DFBSurfaceID: %u)\n", _imagePath.c_str(), id);
+    _state = (ImageFlags) (_state | Ready);
+    return true;
+#else
+    return false;
+#endif
+}
+
 DFBImageCapabilities
 Image::getCaps()
 {
@@ -351,6 +416,34 @@ Image::loadSubImage(Image* source, const Rectangle& sourceRect)
     return true;
 }
 
+bool
+Image::loadBlankImage(Image* format)
+{
+    ILOG_TRACE(ILX_IMAGE);
+
+    IDirectFBSurface* src = format->getDFBSurface();
+    DFBSurfaceDescription desc;
+    desc.flags = (DFBSurfaceDescriptionFlags) (DSDESC_CAPS | DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT);
+    desc.caps = DSCAPS_PREMULTIPLIED;
+    desc.width = width();
+    desc.height = height();
+    if (src->GetPixelFormat(src, &desc.pixelformat) != DFB_OK)
+        desc.pixelformat = DSPF_ARGB;
+
+    DFBResult ret = PlatformManager::instance().getDFB()->CreateSurface(PlatformManager::instance().getDFB(), &desc, &_dfbSurface);
+    if (ret != DFB_OK)
+    {
+        _dfbSurface = NULL;
+        ILOG_ERROR(ILX_IMAGE, "Cannot create blank image surface! %s\n", DirectFBErrorString(ret));
+        _state = (ImageFlags) (_state | NotAvailable);
+        return false;
+    }
+
+    _dfbSurface->Clear(_dfbSurface, 0, 0, 0, 0);
+    _state = (ImageFlags) (_state | Ready);
+    return true;
+}
+
 std::istream&
 operator>>(std::istream& is, Image& obj)
 {
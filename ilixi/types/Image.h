@@ -72,6 +72,14 @@ public:
      */
     Image(Image* source, const Rectangle& sourceRect);
 
+    /*!
+     * Creates a transparent image with given width and height.
+     *
+     * Surface uses the pixel format and capabilities of format image so
+     * its regions can be copied onto the new image without conversion.
+     */
+    Image(Image* format, int width, int height);
+
     /*!
      * Copy constructor.
      */
@@ -153,6 +161,17 @@ public:
     void
     setSize(const Size& size);
 
+    /*!
+     * Sets whether image surface should be shared with other applications.
+     *
+     * If compositor is running, a shared image is loaded only once by compositor and
+     * its surface is used by all applications. Otherwise image is loaded locally.
+     *
+     * \warning This method does not have any effect if image is a sub-image or has a custom size.
+     */
+    void
+    setShared(bool shared);
+
 private:
     enum ImageFlags
     {
@@ -160,7 +179,8 @@ private:
         Modified = 0x0002,
         NotAvailable = 0x0004,
         Ready = 0x0008,
-        SubImage = 0x0010
+        SubImage = 0x0010,
+        Shared = 0x0020
     };
 
     //! This property stores the pointer to DirectFB surface.
@@ -188,9 +208,18 @@ private:
     bool
     loadImage();
 
+    /*!
+     * Tries to acquire image surface from compositor. Returns true if successful.
+     */
+    bool
+    loadSharedImage();
+
     bool
     loadSubImage(Image* source, const Rectangle& sourceRect);
 
+    bool
+    loadBlankImage(Image* format);
+
     friend std::istream&
     operator>>(std::istream& is, Image& obj);
 
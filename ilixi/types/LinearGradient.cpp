@@ -34,13 +34,13 @@ LinearGradient::LinearGradient()
 LinearGradient::LinearGradient(double x1, double y1, double x2, double y2)
         : Gradient(Linear)
 {
-    _pattern = cairo_pattern_create_linear(x1, y1, x2, y2);
+    setCoordinates(x1, y1, x2, y2);
 }
 
 LinearGradient::LinearGradient(const Point& start, const Point& end)
         : Gradient(Linear)
 {
-    _pattern = cairo_pattern_create_linear(start.x(), start.y(), end.x(), end.y());
+    setCoordinates(start.x(), start.y(), end.x(), end.y());
 }
 
 LinearGradient::~LinearGradient()
@@ -50,17 +50,13 @@ LinearGradient::~LinearGradient()
 void
 LinearGradient::setPatternCoordinates(double x1, double y1, double x2, double y2)
 {
-    if (_pattern)
-        cairo_pattern_destroy(_pattern);
-    _pattern = cairo_pattern_create_linear(x1, y1, x2, y2);
+    setCoordinates(x1, y1, x2, y2);
 }
 
 void
 LinearGradient::setPatternCoordinates(const Point& start, const Point& end)
 {
-    if (_pattern)
-        cairo_pattern_destroy(_pattern);
-    _pattern = cairo_pattern_create_linear(start.x(), start.y(), end.x(), end.y());
+    setCoordinates(start.x(), start.y(), end.x(), end.y());
 }
 
 } /* namespace ilixi */
@@ -67,7 +67,7 @@ public:
     ~LinearGradient();
 
     /*!
-     * Creates a new linear gradient and deletes old one.
+     * Sets start and end points, stops are kept.
      *
      * @param x1 X coordinate of start point.
      * @param y1 Y coordinate of start point.
@@ -78,7 +78,7 @@ public:
     setPatternCoordinates(double x1, double y1, double x2, double y2);
 
     /*!
-     * Creates a new linear gradient and deletes old one.
+     * Sets start and end points, stops are kept.
      *
      * @param start Start point.
      * @param end End point.
@@ -29,13 +29,13 @@ namespace ilixi
 RadialGradient::RadialGradient(double x1, double y1, double radius1, double x2, double y2, double radius2)
         : Gradient(Radial)
 {
-    _pattern = cairo_pattern_create_radial(x1, y1, radius1, x2, y2, radius2);
+    setCoordinates(x1, y1, radius1, x2, y2, radius2);
 }
 
 RadialGradient::RadialGradient(const Point& center1, double radius1, const Point& center2, double radius2)
         : Gradient(Radial)
 {
-    _pattern = cairo_pattern_create_radial(center1.x(), center1.y(), radius1, center2.x(), center2.y(), radius2);
+    setCoordinates(center1.x(), center1.y(), radius1, center2.x(), center2.y(), radius2);
 }
 
 RadialGradient::~RadialGradient()
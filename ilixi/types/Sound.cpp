@@ -25,6 +25,9 @@
 #include <lib/FileSystem.h>
 #include <core/Logger.h>
 #include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 namespace ilixi
@@ -46,61 +49,62 @@ typedef struct fmtChunk
 
 #endif
 
-static DirectResult
-read_file_header(int fd)
+//! Returns little endian 32 bit value at given position.
+static u32
+read_u32(const unsigned char* buf)
 {
-    char buf[12];
-
-    if (read(fd, buf, 12) < 12)
-    {
-        ILOG_ERROR(ILX_SOUND, "Could not read at least 12 bytes!\n");
-        return DR_IO;
-    }
-
-    if (buf[0] != 'R' || buf[1] != 'I' || buf[2] != 'F' || buf[3] != 'F')
-    {
-        ILOG_ERROR(ILX_SOUND, "No RIFF header found!\n");
-        return DR_UNSUPPORTED;
-    }
-
-    if (buf[8] != 'W' || buf[9] != 'A' || buf[10] != 'V' || buf[11] != 'E')
-    {
-        ILOG_ERROR(ILX_SOUND, "Not a WAVE!\n");
-        return DR_UNSUPPORTED;
-    }
-
-    return DR_OK;
+    return buf[0] | (buf[1] << 8) | (buf[2] << 16) | (buf[3] << 24);
 }
 
-static int
-read_chunk_header(int fd, char *magic)
+/*!
+ * Finds chunk with given magic inside mapped file, starting after RIFF header.
+ *
+ * Returns pointer to chunk data and sets its length, or NULL if chunk is not found.
+ */
+static const unsigned char*
+find_chunk(const unsigned char* file, size_t size, const char* magic, u32* length)
 {
-    unsigned char buf[8];
-
-    if (read(fd, buf, 8) < 8)
+    size_t pos = 12;
+    while (pos + 8 <= size)
     {
-        ILOG_ERROR(ILX_SOUND, "Could not read 8 bytes of chunk header!\n");
-        return -1;
+        u32 len = read_u32(file + pos + 4);
+        if (memcmp(file + pos, magic, 4) == 0)
+        {
+            if (pos + 8 + len > size)
+                len = size - pos - 8;
+            *length = len;
+            return file + pos + 8;
+        }
+        // Chunks are aligned to even bytes.
+        pos += 8 + len + (len & 1);
     }
-
-    strncpy(magic, (char*) buf, 4);
-
-    return buf[4] | (buf[5] << 8) | (buf[6] << 16) | (buf[7] << 24);
-
+    return NULL;
 }
 
 Sound::Sound()
         : _fileName(""),
           _buffer(NULL),
-          _playback(NULL)
+          _voiceCount(1),
+          _counter(0),
+          _ready(false),
+          _volume(1),
+          _pan(0),
+          _pitch(1),
+          _direction(Forward)
 {
     ILOG_TRACE_F(ILX_SOUND);
 }
 
-Sound::Sound(const std::string& filename)
+Sound::Sound(const std::string& filename, unsigned int voices)
         : _fileName(filename),
           _buffer(NULL),
-          _playback(NULL)
+          _voiceCount(voices ? voices : 1),
+          _counter(0),
+          _ready(false),
+          _volume(1),
+          _pan(0),
+          _pitch(1),
+          _direction(Forward)
 {
     ILOG_TRACE_F(ILX_SOUND);
     loadSample();
@@ -116,24 +120,28 @@ void
 Sound::start(bool looping)
 {
     ILOG_TRACE_F(ILX_SOUND);
-    if (_playback)
+    if (!_ready)
     {
-        DirectResult ret = _playback->Start(_playback, 0, 0);
-        if (ret)
-            ILOG_ERROR(ILX_SOUND, "Could not start playback!\n");
-    } else
-        ILOG_ERROR(ILX_SOUND, "Playback interface not ready!\n");
+        ILOG_DEBUG(ILX_SOUND, " -> %s is not loaded yet.\n", _fileName.c_str());
+        return;
+    }
+
+    Voice* voice = nextVoice();
+    voice->started = ++_counter;
+    DirectResult ret = voice->playback->Start(voice->playback, 0, looping ? -1 : 0);
+    if (ret)
+        ILOG_ERROR(ILX_SOUND, "Could not start playback!\n");
 }
 
 void
 Sound::stop()
 {
     ILOG_TRACE_F(ILX_SOUND);
-    if (_playback)
+    if (_ready)
     {
-        DirectResult ret = _playback->Stop(_playback);
-        if (ret)
-            ILOG_ERROR(ILX_SOUND, "Could not stop playback!\n");
+        for (VoiceList::iterator it = _voices.begin(); it != _voices.end(); ++it)
+            if (it->playback->Stop(it->playback))
+                ILOG_ERROR(ILX_SOUND, "Could not stop playback!\n");
     } else
         ILOG_ERROR(ILX_SOUND, "Playback interface not ready!\n");
 }
@@ -142,64 +150,73 @@ void
 Sound::setVolume(float level)
 {
     ILOG_TRACE_F(ILX_SOUND);
-    if (_playback)
+    if (level < 0)
+        level = 0;
+    else if (level > 1)
+        level = 1;
+    _volume = level;
+    // Pairs with barrier in loadSample(), so value is not lost while voices are created.
+    __sync_synchronize();
+
+    if (_ready)
     {
-        if (level < 0)
-            level = 0;
-        else if (level > 1)
-            level = 1;
-        DirectResult ret = _playback->SetVolume(_playback, level);
-        if (ret)
-            ILOG_ERROR(ILX_SOUND, "Could not set playback volume level %f!\n", level);
-    } else
-        ILOG_ERROR(ILX_SOUND, "Playback interface not ready!\n");
+        for (VoiceList::iterator it = _voices.begin(); it != _voices.end(); ++it)
+            if (it->playback->SetVolume(it->playback, level))
+                ILOG_ERROR(ILX_SOUND, "Could not set playback volume level %f!\n", level);
+    }
 }
 
 void
 Sound::setPan(float pan)
 {
     ILOG_TRACE_F(ILX_SOUND);
-    if (_playback)
+    if (pan < -1)
+        pan = -1;
+    else if (pan > 1)
+        pan = 1;
+    _pan = pan;
+    __sync_synchronize();
+
+    if (_ready)
     {
-        if (pan < -1)
-            pan = -1;
-        else if (pan > 1)
-            pan = 1;
-        DirectResult ret = _playback->SetPan(_playback, pan);
-        if (ret)
-            ILOG_ERROR(ILX_SOUND, "Could not set pan value %f!\n", pan);
-    } else
-        ILOG_ERROR(ILX_SOUND, "Playback interface not ready!\n");
+        for (VoiceList::iterator it = _voices.begin(); it != _voices.end(); ++it)
+            if (it->playback->SetPan(it->playback, pan))
+                ILOG_ERROR(ILX_SOUND, "Could not set pan value %f!\n", pan);
+    }
 }
 
 void
 Sound::setPitch(float value)
 {
     ILOG_TRACE_F(ILX_SOUND);
-    if (_playback)
+    if (value < -1)
+        value = -1;
+    else if (value > 1)
+        value = 1;
+    _pitch = value;
+    __sync_synchronize();
+
+    if (_ready)
     {
-        if (value < -1)
-            value = -1;
-        else if (value > 1)
-            value = 1;
-        DirectResult ret = _playback->SetPitch(_playback, value);
-        if (ret)
-            ILOG_ERROR(ILX_SOUND, "Could not set pitch value %f!\n", value);
-    } else
-        ILOG_ERROR(ILX_SOUND, "Playback interface not ready!\n");
+        for (VoiceList::iterator it = _voices.begin(); it != _voices.end(); ++it)
+            if (it->playback->SetPitch(it->playback, value))
+                ILOG_ERROR(ILX_SOUND, "Could not set pitch value %f!\n", value);
+    }
 }
 
 void
 Sound::setDirection(PlaybackDirection direction)
 {
     ILOG_TRACE_F(ILX_SOUND);
-    if (_playback)
+    _direction = direction;
+    __sync_synchronize();
+
+    if (_ready)
     {
-        DirectResult ret = _playback->SetDirection(_playback, (FSPlaybackDirection) direction);
-        if (ret)
-            ILOG_ERROR(ILX_SOUND, "Could not set playback direction!\n");
-    } else
-        ILOG_ERROR(ILX_SOUND, "Playback interface not ready!\n");
+        for (VoiceList::iterator it = _voices.begin(); it != _voices.end(); ++it)
+            if (it->playback->SetDirection(it->playback, (FSPlaybackDirection) direction))
+                ILOG_ERROR(ILX_SOUND, "Could not set playback direction!\n");
+    }
 }
 
 void
@@ -214,77 +231,109 @@ Sound::setFileName(const std::string& filename)
         ILOG_ERROR(ILX_SOUND, "%s not found!\n", filename.c_str());
 }
 
+void
+Sound::setVoices(unsigned int voices)
+{
+    _voiceCount = voices ? voices : 1;
+}
+
+bool
+Sound::ready() const
+{
+    return _ready;
+}
+
+Sound::Voice*
+Sound::nextVoice()
+{
+    Voice* oldest = &_voices[0];
+    for (VoiceList::iterator it = _voices.begin(); it != _voices.end(); ++it)
+    {
+        bool playing = false;
+        if (it->playback->GetStatus(it->playback, &playing, NULL) == DR_OK && !playing)
+            return &(*it);
+
+        if ((int) (it->started - oldest->started) < 0)
+            oldest = &(*it);
+    }
+
+    ILOG_DEBUG(ILX_SOUND, " -> all %zu voices are busy, restarting oldest.\n", _voices.size());
+    oldest->playback->Stop(oldest->playback);
+    return oldest;
+}
+
+void
+Sound::configureVoice(IFusionSoundPlayback* playback)
+{
+    playback->SetVolume(playback, _volume);
+    playback->SetPan(playback, _pan);
+    playback->SetPitch(playback, _pitch);
+    playback->SetDirection(playback, (FSPlaybackDirection) _direction);
+}
+
 void
 Sound::loadSample()
 {
     ILOG_TRACE_F(ILX_SOUND);
-    DirectResult ret;
-    int fd;
-    FSBufferDescription desc;
-    void *data;
-    fmtChunk fmt;
-    int len;
-
-    fd = open(_fileName.c_str(), O_RDONLY);
+    int fd = open(_fileName.c_str(), O_RDONLY);
     if (fd < 0)
     {
         ILOG_ERROR(ILX_SOUND, "Could not open %s!\n", _fileName.c_str());
         return;
     }
 
-    if (read_file_header(fd))
+    struct stat st;
+    if (fstat(fd, &st) || st.st_size < 12)
     {
+        ILOG_ERROR(ILX_SOUND, "Could not read at least 12 bytes!\n");
         close(fd);
         return;
     }
 
-    while (1)
+    // Parsed in place and copied once to buffer, buffer itself is private to this process.
+    size_t size = st.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
     {
-        char magic[4];
+        ILOG_ERROR(ILX_SOUND, "Could not map %s!\n", _fileName.c_str());
+        return;
+    }
 
-        len = read_chunk_header(fd, magic);
-        if (len <= 0)
-        {
-            ILOG_ERROR(ILX_SOUND, "Could not find format chunk!\n");
-            close(fd);
-            return;
-        }
+    const unsigned char* file = (const unsigned char*) map;
+    if (memcmp(file, "RIFF", 4) != 0)
+    {
+        ILOG_ERROR(ILX_SOUND, "No RIFF header found!\n");
+        munmap(map, size);
+        return;
+    }
 
-        if (magic[0] == 'f' || magic[1] == 'm' || magic[2] == 't')
-        {
-            if (len < sizeof(fmtChunk))
-            {
-                ILOG_ERROR(ILX_SOUND, "Format chunk has invalid size (%d/%zu)!\n", len, sizeof(fmtChunk));
-                close(fd);
-                return;
-            }
-
-            if (read(fd, &fmt, sizeof(fmtChunk)) < sizeof(fmtChunk))
-            {
-                ILOG_ERROR(ILX_SOUND, "Could not read format chunk!\n");
-                close(fd);
-                return;
-            }
-
-            if (lseek(fd, len - sizeof(fmtChunk), SEEK_CUR) == (off_t) -1)
-            {
-                ILOG_ERROR(ILX_SOUND, "Could not seek past chunk!\n");
-                close(fd);
-                return;
-            }
+    if (memcmp(file + 8, "WAVE", 4) != 0)
+    {
+        ILOG_ERROR(ILX_SOUND, "Not a WAVE!\n");
+        munmap(map, size);
+        return;
+    }
 
-            break;
-        } else
-        {
-            if (lseek(fd, len, SEEK_CUR) == (off_t) -1)
-            {
-                ILOG_ERROR(ILX_SOUND, "Could not seek past chunk!\n");
-                close(fd);
-                return;
-            }
-        }
+    u32 len;
+    const unsigned char* chunk = find_chunk(file, size, "fmt ", &len);
+    if (!chunk)
+    {
+        ILOG_ERROR(ILX_SOUND, "Could not find format chunk!\n");
+        munmap(map, size);
+        return;
     }
 
+    if (len < sizeof(fmtChunk))
+    {
+        ILOG_ERROR(ILX_SOUND, "Format chunk has invalid size (%u/%zu)!\n", len, sizeof(fmtChunk));
+        munmap(map, size);
+        return;
+    }
+
+    fmtChunk fmt;
+    memcpy(&fmt, chunk, sizeof(fmtChunk));
+
 #ifdef WORDS_BIGENDIAN
     fixup_fmtchunk( &fmt );
 #endif
@@ -292,83 +341,93 @@ Sound::loadSample()
     if (fmt.encoding != 1)
     {
         ILOG_ERROR(ILX_SOUND, "Only PCM supported, yet!\n");
-        close(fd);
+        munmap(map, size);
         return;
     }
 
     if (fmt.bitspersample != 16 && fmt.bitspersample != 8)
     {
         ILOG_ERROR(ILX_SOUND, "Only 16 or 8 bit supported, yet!\n");
-        close(fd);
+        munmap(map, size);
+        return;
+    }
+
+    chunk = find_chunk(file, size, "data", &len);
+    if (!chunk || len == 0)
+    {
+        ILOG_ERROR(ILX_SOUND, "Could not find data chunk!\n");
+        munmap(map, size);
         return;
     }
 
+    FSBufferDescription desc;
     desc.flags = (FSBufferDescriptionFlags) (FSBDF_LENGTH | FSBDF_CHANNELS | FSBDF_SAMPLEFORMAT | FSBDF_SAMPLERATE);
     desc.channels = fmt.channels;
     desc.sampleformat = (fmt.bitspersample == 8) ? FSSF_U8 : FSSF_S16;
     desc.samplerate = fmt.frequency;
-
-    while (1)
-    {
-        char magic[4];
-
-        len = read_chunk_header(fd, magic);
-        if (len <= 0)
-        {
-            ILOG_ERROR(ILX_SOUND, "Could not find data chunk!\n");
-            close(fd);
-            return;
-        }
-
-        if (magic[0] == 'd' && magic[1] == 'a' && magic[2] == 't' && magic[3] == 'a')
-        {
-            desc.length = len / fmt.blockalign;
-            break;
-        } else
-        {
-            if (lseek(fd, len, SEEK_CUR) == (off_t) -1)
-            {
-                ILOG_ERROR(ILX_SOUND, "Could not seek past chunk!\n");
-                close(fd);
-                return;
-            }
-        }
-    }
+    desc.length = len / fmt.blockalign;
 
     DFBResult res = SoundDFB::createBuffer(&desc, &_buffer);
     if (res)
     {
         ILOG_ERROR(ILX_SOUND, "Error in IFusionSound::CreateBuffer\n");
-        close(fd);
+        munmap(map, size);
         return;
     }
 
+    void *data;
     _buffer->Lock(_buffer, &data, 0, 0);
-
-    if (read(fd, data, len) < len)
-        ILOG_ERROR(ILX_SOUND, "Warning: Could not read all data bytes!\n");
+    memcpy(data, chunk, desc.length * fmt.blockalign);
 
 #ifdef WORDS_BIGENDIAN
     if (fmt.bitspersample == 16)
     fixup_sampledata (data, len);
 #endif
 
-    close(fd);
     _buffer->Unlock(_buffer);
+    munmap(map, size);
 
-    ret = _buffer->CreatePlayback(_buffer, &_playback);
-    if (ret)
-        ILOG_ERROR(ILX_SOUND, "Error in IFusionSoundBuffer::CreatePlayback\n");
+    for (unsigned int i = 0; i < _voiceCount; ++i)
+    {
+        Voice voice;
+        voice.started = 0;
+        if (_buffer->CreatePlayback(_buffer, &voice.playback))
+        {
+            ILOG_ERROR(ILX_SOUND, "Error in IFusionSoundBuffer::CreatePlayback\n");
+            break;
+        }
+        configureVoice(voice.playback);
+        _voices.push_back(voice);
+    }
+
+    if (!_voices.empty())
+    {
+        __sync_synchronize();
+        _ready = true;
+
+        // Apply settings changed while voices were created.
+        __sync_synchronize();
+        for (VoiceList::iterator it = _voices.begin(); it != _voices.end(); ++it)
+            configureVoice(it->playback);
+        ILOG_DEBUG(ILX_SOUND, " -> %s loaded with %zu voices.\n", _fileName.c_str(), _voices.size());
+    }
 }
 
 void
 Sound::release()
 {
-    if (_playback)
-        _playback->Release(_playback);
+    _ready = false;
+    __sync_synchronize();
+
+    for (VoiceList::iterator it = _voices.begin(); it != _voices.end(); ++it)
+        it->playback->Release(it->playback);
+    _voices.clear();
 
     if (_buffer)
+    {
         _buffer->Release(_buffer);
+        _buffer = NULL;
+    }
 }
 
 } /* namespace ilixi */
@@ -26,6 +26,7 @@
 
 #include <core/SoundDFB.h>
 #include <string>
+#include <vector>
 
 namespace ilixi
 {
@@ -34,6 +35,10 @@ namespace ilixi
  * You should use this class if you want to play short sound effects for
  * user interface events.
  *
+ * Sample is played using a fixed number of voices which share the same buffer. If all
+ * voices are busy when playback is started, the voice which was started first is restarted.
+ * Buffer is not shared between processes, each process loads its own copy of sample.
+ *
  * @warning Only WAVE is supported.
  */
 class Sound
@@ -52,9 +57,11 @@ public:
     Sound();
 
     /*!
-     * Constructor sets filename.
+     * Constructor sets filename and loads sample.
+     *
+     * @param voices maximum number of simultaneous playbacks.
      */
-    Sound(const std::string& filename);
+    Sound(const std::string& filename, unsigned int voices = 1);
 
     /*!
      * Destructor.
@@ -101,18 +108,59 @@ public:
     setDirection(PlaybackDirection direction);
 
     /*!
-     * Sets path to audio file.
+     * Sets path to audio file and loads sample.
      */
     void
     setFileName(const std::string& filename);
 
+    /*!
+     * Sets maximum number of simultaneous playbacks, takes effect once sample is loaded.
+     */
+    void
+    setVoices(unsigned int voices);
+
+    /*!
+     * Returns true if sample is loaded and can be played.
+     */
+    bool
+    ready() const;
+
 private:
+    //! This struct stores a playback of buffer.
+    struct Voice
+    {
+        IFusionSoundPlayback* playback;
+        //! Value of start counter when voice was last started.
+        unsigned int started;
+    };
+
+    typedef std::vector<Voice> VoiceList;
+
     //! This property stores the path for audio file.
     std::string _fileName;
     //! This property stores static sound buffer.
     IFusionSoundBuffer* _buffer;
-    //! This property stores playback interface.
-    IFusionSoundPlayback* _playback;
+    //! This property stores playback voices.
+    VoiceList _voices;
+    //! This property stores the number of voices created when sample is loaded.
+    unsigned int _voiceCount;
+    //! This property is incremented each time a voice is started.
+    unsigned int _counter;
+    //! This property is set once voices are created.
+    volatile bool _ready;
+
+    float _volume;
+    float _pan;
+    float _pitch;
+    PlaybackDirection _direction;
+
+    //! Returns an idle voice or the voice started first.
+    Voice*
+    nextVoice();
+
+    //! Applies stored volume, pan, pitch and direction to voice.
+    void
+    configureVoice(IFusionSoundPlayback* playback);
 
     //! Loads an audio file to a FusionSoundBuffer.
     void
@@ -23,7 +23,9 @@
 
 #include <types/Video.h>
 #include <core/PlatformManager.h>
+#include <core/Engine.h>
 #include <core/Logger.h>
+#include <direct/clock.h>
 #include <sstream>
 #include <iomanip>
 
@@ -32,17 +34,34 @@ namespace ilixi
 
 D_DEBUG_DOMAIN( ILX_VIDEO, "ilixi/types/Video", "Video");
 
-static void
+void
 videoCB(void *cdata)
 {
     Video* v = (Video*) cdata;
-    v->sigFrameUpdated(v->frame());
+    // Decoded frame becomes front buffer, decoder continues with next buffer.
+    v->_frame->Flip(v->_frame, NULL, DSFLIP_NONE);
+    v->_frameTime = direct_clock_get_micros();
+    __sync_fetch_and_add(&v->_framesDecoded, 1);
+    // While a frame is held, main loop is woken up for each frame so hold can expire.
+    if (__sync_bool_compare_and_swap(&v->_framePending, 0, 1) || v->_frameHeld)
+        Engine::instance().wakeUp();
 }
 
 Video::Video(const std::string& path)
         : _provider(NULL),
           _frame(NULL),
-          _buffer(NULL)
+          _buffer(NULL),
+          _framePending(0),
+          _frameHeld(0),
+          _framesDecoded(0),
+          _frameTime(0),
+          _framesHandled(0),
+          _framePeriod(40000),
+          _emitTime(0),
+          _awaitingPresent(false),
+          _framesDropped(0),
+          _framesLate(0),
+          _framesPresented(0)
 {
     ILOG_TRACE_F(ILX_VIDEO);
     load(path);
@@ -51,6 +70,7 @@ Video::Video(const std::string& path)
 Video::~Video()
 {
     ILOG_TRACE_F(ILX_VIDEO);
+    _frameConnection.disconnect();
     if (_provider)
         _provider->Release(_provider);
     if (_frame)
@@ -302,10 +322,21 @@ Video::load(const std::string& path)
              if (PlatformManager::instance().forcedPixelFormat() != DSPF_UNKNOWN)
                 _surfaceDesc.pixelformat = PlatformManager::instance().forcedPixelFormat();
 
-            PlatformManager::instance().getDFB()->CreateSurface(PlatformManager::instance().getDFB(), &_surfaceDesc, &_frame);
+            if (_frame)
+                _frame->Release(_frame);
+            _surfaceDesc.flags = (DFBSurfaceDescriptionFlags) (_surfaceDesc.flags | DSDESC_CAPS);
+            _surfaceDesc.caps = (DFBSurfaceCapabilities) ((_surfaceDesc.caps & ~DSCAPS_DOUBLE) | DSCAPS_TRIPLE);
+            if (PlatformManager::instance().getDFB()->CreateSurface(PlatformManager::instance().getDFB(), &_surfaceDesc, &_frame) != DFB_OK)
+            {
+                ILOG_WARNING(ILX_VIDEO, "Cannot create triple buffered frame, using a single buffer.\n");
+                _surfaceDesc.caps = (DFBSurfaceCapabilities) (_surfaceDesc.caps & ~DSCAPS_TRIPLE);
+                PlatformManager::instance().getDFB()->CreateSurface(PlatformManager::instance().getDFB(), &_surfaceDesc, &_frame);
+            }
         }
 
         _provider->GetCapabilities(_provider, &_providerCaps);
+        _framePeriod = framerate() > 0 ? 1000000 / framerate() : 40000;
+        resetFrameStatistics();
         return true;
     }
 }
@@ -314,7 +345,11 @@ void
 Video::play()
 {
     if (_provider)
+    {
+        if (!_frameConnection.connected())
+            _frameConnection = Engine::instance().sigPerformWork.connect(sigc::mem_fun(this, &Video::presentFrame));
         _provider->PlayTo(_provider, _frame, NULL, videoCB, (void*) this);
+    }
 }
 
 void
@@ -330,8 +365,11 @@ void
 Video::seek(double secs)
 {
     if (_provider && (_providerCaps & DVCAPS_SEEK))
+    {
         _provider->SeekTo(_provider, secs);
-    else
+        _awaitingPresent = false;
+        _frameHeld = 0;
+    } else
         ILOG_ERROR(ILX_VIDEO, "DFBVideoProvider: Seek is not supported!\n");
 }
 
@@ -340,6 +378,10 @@ Video::stop()
 {
     if (_provider)
         _provider->Stop(_provider);
+    _frameConnection.disconnect();
+    _framePending = 0;
+    _frameHeld = 0;
+    _awaitingPresent = false;
 }
 
 void
@@ -388,6 +430,100 @@ Video::setLooping(bool looping)
     }
 }
 
+void
+Video::framePresented()
+{
+    if (_awaitingPresent)
+    {
+        _awaitingPresent = false;
+        ++_framesPresented;
+        if (_frameHeld)
+            Engine::instance().wakeUp();
+    }
+}
+
+void
+Video::frameDiscarded()
+{
+    if (_awaitingPresent)
+    {
+        _awaitingPresent = false;
+        ++_framesDropped;
+        if (_frameHeld)
+            Engine::instance().wakeUp();
+    }
+}
+
+unsigned int
+Video::framesDropped() const
+{
+    return _framesDropped;
+}
+
+unsigned int
+Video::framesLate() const
+{
+    return _framesLate;
+}
+
+unsigned int
+Video::framesPresented() const
+{
+    return _framesPresented;
+}
+
+void
+Video::resetFrameStatistics()
+{
+    _framesHandled = _framesDecoded;
+    _framesDropped = 0;
+    _framesLate = 0;
+    _framesPresented = 0;
+}
+
+void
+Video::presentFrame()
+{
+    if (!_framePending)
+        return;
+
+    long long now = direct_clock_get_micros();
+
+    // Hold frame while previous one is not on screen, unless it is lost.
+    if (_awaitingPresent)
+    {
+        if (now - _emitTime < 2 * _framePeriod)
+        {
+            _frameHeld = 1;
+            return;
+        }
+        // Previous frame is never acknowledged, e.g. widget is not composed.
+        _awaitingPresent = false;
+        ++_framesDropped;
+    }
+    _frameHeld = 0;
+
+    _framePending = 0;
+    __sync_synchronize();
+
+    unsigned int decoded = _framesDecoded;
+    if (decoded - _framesHandled > 1)
+        _framesDropped += decoded - _framesHandled - 1;
+    _framesHandled = decoded;
+
+    // Pending frame is the newest one, showing it late is better than keeping an older frame.
+    long long lateness = now - _frameTime;
+    if (lateness > _framePeriod)
+    {
+        ++_framesLate;
+        ILOG_DEBUG(ILX_VIDEO, " -> Frame %u is %lld us late.\n", decoded, lateness);
+    }
+
+    _emitTime = now;
+    _awaitingPresent = true;
+    sigFrameUpdated(_frame);
+}
+
 std::string
 Video::toString()
 {
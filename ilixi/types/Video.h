@@ -25,16 +25,29 @@
 #define ILIXI_VIDEO_H_
 
 #include <directfb.h>
+#include <sigc++/connection.h>
 #include <sigc++/signal.h>
 #include <string>
 
 namespace ilixi
 {
 //! Loads and plays video using DirectFB video providers.
+/*!
+ * Frames are decoded into a triple buffered surface, so decoder can render next
+ * frame while the latest one is presented. Decoder thread only flips the frame
+ * surface and wakes up main loop, sigFrameUpdated is emitted from main loop at most
+ * once per cycle.
+ *
+ * A new frame is held until the previous one is acknowledged using framePresented(),
+ * so updates do not pile up if main loop is busy. A frame which is not acknowledged
+ * within two frame periods is released, so playback continues if widget is not composed.
+ * Frames which are overwritten by a newer frame or released before they are shown are
+ * dropped, frames shown more than a frame period after decoding are counted as late.
+ */
 class Video : virtual public sigc::trackable
 {
     friend void
-    renderToSurface(void *);
+    videoCB(void *);
 
 public:
 
@@ -182,7 +195,7 @@ public:
     comment() const;
 
     /*!
-     * Returns video frame.
+     * Returns video frame, blitting from it reads the latest decoded frame.
      */
     IDirectFBSurface*
     frame() const;
@@ -252,7 +265,47 @@ public:
     std::string
     toString();
 
-    //! This signal is emitted when a new frame is available.
+    /*!
+     * Acknowledges that the frame passed with sigFrameUpdated is presented.
+     *
+     * Next frame is held until this method is called or a hold period expires.
+     */
+    void
+    framePresented();
+
+    /*!
+     * Releases the frame passed with sigFrameUpdated without presenting it, e.g. if widget is hidden.
+     *
+     * Frame is counted as dropped.
+     */
+    void
+    frameDiscarded();
+
+    /*!
+     * Returns number of frames which are overwritten by a newer frame before they are presented.
+     */
+    unsigned int
+    framesDropped() const;
+
+    /*!
+     * Returns number of frames presented later than a frame period after decoding.
+     */
+    unsigned int
+    framesLate() const;
+
+    /*!
+     * Returns number of presented frames.
+     */
+    unsigned int
+    framesPresented() const;
+
+    /*!
+     * Resets frame counters.
+     */
+    void
+    resetFrameStatistics();
+
+    //! This signal is emitted inside main loop when a new frame is available.
     sigc::signal<void, IDirectFBSurface*> sigFrameUpdated;
 
 private:
@@ -271,6 +324,31 @@ private:
     DFBSurfaceDescription _surfaceDesc;
     //! DFB video provider capabilities.
     DFBVideoProviderCapabilities _providerCaps;
+    //! Set by decoder thread when a frame is ready, cleared by main loop.
+    volatile int _framePending;
+    //! Set while a pending frame is held by main loop.
+    volatile int _frameHeld;
+    //! Number of frames decoded, incremented by decoder thread.
+    volatile unsigned int _framesDecoded;
+    //! Time when latest frame is decoded in microseconds.
+    volatile long long _frameTime;
+    //! Value of _framesDecoded when a frame was last handled.
+    unsigned int _framesHandled;
+    //! Expected interval between frames in microseconds.
+    long long _framePeriod;
+    //! Time when sigFrameUpdated was last emitted.
+    long long _emitTime;
+    //! This flag is set until emitted frame is acknowledged.
+    bool _awaitingPresent;
+    unsigned int _framesDropped;
+    unsigned int _framesLate;
+    unsigned int _framesPresented;
+    //! Connection to Engine's sigPerformWork while playing.
+    sigc::connection _frameConnection;
+
+    //! Emits sigFrameUpdated if a frame is pending, runs inside main loop.
+    void
+    presentFrame();
 };
 
 } /* namespace ilixi */
@@ -70,7 +70,8 @@ Button::click(unsigned int ms, bool playSoundEffect)
         sigStateChanged(this, _state);
     }
     if (playSoundEffect)
-        PlatformManager::instance().playSoundEffect("Click");
+        static const int __clickEffect = PlatformManager::instance().soundEffectID("Click");
+        PlatformManager::instance().playSoundEffect(__clickEffect);
     toggleChecked();
     sigClicked();
 }
@@ -131,7 +132,8 @@ Button::pointerButtonUpEvent(const PointerEvent& event)
     sigReleased();
     if (_buttonFlag & PressedDown)
     {
-        PlatformManager::instance().playSoundEffect("Click");
+        static const int __clickEffect = PlatformManager::instance().soundEffectID("Click");
+        PlatformManager::instance().playSoundEffect(__clickEffect);
         _buttonFlag = (ButtonFlags) (_buttonFlag & ~PressedDown);
         toggleChecked();
         sigClicked();
@@ -248,7 +248,8 @@ DirectionalButton::pointerButtonUpEvent(const PointerEvent& event)
         _buttonFlag = (ButtonFlags) (_buttonFlag & ~PressedDown);
         if (_icon)
             _icon->setState(DefaultState);
-        PlatformManager::instance().playSoundEffect("Click");
+        static const int __clickEffect = PlatformManager::instance().soundEffectID("Click");
+        PlatformManager::instance().playSoundEffect(__clickEffect);
         toggleChecked();
         sigClicked();
     }
@@ -196,6 +196,7 @@ EGLWidget::compose(const PaintEvent& event)
 
     if ((PlatformManager::instance().getWindowSurfaceCaps() & DSCAPS_FLIPPING) && !(surface()->flags() & Surface::ForceSingleSurface)) {
         ILOG_DEBUG(ILX_EGLWIDGET, " -> eglCopyBuffers()\n");
+        surface()->flushRecording();
         eglCopyBuffers(sharedEGLDisplay(), _eglSurface, (EGLNativePixmapType) surface()->dfbSurface());
     }
 }
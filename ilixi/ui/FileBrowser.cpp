@@ -21,17 +21,17 @@
  along with ilixi.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 #include <ui/FileBrowser.h>
 
 #include <ui/HBoxLayout.h>
 #include <ui/Icon.h>
 #include <ui/Label.h>
-#include <ui/ListBox.h>
+#include <ui/ScrollArea.h>
 #include <ui/Spacer.h>
 #include <ui/VBoxLayout.h>
 
 #include <lib/FileSystem.h>
-#include <lib/FileInfo.h>
 
 #include <graphics/Painter.h>
 #include <core/Logger.h>
@@ -44,24 +44,68 @@ namespace ilixi
 D_DEBUG_DOMAIN(ILX_FILEBROWSERITEM, "ilixi/ui/FileBrowserItem", "FileBrowserItem");
 D_DEBUG_DOMAIN(ILX_FILEBROWSER, "ilixi/ui/FileBrowser", "FileBrowser");
 
-bool
-itemsSort(FileBrowserItem* a, FileBrowserItem* b)
+//! Space between rows.
+static const int __rowSpacing = 1;
+
+static bool
+entriesSort(const DirectoryScanner::Entry& a, const DirectoryScanner::Entry& b)
 {
-    if (a->_info->isDir() && !b->_info->isDir())
-        return true;
-    else if (!a->_info->isDir() && b->_info->isDir())
-        return false;
-    return (a->_info->fileName() < b->_info->fileName());
+    if (a.dir != b.dir)
+        return a.dir;
+    return a.name < b.name;
 }
 
-FileBrowserItem::FileBrowserItem(FileInfo* info, FileBrowser* parent)
-        : Widget(parent),
+//! Content of scroll area, its height is the height of all rows.
+class FileBrowser::View : public Widget
+{
+public:
+    View(FileBrowser* owner)
+            : Widget(),
+              _owner(owner)
+    {
+        setInputMethod(PointerPassthrough);
+        setConstraints(ExpandingConstraint, FixedConstraint);
+    }
+
+    virtual
+    ~View()
+    {
+    }
+
+    Size
+    preferredSize() const
+    {
+        int rows = _owner->_entries.size();
+        return Size(std::max(_owner->_path->preferredSize().width(), 1), std::max(rows * (_owner->_rowHeight + __rowSpacing) - __rowSpacing, 1));
+    }
+
+    //! Items are positioned by FileBrowser, their changes do not affect layout of parents.
+    void
+    doLayout()
+    {
+    }
+
+protected:
+    void
+    compose(const PaintEvent& event)
+    {
+    }
+
+private:
+    FileBrowser* _owner;
+};
+
+FileBrowserItem::FileBrowserItem(FileBrowser* parent)
+        : Widget(),
           _owner(parent),
-          _info(info),
-          _icon(NULL),
-          _alternateRow(false),
+          _row(-1),
+          _dir(false),
+          _packedIcon(StyleHint::File),
+          _label(NULL),
           _date(NULL),
-          _size(NULL)
+          _size(NULL),
+          _icon(NULL),
+          _box(NULL)
 {
     ILOG_TRACE_W(ILX_FILEBROWSERITEM);
     setInputMethod(KeyPointer);
@@ -71,36 +115,33 @@ FileBrowserItem::FileBrowserItem(FileInfo* info, FileBrowser* parent)
     _box->setSpacing(10);
     addChild(_box);
 
-    _icon = new Icon(_info->packedIcon());
+    _icon = new Icon(_packedIcon);
     _icon->setSize(32, 32);
     _box->addWidget(_icon);
 
     VBoxLayout* labelBox = new VBoxLayout();
     _box->addWidget(labelBox);
 
-    _label = new Label(_info->baseName());
+    _label = new Label("");
     _label->setConstraints(ExpandingConstraint, MinimumConstraint);
     _label->setSingleLine(true);
     _label->setFont(stylist()->defaultFont(StyleHint::ButtonFont));
     labelBox->addWidget(_label);
 
-    if (_info->isFile())
-    {
-        HBoxLayout* infoBox = new HBoxLayout();
-        labelBox->addWidget(infoBox);
+    HBoxLayout* infoBox = new HBoxLayout();
+    labelBox->addWidget(infoBox);
 
-        _size = new Label(formatSize(_info->size()));
-        _size->setFont(stylist()->defaultFont(StyleHint::MicroFont));
-        _size->setSingleLine(true);
-        infoBox->addWidget(_size);
+    _size = new Label("");
+    _size->setFont(stylist()->defaultFont(StyleHint::MicroFont));
+    _size->setSingleLine(true);
+    infoBox->addWidget(_size);
 
-        infoBox->addWidget(new Spacer(Horizontal));
+    infoBox->addWidget(new Spacer(Horizontal));
 
-        _date = new Label(formatDate(_info->lastModified()));
-        _date->setFont(stylist()->defaultFont(StyleHint::MicroFont));
-        _date->setSingleLine(true);
-        infoBox->addWidget(_date);
-    }
+    _date = new Label("");
+    _date->setFont(stylist()->defaultFont(StyleHint::MicroFont));
+    _date->setSingleLine(true);
+    infoBox->addWidget(_date);
 
     sigGeometryUpdated.connect(sigc::mem_fun(this, &FileBrowserItem::updateFileBrowserItemGeometry));
 }
@@ -108,7 +149,6 @@ FileBrowserItem::FileBrowserItem(FileInfo* info, FileBrowser* parent)
 FileBrowserItem::~FileBrowserItem()
 {
     ILOG_TRACE_W(ILX_FILEBROWSERITEM);
-    delete _info;
 }
 
 Size
@@ -120,14 +160,20 @@ FileBrowserItem::preferredSize() const
     return s;
 }
 
+int
+FileBrowserItem::row() const
+{
+    return _row;
+}
+
 void
 FileBrowserItem::compose(const PaintEvent& event)
 {
     Painter p(this);
     p.begin(event);
-    if (state() & FocusedState)
+    if ((state() & FocusedState) && _row == _owner->_currentRow)
         p.setBrush(stylist()->palette()->focus);
-    else if (_alternateRow)
+    else if (_row % 2 == 0)
         p.setBrush(stylist()->palette()->_default.baseAlt);
     else
         p.setBrush(stylist()->palette()->_default.base);
@@ -138,39 +184,21 @@ FileBrowserItem::compose(const PaintEvent& event)
 void
 FileBrowserItem::pointerButtonDownEvent(const PointerEvent& pointerEvent)
 {
-    std::string s;
-    if (_info->isDir())
-    {
-        s = _info->file();
-        char* buffer = realpath(s.c_str(), NULL);
-        std::string s(buffer);
-        free(buffer);
-        _owner->setPath(s + "/");
-    } else
-        _owner->sigFileSelected(_info->file());
+    activate();
 }
 
 void
 FileBrowserItem::keyUpEvent(const KeyEvent& keyEvent)
 {
     if (keyEvent.keySymbol == DIKS_SPACE)
-    {
-        std::string s;
-        if (_info->isDir())
-        {
-            s = _info->file();
-            char* buffer = realpath(s.c_str(), NULL);
-            std::string s(buffer);
-            free(buffer);
-            _owner->setPath(s + "/");
-        } else
-            _owner->sigFileSelected(_info->file());
-    }
+        activate();
 }
 
 void
 FileBrowserItem::focusInEvent()
 {
+    _owner->_currentRow = _row;
+    _owner->_scrollArea->scrollTo(this);
     update();
 }
 
@@ -180,6 +208,58 @@ FileBrowserItem::focusOutEvent()
     update();
 }
 
+void
+FileBrowserItem::setRow(int row, const DirectoryScanner::Entry& entry)
+{
+    ILOG_TRACE_W(ILX_FILEBROWSERITEM);
+    bool changed = _row != row;
+    _row = row;
+    if (_name != entry.name || _dir != entry.dir)
+    {
+        _name = entry.name;
+        _dir = entry.dir;
+        _label->setText(_name);
+
+        StyleHint::PackedIcon icon = _owner->entryIcon(entry);
+        if (icon != _packedIcon)
+        {
+            _packedIcon = icon;
+            _icon->setImage(stylist()->defaultIcon(icon));
+        }
+        _size->setVisible(!_dir);
+        _date->setVisible(!_dir);
+        changed = true;
+    }
+
+    if (!_dir)
+    {
+        _size->setText(formatSize(entry.size));
+        _date->setText(formatDate(entry.modified));
+    }
+
+    if (changed)
+        update();
+}
+
+void
+FileBrowserItem::activate()
+{
+    if (_row < 0)
+        return;
+
+    std::string file = _owner->_scanner.path() + _name;
+    if (_dir)
+    {
+        char* buffer = realpath(file.c_str(), NULL);
+        if (!buffer)
+            return;
+        std::string s(buffer);
+        free(buffer);
+        _owner->setPath(s + "/");
+    } else
+        _owner->sigFileSelected(file);
+}
+
 void
 FileBrowserItem::updateFileBrowserItemGeometry()
 {
@@ -192,8 +272,10 @@ FileBrowserItem::updateFileBrowserItemGeometry()
 FileBrowser::FileBrowser(const std::string& path, Widget* parent)
         : Widget(parent),
           _showHidden(false),
+          _modified(true),
           _filter(""),
-          _modified(true)
+          _rowHeight(0),
+          _currentRow(-1)
 {
     ILOG_TRACE_W(ILX_FILEBROWSER);
     setInputMethod(PointerPassthrough);
@@ -210,10 +292,23 @@ FileBrowser::FileBrowser(const std::string& path, Widget* parent)
 //    _search = new LineInput("");
 //    _box->addWidget(_search);
 
-    _list = new ListBox();
-    _list->setConstraints(NoConstraint, ExpandingConstraint);
-    _list->setSpacing(1);
-    _box->addWidget(_list);
+    _scrollArea = new ScrollArea();
+    _scrollArea->setConstraints(NoConstraint, ExpandingConstraint);
+    _box->addWidget(_scrollArea);
+
+    _view = new View(this);
+    _scrollArea->setContent(_view);
+    _view->sigGeometryUpdated.connect(sigc::bind(sigc::mem_fun(this, &FileBrowser::updateRows), false));
+
+    // Row height is same for all items, use first item to find it.
+    FileBrowserItem* item = new FileBrowserItem(this);
+    item->setVisible(false);
+    _view->addChild(item);
+    _items.push_back(item);
+    _rowHeight = item->preferredSize().height();
+
+    _scanner.sigEntriesFound.connect(sigc::mem_fun(this, &FileBrowser::addEntries));
+    _scanner.sigScanFinished.connect(sigc::mem_fun(this, &FileBrowser::scanFinished));
 
     setPath(path);
     sigGeometryUpdated.connect(sigc::mem_fun(this, &FileBrowser::updateFileBrowserGeometry));
@@ -222,6 +317,7 @@ FileBrowser::FileBrowser(const std::string& path, Widget* parent)
 FileBrowser::~FileBrowser()
 {
     ILOG_TRACE_W(ILX_FILEBROWSER);
+    _scanner.stop();
 }
 
 Size
@@ -235,6 +331,8 @@ void
 FileBrowser::refresh()
 {
     ILOG_TRACE_W(ILX_FILEBROWSER);
+    _modified = true;
+    setPath(_path->text());
 }
 
 bool
@@ -250,38 +348,17 @@ FileBrowser::setPath(const std::string& path)
     if (_modified || path != _path->text())
     {
         _path->setText(path);
-        std::vector<std::string> files = FileSystem::listDirectory(path);
-        std::vector<FileBrowserItem*> items;
-        for (int i = 0; i < files.size(); ++i)
-        {
-            if (files[i] == ".")
-                continue;
-            else if (!_showHidden && (files[i].length() > 2) && (files[i][0] == '.'))
-                continue;
-
-            FileInfo* info = new FileInfo(path + files[i]);
-            if (info->isDir())
-                items.push_back(new FileBrowserItem(info, this));
-            else if (info->isFile())
-            {
-                if (_filter.empty())
-                    items.push_back(new FileBrowserItem(info, this));
-                else if (!info->suffix().empty() && (_filter.find(info->suffix()) != std::string::npos))
-                    items.push_back(new FileBrowserItem(info, this));
-            }
-        }
-
-        std::sort(items.begin(), items.end(), itemsSort);
-
-        _list->clear();
-        for (int i = 0; i < items.size(); ++i)
+        _entries.clear();
+        _currentRow = -1;
+        for (unsigned int i = 0; i < _items.size(); ++i)
         {
-            if (i % 2 == 0)
-                items[i]->_alternateRow = true;
-            _list->addItem(items[i]);
+            _items[i]->_row = -1;
+            _items[i]->setVisible(false);
         }
-        items[0]->setFocus();
+        _scanner.scan(path, _filter, _showHidden);
         _modified = false;
+        _scrollArea->doLayout();
+        _scrollArea->scrollTo(0, 0);
         update();
     }
 }
@@ -309,6 +386,114 @@ FileBrowser::compose(const PaintEvent& event)
     stylist()->drawHeader(&p, 0, 0, width(), _path->height());
 }
 
+void
+FileBrowser::addEntries(const DirectoryScanner::EntryList& entries)
+{
+    ILOG_TRACE_W(ILX_FILEBROWSER);
+    DirectoryScanner::Entry current;
+    if (_currentRow >= 0)
+        current = _entries[_currentRow];
+
+    size_t mid = _entries.size();
+    _entries.insert(_entries.end(), entries.begin(), entries.end());
+    std::sort(_entries.begin() + mid, _entries.end(), entriesSort);
+    std::inplace_merge(_entries.begin(), _entries.begin() + mid, _entries.end(), entriesSort);
+
+    // rows after inserted entries are shifted.
+    if (_currentRow >= 0)
+        _currentRow = std::lower_bound(_entries.begin(), _entries.end(), current, entriesSort) - _entries.begin();
+
+    _scrollArea->doLayout();
+    updateRows(true);
+    ILOG_DEBUG(ILX_FILEBROWSER, " -> %lu entries\n", (unsigned long) _entries.size());
+}
+
+void
+FileBrowser::scanFinished()
+{
+    ILOG_TRACE_W(ILX_FILEBROWSER);
+    if (_currentRow >= 0 || _entries.empty())
+        return;
+
+    updateRows();
+    FileBrowserItem* first = NULL;
+    for (unsigned int i = 0; i < _items.size(); ++i)
+        if (_items[i]->_row >= 0 && (!first || _items[i]->_row < first->_row))
+            first = _items[i];
+    if (first)
+        first->setFocus();
+}
+
+void
+FileBrowser::updateRows(bool rebind)
+{
+    ILOG_TRACE_W(ILX_FILEBROWSER);
+    if (_rowHeight <= 0)
+        return;
+
+    int pitch = _rowHeight + __rowSpacing;
+    int first = std::max(-_view->y() / pitch, 0);
+    unsigned int count = std::max(_scrollArea->height() / pitch + 2, 1);
+
+    // Rows are assigned to items by modulo, all rows move if count changes.
+    if (count > _items.size())
+    {
+        while (_items.size() < count)
+        {
+            FileBrowserItem* item = new FileBrowserItem(this);
+            item->setVisible(false);
+            _view->addChild(item);
+            _items.push_back(item);
+        }
+        rebind = true;
+    }
+
+    int last = std::min(first + (int) _items.size(), (int) _entries.size());
+    for (unsigned int i = 0; i < _items.size(); ++i)
+    {
+        FileBrowserItem* item = _items[i];
+        int row = first + (i + _items.size() - first % _items.size()) % _items.size();
+        if (row < last)
+        {
+            if (rebind || item->_row != row)
+                item->setRow(row, _entries[row]);
+            item->setGeometry(0, row * pitch, _view->width(), _rowHeight);
+            item->setVisible(true);
+        } else if (item->_row >= 0)
+        {
+            item->_row = -1;
+            item->setVisible(false);
+        }
+    }
+}
+
+StyleHint::PackedIcon
+FileBrowser::entryIcon(const DirectoryScanner::Entry& entry)
+{
+    if (entry.dir)
+        return StyleHint::Folder;
+
+    size_t pos = entry.name.rfind(".");
+    if (pos == std::string::npos || pos == 0)
+        return StyleHint::File;
+    std::string suffix = entry.name.substr(pos + 1);
+
+    IconMap::iterator it = _icons.find(suffix);
+    if (it != _icons.end())
+        return it->second;
+
+    StyleHint::PackedIcon icon = StyleHint::File;
+    std::string type = FileSystem::getMimeType(suffix);
+    if (type.find("audio") != std::string::npos)
+        icon = StyleHint::Music;
+    else if (type.find("video") != std::string::npos)
+        icon = StyleHint::Movie;
+    else if (type.find("image") != std::string::npos)
+        icon = StyleHint::Picture;
+    _icons.insert(std::make_pair(suffix, icon));
+    return icon;
+}
+
 void
 FileBrowser::updateFileBrowserGeometry()
 {
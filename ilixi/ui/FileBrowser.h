@@ -25,21 +25,25 @@
 #define ILIXI_FILEBROWSER_H_
 
 #include <ui/Widget.h>
+#include <lib/DirectoryScanner.h>
+#include <map>
 
 namespace ilixi
 {
 
-class FileInfo;
 class HBoxLayout;
 class Icon;
 class Label;
-class ListBox;
+class ScrollArea;
 class VBoxLayout;
 class FileBrowser;
 
 //! Provides a clickable item for files/directories on a file browser.
 /*!
  * Shows name for both files and directories; but files have extra information like size.
+ *
+ * Items are created by FileBrowser only for visible rows and they are reused for other
+ * rows while list is scrolled.
  */
 class FileBrowserItem : public Widget
 {
@@ -48,7 +52,7 @@ public:
     /*!
      * Constructor
      */
-    FileBrowserItem(FileInfo* info, FileBrowser* parent = 0);
+    FileBrowserItem(FileBrowser* parent = 0);
 
     /*!
      * Destructor
@@ -59,6 +63,12 @@ public:
     Size
     preferredSize() const;
 
+    /*!
+     * Returns the row shown by this item, or -1 if item is not used.
+     */
+    int
+    row() const;
+
 protected:
     void
     compose(const PaintEvent& event);
@@ -78,8 +88,14 @@ protected:
 private:
     //! This is a pointer to parent file browser.
     FileBrowser* _owner;
-    //! This stores information about file
-    FileInfo* _info;
+    //! This property stores the row shown by item.
+    int _row;
+    //! This property stores name of file shown by item.
+    std::string _name;
+    //! This property is true if item shows a directory.
+    bool _dir;
+    //! This property stores the icon shown by item.
+    StyleHint::PackedIcon _packedIcon;
     //! This label shows name of file
     Label* _label;
     //! This label shows modified date of file
@@ -88,21 +104,32 @@ private:
     Label* _size;
     //! This icon is created based on mime type
     Icon* _icon;
-    //! This is used for drawing an alternate background color
-    bool _alternateRow;
     //! This stores all child widgets
     HBoxLayout* _box;
 
+    /*!
+     * Shows entry at given row.
+     */
     void
-    updateFileBrowserItemGeometry();
+    setRow(int row, const DirectoryScanner::Entry& entry);
 
-    friend bool
-    itemsSort(FileBrowserItem* a, FileBrowserItem* b);
+    /*!
+     * Opens directory or selects file.
+     */
+    void
+    activate();
+
+    void
+    updateFileBrowserItemGeometry();
 };
 
 //! Provides a simple widget to list/select files and directories
+/*!
+ * Directories are read in background, entries are shown as they are found.
+ */
 class FileBrowser : public Widget
 {
+    friend class FileBrowserItem;
 public:
     /*!
      *
@@ -131,7 +158,7 @@ public:
     showHidden() const;
 
     /*!
-     * Parses given path for files and directories and updates list using filter.
+     * Starts listing files and directories in given path using filter.
      */
     void
     setPath(const std::string& path);
@@ -164,6 +191,8 @@ protected:
     compose(const PaintEvent& event);
 
 private:
+    class View;
+
     //! This flag stores whether hidden files are shown.
     bool _showHidden;
     //! This flag is set to true if filter and/or path are modified.
@@ -172,10 +201,42 @@ private:
     std::string _filter;
     //! This label shows current path.
     Label* _path;
-    //! This list contains file browser items.
-    ListBox* _list;
+    //! This scroll area contains view.
+    ScrollArea* _scrollArea;
+    //! This widget contains visible items.
+    View* _view;
     //! This layout is used to position path label and list.
     VBoxLayout* _box;
+    //! This scanner lists current path.
+    DirectoryScanner _scanner;
+    //! Sorted entries of current path.
+    DirectoryScanner::EntryList _entries;
+    //! Items for visible rows, row r is shown by item r % size.
+    std::vector<FileBrowserItem*> _items;
+    //! Height of a row.
+    int _rowHeight;
+    //! Row of last focused item or -1.
+    int _currentRow;
+
+    typedef std::map<std::string, StyleHint::PackedIcon> IconMap;
+    //! Icons of file suffixes, mime types are looked up once per suffix.
+    IconMap _icons;
+
+    //! Merges a batch of entries found by scanner.
+    void
+    addEntries(const DirectoryScanner::EntryList& entries);
+
+    //! Focuses first row if no row is focused yet.
+    void
+    scanFinished();
+
+    //! Binds items to rows which are inside visible area of scroll area.
+    void
+    updateRows(bool rebind = false);
+
+    //! Returns icon for given entry.
+    StyleHint::PackedIcon
+    entryIcon(const DirectoryScanner::Entry& entry);
 
     void
     updateFileBrowserGeometry();
@@ -572,6 +572,7 @@ ScrollArea::updateScrollArea()
 void
 ScrollArea::barScrollX(int x)
 {
+    _options |= ContentWasScrolled;
     if (_options & DrawFrame)
         _content->setX(-x + stylist()->defaultParameter(StyleHint::LineInputLeft));
     else
@@ -582,6 +583,7 @@ ScrollArea::barScrollX(int x)
 void
 ScrollArea::barScrollY(int y)
 {
+    _options |= ContentWasScrolled;
     if (_options & DrawFrame)
         _content->setY(-y + stylist()->defaultParameter(StyleHint::LineInputTop));
     else
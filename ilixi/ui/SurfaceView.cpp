@@ -25,6 +25,7 @@
 #include <core/Application.h>
 #include <core/Logger.h>
 #include <core/PlatformManager.h>
+#include <core/Profiler.h>
 #include <ui/WindowWidget.h>
 #include <sys/time.h>
 #include <math.h>
@@ -101,6 +102,12 @@ SurfaceView::isBlendingEnabled() const
     return _svState & SV_CAN_BLEND;
 }
 
+bool
+SurfaceView::isExternalOutput() const
+{
+    return _svState & SV_EXTERNAL;
+}
+
 void
 SurfaceView::setSourceFromSurfaceID(DFBSurfaceID sid)
 {
@@ -205,10 +212,22 @@ SurfaceView::setBlendingEnabled(bool blending)
         _svState = (SurfaceViewFlags) (_svState & ~SV_CAN_BLEND);
 }
 
+void
+SurfaceView::setExternalOutput(bool external)
+{
+    if (external)
+        _svState = (SurfaceViewFlags) (_svState | SV_EXTERNAL);
+    else
+    {
+        _svState = (SurfaceViewFlags) (_svState & ~SV_EXTERNAL);
+        update();
+    }
+}
+
 void
 SurfaceView::paint(const PaintEvent& event)
 {
-    if (visible())
+    if (visible() && !(_svState & SV_EXTERNAL))
     {
         startSurfaceEventListener();
         PaintEvent evt(this, event);
@@ -244,6 +263,7 @@ SurfaceView::renderSource(const PaintEvent& event)
     if (_sourceSurface && (_svState & SV_READY))
     {
         ILOG_TRACE_W(ILX_SURFACEVIEW);
+        ILIXI_PROFILE("SurfaceView::renderSource");
 
         DFBSurfaceID surface_id;
         _sourceSurface->GetID(_sourceSurface, &surface_id);
@@ -259,6 +279,7 @@ SurfaceView::renderSource(const PaintEvent& event)
         }
 #endif
 
+        surface()->flushRecording();
         IDirectFBSurface* dfbSurface = surface()->dfbSurface();
         DFBRegion rs = event.rect.dfbRegion();
         dfbSurface->SetClip(dfbSurface, &rs);
@@ -314,6 +335,7 @@ SurfaceView::renderSource(const PaintEvent& event)
             }
             dfbSurface->StretchBlit(dfbSurface, _sourceSurface, NULL, &rect);
         }
+        surface()->dfbState()->invalidate();
         _updateFlipCount = true;
         sigSourceUpdated();
     }
@@ -339,11 +361,15 @@ SurfaceView::onSourceUpdate(const DFBSurfaceEvent& event)
         ILOG_DEBUG(ILX_SURFACEVIEW, " -> _updateFlipCount to %d\n", _flipCount);
     }
 
-    if (visible())
+    if (visible() && (_svState & SV_EXTERNAL))
+    {
+        _sourceSurface->FrameAck(_sourceSurface, _flipCount);
+        ILOG_DEBUG(ILX_SURFACEVIEW, " -> FrameAck for frame %d (external)\n", _flipCount);
+        return true;
+    } else if (visible())
     {
-        Rectangle lRect = mapFromSurface(Rectangle(event.update.x1 / hScale(), event.update.y1 / vScale(), (event.update.x2 - event.update.x1) / hScale() + 1, (event.update.y2 - event.update.y1) / vScale() + 1));
-
 #ifdef ILIXI_STEREO_OUTPUT
+        Rectangle lRect = mapFromSurface(Rectangle(event.update.x1 / hScale(), event.update.y1 / vScale(), (event.update.x2 - event.update.x1) / hScale() + 1, (event.update.y2 - event.update.y1) / vScale() + 1));
         Rectangle rRect = mapFromSurface(
                 Rectangle(event.update_right.x1 / hScale(), event.update_right.y1 / vScale(),
                         (event.update_right.x2 - event.update_right.x1) / hScale() + 1,
@@ -351,7 +377,12 @@ SurfaceView::onSourceUpdate(const DFBSurfaceEvent& event)
 
         update(PaintEvent(lRect, rRect));
 #else
-        update(PaintEvent(lRect));
+        const SourceDamage& damage = sourceDamage();
+        for (int i = 0; i < damage.count; ++i)
+        {
+            const DFBRegion& r = damage.regions[i];
+            update(PaintEvent(mapFromSurface(Rectangle(r.x1 / hScale(), r.y1 / vScale(), (r.x2 - r.x1) / hScale() + 1, (r.y2 - r.y1) / vScale() + 1))));
+        }
 #endif
         _sourceSurface->FrameAck(_sourceSurface, _flipCount);
         ILOG_DEBUG(ILX_SURFACEVIEW, " -> FrameAck for frame %d\n", _flipCount);
@@ -75,6 +75,12 @@ public:
     bool
     isBlendingEnabled() const;
 
+    /*!
+     * Returns true if source surface is presented outside of this view.
+     */
+    bool
+    isExternalOutput() const;
+
     /*!
      * Sets source surface using given id.
      */
@@ -99,6 +105,14 @@ public:
     void
     setBlendingEnabled(bool blending);
 
+    /*!
+     * Sets whether source surface is presented outside of this view, e.g. on a hardware layer.
+     *
+     * Source updates are acknowledged but do not cause a repaint while set.
+     */
+    void
+    setExternalOutput(bool external);
+
     void
     paint(const PaintEvent& event);
 
@@ -147,7 +161,8 @@ private:
         SV_NONE = 0x00,         //!< Default state.
         SV_READY = 0x01,        //!< Source surface is ready.
         SV_CAN_BLEND = 0x02,    //!< Source surface can be blended.
-        SV_SHOULD_BLOCK = 0x04 //!< Source surface will not be allowed to flip if surface view is hidden.
+        SV_SHOULD_BLOCK = 0x04, //!< Source surface will not be allowed to flip if surface view is hidden.
+        SV_EXTERNAL = 0x08      //!< Source surface is presented outside of surface view.
     };
 
     //! This property stores the scale ratio in horizontal direction.
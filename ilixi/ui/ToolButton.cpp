@@ -298,7 +298,8 @@ ToolButton::pointerButtonUpEvent(const PointerEvent& event)
             _icon->setState(DefaultState);
             _icon->setY(_icon->y() - 1);
         }
-        PlatformManager::instance().playSoundEffect("Click");
+        static const int __clickEffect = PlatformManager::instance().soundEffectID("Click");
+        PlatformManager::instance().playSoundEffect(__clickEffect);
         toggleChecked();
         sigClicked();
     }
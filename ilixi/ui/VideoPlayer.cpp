@@ -27,6 +27,7 @@
 #include <ui/ToolButton.h>
 #include <ui/Slider.h>
 #include <graphics/Painter.h>
+#include <graphics/Surface.h>
 #include <core/PlatformManager.h>
 #include <core/Logger.h>
 #include <lib/Util.h>
@@ -143,8 +144,8 @@ VideoPlayer::VideoPlayer(Widget* parent)
         : Widget(parent),
           _video(NULL),
           _videoLSurface(NULL),
-          _videoSurface(NULL),
           _videoFrame(NULL),
+          _frameUnpresented(false),
           _flags(AutoHideControls)
 {
     ILOG_TRACE_W(ILX_VIDEOPLAYER);
@@ -161,8 +162,6 @@ VideoPlayer::~VideoPlayer()
 {
     ILOG_TRACE_W(ILX_VIDEOPLAYER);
     delete _video;
-    if (_videoSurface)
-        _videoSurface->Release(_videoSurface);
     if (_videoLSurface)
         _videoLSurface->Release(_videoLSurface);
 }
@@ -186,6 +185,7 @@ VideoPlayer::load(const std::string& path)
     ILOG_DEBUG(ILX_VIDEOPLAYER, " -> path: %s\n", path.c_str());
     delete _video;
     _videoFrame = NULL;
+    _frameUnpresented = false;
     _video = new Video(path);
     if (_video->status() != DVSTATE_UNKNOWN)
     {
@@ -197,6 +197,7 @@ VideoPlayer::load(const std::string& path)
         _controls->_dur->setText(toHMS(_video->length()));
         _controls->_position->setRange(0, _video->length() / 100);
         _controls->_position->setValue(0, false);
+        updateVideoRect();
         playVideo();
         return true;
     } else
@@ -207,6 +208,22 @@ VideoPlayer::load(const std::string& path)
     return false;
 }
 
+unsigned int
+VideoPlayer::framesDropped() const
+{
+    if (_video)
+        return _video->framesDropped();
+    return 0;
+}
+
+unsigned int
+VideoPlayer::framesLate() const
+{
+    if (_video)
+        return _video->framesLate();
+    return 0;
+}
+
 std::string
 VideoPlayer::info() const
 {
@@ -227,6 +244,7 @@ VideoPlayer::setAutoHideControls(bool autoHide)
         _flags = (VideoPlayerFlags) (_flags & ~AutoHideControls);
         _controls->show();
     }
+    updateVideoRect();
 }
 
 void
@@ -236,6 +254,8 @@ VideoPlayer::setKeepAspectRatio(bool keepAspect)
         _flags = (VideoPlayerFlags) (_flags | KeepAspectRatio);
     else
         _flags = (VideoPlayerFlags) (_flags & ~KeepAspectRatio);
+    updateVideoRect();
+    update();
 }
 
 void
@@ -277,33 +297,40 @@ VideoPlayer::compose(const PaintEvent& event)
         surface()->clear();
     else if (_videoFrame)
     {
-        DFBRectangle r = frameGeometry().dfbRect();
-
-        if (!(_flags & AutoHideControls))
-            r.h -= _controls->height();
-
-        if (_flags & KeepAspectRatio)
+        // Frame updates only repaint video area, bars are drawn if they are exposed.
+        if (!mapFromSurface(_videoRect).contains(event.rect, true))
         {
-            int h = r.w / _video->aspect();
-            r.y += (r.h - h) * 0.5f;
-            if (h < r.h)
-            {
-                Painter p(this);
-                p.begin(event);
-                p.fillRectangle(0, 0, width(), r.h);
-                p.fillRectangle(0, r.y + r.h, width(), height() - (r.y + r.h));
-                p.end();
-            }
-            r.h = h;
+            int h = (_flags & AutoHideControls) ? height() : height() - _controls->height();
+            Painter p(this);
+            p.begin(event);
+            p.fillRectangle(0, 0, width(), _videoRect.y());
+            p.fillRectangle(0, _videoRect.bottom(), width(), h - _videoRect.bottom());
+            p.fillRectangle(0, _videoRect.y(), _videoRect.x(), _videoRect.height());
+            p.fillRectangle(_videoRect.right(), _videoRect.y(), width() - _videoRect.right(), _videoRect.height());
+            p.end();
         }
 
-        surface()->dfbSurface()->GetSubSurface(surface()->dfbSurface(), &r, &_videoSurface);
-
-        if (_videoSurface)
+        surface()->flushRecording();
+        IDirectFBSurface* dfbSurface = surface()->dfbSurface();
+        // Event is in window coordinates, same as shared surfaces, see Painter::begin().
+        DFBRectangle dest = _videoRect.dfbRect();
+        DFBRegion clip;
+        if (surface()->flags() & Surface::SharedSurface)
         {
-            _videoSurface->StretchBlit(_videoSurface, _videoFrame, NULL, NULL);
-            _videoSurface->Release(_videoSurface);
-            _videoSurface = NULL;
+            dest.x += absX();
+            dest.y += absY();
+            clip = event.rect.dfbRegion();
+        } else
+            clip = Rectangle(event.rect.x() - absX(), event.rect.y() - absY(), event.rect.width(), event.rect.height()).dfbRegion();
+        dfbSurface->SetClip(dfbSurface, &clip);
+        dfbSurface->SetBlittingFlags(dfbSurface, DSBLIT_NOFX);
+        dfbSurface->StretchBlit(dfbSurface, _videoFrame, NULL, &dest);
+        surface()->dfbState()->invalidate();
+        // Repaints of bars or controls do not present a new frame.
+        if (_frameUnpresented)
+        {
+            _frameUnpresented = false;
+            _video->framePresented();
         }
     } else
     {
@@ -326,6 +353,7 @@ VideoPlayer::playVideo()
         _controls->_play->setIcon(StyleHint::Pause, Size(16, 16));
         _controls->_play->update();
         _controls->_position->setEnabled();
+        _video->resetFrameStatistics();
         _video->play();
         break;
 
@@ -387,14 +415,25 @@ VideoPlayer::updateVideo(IDirectFBSurface* frame)
     if (_video->status() != DVSTATE_PLAY)
     {
         _videoFrame = NULL;
+        _video->framePresented();
         _controls->_play->setIcon(StyleHint::Play, Size(16, 16));
         _controls->_play->update();
     }
 
-    if (_videoLSurface)
+    if (_videoFrame && !visible())
+    {
+        // Hidden player does not compose, do not hold decoder.
+        _frameUnpresented = false;
+        _video->frameDiscarded();
+    } else if (_videoLSurface)
     {
         _videoLSurface->StretchBlit(_videoLSurface, _videoFrame, NULL, NULL);
         _videoLSurface->Flip(_videoLSurface, NULL, DSFLIP_ONSYNC);
+        _video->framePresented();
+    } else if (_videoFrame)
+    {
+        _frameUnpresented = true;
+        update(PaintEvent(mapFromSurface(_videoRect)));
     } else
         update();
 }
@@ -405,6 +444,7 @@ VideoPlayer::updateVPGeometry()
     ILOG_TRACE_W(ILX_VIDEOPLAYER);
     Size s1 = _controls->preferredSize();
     _controls->setGeometry(0, height() - s1.height() - 10, width(), s1.height() + 10);
+    updateVideoRect();
 
     if (PlatformManager::instance().appOptions() & OptExclusive)
     {
@@ -442,4 +482,28 @@ VideoPlayer::updateVPGeometry()
     }
 }
 
+void
+VideoPlayer::updateVideoRect()
+{
+    Rectangle r(0, 0, width(), height());
+    if (!(_flags & AutoHideControls))
+        r.setHeight(r.height() - _controls->height());
+
+    if ((_flags & KeepAspectRatio) && _video && _video->aspect() > 0)
+    {
+        int h = r.width() / _video->aspect();
+        if (h <= r.height())
+        {
+            r.setY((r.height() - h) / 2);
+            r.setHeight(h);
+        } else
+        {
+            int w = r.height() * _video->aspect();
+            r.setX((r.width() - w) / 2);
+            r.setWidth(w);
+        }
+    }
+    _videoRect = r;
+}
+
 } /* namespace ilixi */
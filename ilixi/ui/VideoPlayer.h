@@ -128,6 +128,18 @@ public:
     std::string
     info() const;
 
+    /*!
+     * Returns number of video frames which are not presented since playback started.
+     */
+    unsigned int
+    framesDropped() const;
+
+    /*!
+     * Returns number of video frames presented later than a frame period.
+     */
+    unsigned int
+    framesLate() const;
+
     /*!
      * Sets whether controls are always shown.
      *
@@ -162,10 +174,12 @@ private:
     Video* _video;
     //! Layer sub-surface used for blitting video frames, only available in exclusive mode.
     IDirectFBSurface* _videoLSurface;
-    //! Direct sub-surface used for blitting video frames.
-    IDirectFBSurface* _videoSurface;
+    //! Area of video inside widget, excluding letterbox bars.
+    Rectangle _videoRect;
     //! Current video frame.
     IDirectFBSurface* _videoFrame;
+    //! This flag is set if current video frame is not yet blitted, see Video::framePresented().
+    bool _frameUnpresented;
     //! Video player controls.
     VideoPlayerControls* _controls;
     //! Timer used for toggling controls.
@@ -196,6 +210,10 @@ private:
     //! Updates widget geometry.
     void
     updateVPGeometry();
+
+    //! Computes area of video using widget size, controls and aspect ratio.
+    void
+    updateVideoRect();
 };
 
 } /* namespace ilixi */
@@ -24,6 +24,7 @@
 #include <algorithm>
 #include <core/EventFilter.h>
 #include <core/Logger.h>
+#include <core/Profiler.h>
 #include <core/Window.h>
 #include <ui/Widget.h>
 #include <ui/WindowWidget.h>
@@ -615,10 +616,14 @@ Widget::paint(const PaintEvent& event)
     if (visible())
     {
         ILOG_TRACE_W(ILX_WIDGET);
+        ILIXI_PROFILE_TYPE("paint", *this);
         PaintEvent evt(this, event);
         if (evt.isValid())
         {
-            compose(evt);
+            {
+                ILIXI_PROFILE_TYPE("compose", *this);
+                compose(evt);
+            }
             paintChildren(evt);
         }
     }
@@ -55,6 +55,7 @@ class Widget : virtual public sigc::trackable
     friend class ScrollArea; // Blit
     friend class PaintEvent;
     friend class AppBase; // UniversalEvents
+    friend class ILXCompositor; // Occlusion culling
 
     friend bool
     compareZ(Widget* first, Widget* second);
@@ -27,6 +27,7 @@
 #include <core/EventFilter.h>
 #include <core/Logger.h>
 #include <core/PlatformManager.h>
+#include <core/Profiler.h>
 
 namespace ilixi
 {
@@ -131,6 +132,8 @@ WindowWidget::paint(const PaintEvent& event)
             sem_wait(&_updates._updateReady);
 
             _surface->updateSurface(event);
+            // Window surface is shared with AppWindow, do not rely on state of previous frame.
+            _surface->dfbState()->invalidate();
 
 #ifdef ILIXI_STEREO_OUTPUT
             PaintEvent evt(_frameGeometry.intersected(_updates._updateRegion), _frameGeometry.intersected(_updates._updateRegionRight));
@@ -173,16 +176,29 @@ WindowWidget::paint(const PaintEvent& event)
 
                 surface()->flipStereo(evt.rect, evt.right);
 #else
-                surface()->clip(evt.rect);
-                if (_backgroundFlags & BGFClear)
-                    surface()->clear(evt.rect);
+                if (PlatformManager::instance().useBatchDrawing())
+                    surface()->beginRecording();
 
-                if (_backgroundFlags & BGFFill)
-                    compose(evt);
-
-                paintChildren(evt);
+                if (_updates._damage.count > 1)
+                {
+                    // Paint each dirty rectangle separately, area between them is left untouched.
+                    for (unsigned int i = 0; i < _updates._damage.count; ++i)
+                    {
+                        PaintEvent damageEvent(evt.rect.intersected(_updates._damage.rects[i]));
+                        if (!damageEvent.isValid())
+                            continue;
+                        ILOG_DEBUG(ILX_WINDOWWIDGET_UPDATES, " -> Damage(%d, %d, %d, %d)\n", damageEvent.rect.x(), damageEvent.rect.y(), damageEvent.rect.width(), damageEvent.rect.height());
+#if ILIXI_HAS_GETFRAMETIME
+                        damageEvent.micros = evt.micros;
+#endif
+                        paintDamage(damageEvent);
+                    }
+                } else
+                    paintDamage(evt);
 
+                surface()->endRecording();
                 surface()->flip(evt.rect);
+                ILOG_DEBUG(ILX_WINDOWWIDGET_UPDATES, " -> state changes issued: %u skipped: %u\n", SurfaceState::issued(), SurfaceState::skipped());
 #endif
             }
             sem_post(&_updates._paintReady);
@@ -190,6 +206,19 @@ WindowWidget::paint(const PaintEvent& event)
     }
 }
 
+void
+WindowWidget::paintDamage(const PaintEvent& event)
+{
+    surface()->clip(event.rect);
+    if (_backgroundFlags & BGFClear)
+        surface()->clear(event.rect);
+
+    if (_backgroundFlags & BGFFill)
+        compose(event);
+
+    paintChildren(event);
+}
+
 void
 WindowWidget::repaint(const PaintEvent& event)
 {
@@ -199,6 +228,8 @@ WindowWidget::repaint(const PaintEvent& event)
         _updates._updateRegion = event.rect;
 #ifdef ILIXI_STEREO_OUTPUT
         _updates._updateRegionRight = event.right;
+#else
+        _updates._damage.reset();
 #endif
         sem_post(&_updates._updateReady);
         paint(PaintEvent(_updates._updateRegion, PaintEvent::BothEyes));
@@ -589,8 +620,10 @@ WindowWidget::updateWindow()
         return;
     }
     ILOG_TRACE_W(ILX_WINDOWWIDGET_UPDATES);
+    ILIXI_PROFILE("WindowWidget::updateWindow");
 
     Rectangle updateTemp = _updates._updateQueue.rect;
+    UpdateQueue damage = _updates._updateQueue;
 
     _updates._updateQueue.reset();
 
@@ -616,9 +649,14 @@ WindowWidget::updateWindow()
         }
 #else
         if (PlatformManager::instance().useFSU(_window->_layerName))
+        {
             _updates._updateRegion = frameGeometry();
-        else
+            _updates._damage.reset();
+        } else
+        {
             _updates._updateRegion = updateTemp;
+            _updates._damage = damage;
+        }
 #endif
 
         sem_post(&_updates._updateReady);
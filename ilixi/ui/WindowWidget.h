@@ -198,15 +198,32 @@ private:
      */
     EventManager* _eventManager;
 
+    //! Stores dirty rectangles of a window until next update.
+    /*!
+     * Rectangles which overlap, or whose union does not cost more pixels than
+     * painting them separately, are merged. If the queue is full, new rectangle
+     * is merged with the rectangle whose area grows least.
+     */
     class UpdateQueue
     {
     public:
+        enum
+        {
+            MaxRects = 8
+        };
+
+        //! Bounding rectangle of all dirty rectangles.
         Rectangle rect;
+        //! Dirty rectangles.
+        Rectangle rects[MaxRects];
+        //! Number of dirty rectangles.
+        unsigned int count;
 
         bool valid;
 
         UpdateQueue()
-                : valid(false)
+                : count(0),
+                  valid(false)
         {
         }
 
@@ -221,13 +238,69 @@ private:
                 rect = ext;
                 valid = true;
             }
+
+            if (!ext.isValid())
+                return;
+
+            unsigned int best = 0;
+            long long bestCost = -1;
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                if (rects[i].contains(ext, true))
+                    return;
+
+                long long cost = area(rects[i].united(ext)) - area(rects[i]) - area(ext);
+                if (cost <= 0 || rects[i].intersects(ext))
+                {
+                    merge(i, ext);
+                    return;
+                }
+
+                if (bestCost < 0 || cost < bestCost)
+                {
+                    best = i;
+                    bestCost = cost;
+                }
+            }
+
+            if (count < MaxRects)
+                rects[count++] = ext;
+            else
+                merge(best, ext);
         }
 
         void
         reset()
         {
+            count = 0;
             valid = false;
         }
+
+    private:
+        static long long
+        area(const Rectangle& r)
+        {
+            return (long long) r.width() * r.height();
+        }
+
+        //! Unites ext with rectangle at index and folds in rectangles it now overlaps.
+        void
+        merge(unsigned int index, const Rectangle& ext)
+        {
+            rects[index].unite(ext);
+            for (unsigned int i = 0; i < count;)
+            {
+                if (i != index && rects[i].intersects(rects[index]))
+                {
+                    rects[index].unite(rects[i]);
+                    rects[i] = rects[--count];
+                    if (index == count)
+                        index = i;
+                    i = 0;
+                } else
+                    ++i;
+            }
+        }
     };
 
     //! Stores window's dirty regions and a region for update.
@@ -242,15 +315,23 @@ private:
         UpdateQueue _updateQueueRight;
 #endif
         UpdateQueue _updateQueue;
+        //! Dirty rectangles painted by next paint(), empty if only _updateRegion is painted.
+        UpdateQueue _damage;
     } _updates;
 
     /*!
      * Creates a united rectangle from a list of dirty regions and
-     * performs a paint operation on this united rectangle.
+     * performs a paint operation on dirty regions inside this united rectangle.
      */
     virtual void
     updateWindow();
 
+    /*!
+     * Clears and paints window background and children inside given rectangle.
+     */
+    void
+    paintDamage(const PaintEvent& event);
+
     IDirectFBSurface*
     windowSurface();
 